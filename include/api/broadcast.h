@@ -10,6 +10,12 @@ void api_broadcast_readings(void);
 void api_broadcast_storage_status(void);
 void api_broadcast_network_status(void);
 
+// Sends out control events (edges, denials, orgasms, mode changes) published since the last call.
+void api_broadcast_events(void);
+
+// Sends out spectrum analyses published since the last call, to clients streaming them.
+void api_broadcast_spectrum(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,115 @@
+#ifndef __ArousalDetector_h
+#define __ArousalDetector_h
+
+#include "config.h"
+#include "util/fixed.h"
+#include "util/sliding_minmax.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct detector_params;
+
+/**
+ * Per-instance state for the arousal detectors. Each detector owns one member; add yours here.
+ */
+typedef union arousal_detector_state {
+    struct {
+        uint16_t last_value;
+        uint16_t peak_start;
+        sliding_minmax_t floor;
+    } peak;
+
+    struct {
+        long last_value;
+        long rise;
+        long credited;
+    } derivative;
+
+    struct {
+        long baseline;
+        bool primed;
+    } baseline;
+} arousal_detector_state_t;
+
+typedef void (*arousal_detector_start_func_t)(arousal_detector_state_t* state);
+typedef void (*arousal_detector_rebase_func_t)(arousal_detector_state_t* state, long pressure);
+typedef uint16_t (*arousal_detector_tick_func_t)(
+    arousal_detector_state_t* state,
+    const struct detector_params* params,
+    long pressure,
+    uint16_t arousal
+);
+
+/**
+ * Arousal detectors turn the (optionally averaged) pressure stream into an arousal value. Each
+ * tick receives the current pressure and the previous arousal, and returns the new arousal,
+ * including any decay. Detectors keep their state in the arousal_detector_state_t they are handed,
+ * and must reset it in start(), which is called whenever the detector is (re)selected.
+ *
+ * rebase() is called when the pressure scale changes under the detector, as on a sensor
+ * sensitivity change. It restarts whatever the detector measures from at `pressure`, so the step
+ * isn't read as a contraction, but leaves arousal alone.
+ */
+typedef struct arousal_detector {
+    const char* name;
+    arousal_detector_start_func_t start;
+    arousal_detector_rebase_func_t rebase;
+    arousal_detector_tick_func_t tick;
+} arousal_detector_t;
+
+/**
+ * CPU cost of a detector's tick(), in perf counter cycles. See util/perf_counter.h.
+ */
+typedef struct arousal_detector_stats {
+    uint32_t calls;
+    uint32_t last_cycles;
+    uint32_t max_cycles;
+    uint64_t total_cycles;
+} arousal_detector_stats_t;
+
+/**
+ * @brief Looks up the detector for an arousal_detector_mode_t.
+ *
+ * @return Detector, or the peak detector for unknown modes.
+ */
+const arousal_detector_t* arousal_detector_get(arousal_detector_mode_t mode);
+
+/**
+ * @brief Runs a detector tick and accounts its cost.
+ */
+uint16_t arousal_detector_tick(
+    const arousal_detector_t* detector,
+    arousal_detector_state_t* state,
+    const struct detector_params* params,
+    long pressure,
+    uint16_t arousal
+);
+
+/**
+ * @brief Returns the cost counters for a detector. Counters accumulate for every detector that has
+ * been ticked, so they can be compared after switching modes.
+ */
+const arousal_detector_stats_t* arousal_detector_get_stats(arousal_detector_mode_t mode);
+void arousal_detector_reset_stats(void);
+
+// Per-tick decay applied to stale arousal by the detectors.
+#define AROUSAL_DECAY Q16(0.99)
+
+static inline uint16_t arousal_detector_decay(uint16_t arousal) {
+    return q16_scale(arousal, AROUSAL_DECAY);
+}
+
+// Arousal Detectors
+extern const arousal_detector_t PeakDetector;
+extern const arousal_detector_t DerivativeDetector;
+extern const arousal_detector_t BaselineDetector;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -40,11 +40,29 @@ extern "C" {
 #define SCREEN_DIM_SECONDS_HELP _HELPSTR("Time, in seconds, before the screen dims. 0 to disable.")
 #define SCREEN_TIMEOUT_SECONDS_HELP _HELPSTR("Time, in seconds, before the screen turns off. 0 to disable.")
 #define PRESSURE_SMOOTHING_HELP _HELPSTR("Number of samples to take an average of. Higher results in lag and lower resolution!")
+#define PRESSURE_FILTER_HELP _HELPSTR("Filter used to smooth pressure over `pressure_smoothing` samples: average, EMA, median or lowpass. Median rejects short spikes, lowpass has the steepest rolloff above its cutoff.")
 #define CLASSIC_SERIAL_HELP _HELPSTR("Output continuous stream of arousal data over serial for backwards compatibility with other software.")
 #define SENSITIVITY_THRESHOLD_HELP _HELPSTR("The arousal threshold for orgasm detection. Lower values stop sooner.")
+#define AUTO_THRESHOLD_HELP _HELPSTR("Adjust `sensitivity_threshold` during automatic sessions to keep denials about `auto_threshold_interval_s` apart. The adjusted threshold is only saved at the end of a session, and only once it has settled.")
+#define AUTO_THRESHOLD_INTERVAL_S_HELP _HELPSTR("Target time (s) between denials for `auto_threshold`, including `edge_delay`.")
 #define UPDATE_FREQUENCY_HZ_HELP _HELPSTR("Update frequency for pressure readings and arousal steps. Higher = crash your serial monitor.")
+#define PRESSURE_SAMPLE_RATE_HZ_HELP _HELPSTR("Raw pressure sampling rate, e.g. 500-1000. Readings are filtered and decimated down to the update frequency. 0 to take one reading per update.")
 #define SENSOR_SENSITIVITY_HELP _HELPSTR("Analog pressure prescaling. Please see instruction manual.")
+#define AUTO_SENSOR_SENSITIVITY_HELP _HELPSTR("Adjust `sensor_sensitivity` automatically, keeping the median pressure around 65% and 95% of readings under 90%, so peaks are never clipped. Checked every 30 seconds.")
+#define SENSOR_FAULT_REJECTION_HELP _HELPSTR("Screen pressure for sensor faults before the arousal detector. Single spikes are replaced by the recent median, and while the sensor reads at 0 or full scale, or spikes repeatedly, arousal is held until it has read clean for a second.")
 #define USE_AVERAGE_VALUES_HELP _HELPSTR("Use average values when calculating arousal. This smooths noisy data.")
+#define AROUSAL_DETECTOR_HELP _HELPSTR("Algorithm used to turn pressure readings into arousal.")
+#define USE_SHADOW_DETECTOR_HELP _HELPSTR("Run a second detector alongside the live one. It never controls the motor, but its would-be denials are logged next to the live ones.")
+#define SHADOW_AROUSAL_DETECTOR_HELP _HELPSTR("Algorithm used by the shadow detector.")
+#define SHADOW_SENSITIVITY_THRESHOLD_HELP _HELPSTR("The arousal threshold for the shadow detector. 0 to use sensitivity_threshold.")
+#define EDGE_PREDICTION_MS_HELP _HELPSTR("Stop stimulation when arousal is projected to cross sensitivity_threshold within this many ms, judging by how fast recent peaks are adding to it. 0 to only stop once it has crossed.")
+#define BASELINE_WINDOW_MS_HELP _HELPSTR("Window (ms) for rolling pressure baselines. Peaks are measured from no lower than the lowest pressure in the window, and the clench threshold falls back to the highest pressure in the window instead of decaying a little every tick, which keeps both steady when the sensor drifts. 0 to use the classic rules. Up to 256 updates long.")
+#define SPECTRUM_ANALYSIS_HELP _HELPSTR("Run a spectrum analysis over the last 5 seconds of pressure twice a second, estimating contraction rate and band levels for the `spectrum` websocket stream.")
+#define RECORDING_FORMAT_HELP _HELPSTR("File format for recordings: csv, or binary for files about a tenth the size that take a fraction of the time to write. Convert binary recordings to CSV with tools/host record2csv.")
+#define BLACK_BOX_SECONDS_HELP _HELPSTR("Keep the last this many seconds of full-rate samples in RAM, and write them to the SD card as blackbox-*.eom when an orgasm or sensor fault is detected, or on request. Takes 35 KB of RAM plus about 12 KB per minute at 50 Hz. 0 to turn off.")
+#define RECORDING_SEGMENT_MINUTES_HELP _HELPSTR("Start a new file for a recording every this many minutes, so a long session is split into segments. 0 for one file per recording.")
+#define RECORDING_SEGMENT_KB_HELP _HELPSTR("Start a new file for a recording once the current one reaches about this many KB. 0 for no limit.")
+#define RECORDING_RETENTION_MB_HELP _HELPSTR("Delete the oldest recordings and black box dumps once together they take more than this many MB of the SD card. 0 to keep everything.")
 #define VIBRATION_MODE_HELP _HELPSTR("Vibration Mode for main vibrator control.")
 #define USE_POST_ORGASM_HELP _HELPSTR("Use post-orgasm torture mode and functionality.")
 #define CLENCH_PRESSURE_SENSITIVITY_HELP _HELPSTR("Minimum additional Arousal level to detect clench. See manual.")
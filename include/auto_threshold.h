@@ -0,0 +1,76 @@
+#ifndef __auto_threshold_h
+#define __auto_threshold_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Gains on the log of target over measured denial interval. Time to edge grows about in proportion
+// to the threshold, so the integral gain is roughly the fraction of the error corrected per
+// denial.
+#define AUTO_THRESHOLD_KP 0.10f
+#define AUTO_THRESHOLD_KI 0.25f
+
+// Largest change per update, as a fraction of the threshold.
+#define AUTO_THRESHOLD_MAX_STEP 0.10f
+
+// Intervals within this factor of the target count toward settling.
+#define AUTO_THRESHOLD_TOLERANCE 1.25f
+
+// Consecutive intervals within tolerance before the threshold counts as settled.
+#define AUTO_THRESHOLD_SETTLED 3
+
+// The threshold stays within this factor of where the session started.
+#define AUTO_THRESHOLD_RANGE 2.0f
+
+/**
+ * PI controller nudging the arousal threshold toward a target interval between denials. It runs
+ * in velocity form, changing the threshold by a bounded fraction at each denial, so clamping the
+ * step or the range never winds anything up.
+ *
+ * Going a whole target interval past the expected one without a denial also counts as an
+ * interval, so a threshold set too high still comes down.
+ */
+typedef struct auto_threshold {
+    float threshold;
+    float min;
+    float max;
+    unsigned long target_ms;
+
+    unsigned long last_ms;
+    float last_error;
+    uint16_t updates;
+    uint8_t settled;
+} auto_threshold_t;
+
+void auto_threshold_init(
+    auto_threshold_t* control, int threshold, unsigned long target_ms, unsigned long now_ms
+);
+
+/**
+ * @brief Runs the controller for one control update.
+ *
+ * @param denied Whether the motor was stopped on an edge this update.
+ * @return The threshold to use.
+ */
+int auto_threshold_update(auto_threshold_t* control, bool denied, unsigned long now_ms);
+
+static inline int auto_threshold_get(const auto_threshold_t* control) {
+    return (int)(control->threshold + 0.5f);
+}
+
+/**
+ * @return Whether the last AUTO_THRESHOLD_SETTLED intervals were all close enough to the target.
+ */
+static inline bool auto_threshold_settled(const auto_threshold_t* control) {
+    return control->settled >= AUTO_THRESHOLD_SETTLED;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
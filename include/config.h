@@ -23,6 +23,12 @@ static const char* CONFIG_FILENAME = "/config.json";
 #define EOM_BETA 1
 #define I18N_USE_CJSON_DICT 1
 
+// Storage class for Config and the control loop state. Empty on device; the host tools define it
+// as _Thread_local so each worker thread replays with its own detector.
+#ifndef CONTROL_LOCAL
+#define CONTROL_LOCAL
+#endif
+
 // System Defaults
 static const char* REMOTE_UPDATE_URL =
     "http://us-central1-maustec-io.cloudfunctions.net/gh-release-embedded-bridge";
@@ -34,6 +40,27 @@ enum vibration_mode { RampStop = 1, Depletion = 2, Enhancement = 3, Pattern = 4,
 
 typedef enum vibration_mode vibration_mode_t;
 
+// Arousal Detectors
+// See arousal_detector.h for more.
+
+enum arousal_detector_mode { DetectPeaks = 0, DetectDerivative = 1, DetectBaseline = 2 };
+
+typedef enum arousal_detector_mode arousal_detector_mode_t;
+
+// Pressure Filters
+// See util/filter.h for more.
+
+enum pressure_filter { FilterAverage = 0, FilterEMA = 1, FilterMedian = 2, FilterLowpass = 3 };
+
+typedef enum pressure_filter pressure_filter_t;
+
+// Recording Formats
+// See session_record.h for more.
+
+enum recording_format { RecordCSV = 0, RecordBinary = 1 };
+
+typedef enum recording_format recording_format_t;
+
 /**
  * Main Configuration Struct!
  *
@@ -104,16 +131,70 @@ struct config {
     int minimum_on_time;
     // Number of samples to take an average of. Higher results in lag and lower resolution!
     uint8_t pressure_smoothing;
+    // Filter used to smooth pressure over `pressure_smoothing` samples: average, EMA, median or
+    // lowpass. Median rejects short spikes, lowpass has the steepest rolloff above its cutoff.
+    int pressure_filter;
     // The arousal threshold for orgasm detection. Lower = sooner cutoff.
     int sensitivity_threshold;
+    // Adjust `sensitivity_threshold` during automatic sessions to keep denials about
+    // `auto_threshold_interval_s` apart. The adjusted threshold is only saved at the end of a
+    // session, and only once it has settled.
+    bool auto_threshold;
+    // Target time (s) between denials for `auto_threshold`, including `edge_delay`.
+    int auto_threshold_interval_s;
     // The time it takes for the motor to reach `motor_max_speed` in auto ramp mode.
     int motor_ramp_time_s;
     // Update frequency for pressure readings and arousal steps. Higher = crash your serial monitor.
     int update_frequency_hz;
+    // Raw pressure sampling rate. When higher than update_frequency_hz, readings are oversampled
+    // and decimated down to the update rate. 0 to take one reading per update.
+    int pressure_sample_rate_hz;
     // Analog pressure prescaling. Adjust this until the pressure is ~60-70%
     uint8_t sensor_sensitivity;
+    // Adjust `sensor_sensitivity` automatically, keeping the median pressure around 65% and 95% of
+    // readings under 90%, so peaks are never clipped. Checked every 30 seconds.
+    bool auto_sensor_sensitivity;
+    // Screen pressure for sensor faults before the arousal detector. Single spikes are replaced
+    // by the recent median, and while the sensor reads at 0 or full scale, or spikes repeatedly,
+    // arousal is held until it has read clean for a second.
+    bool sensor_fault_rejection;
     // Use average values when calculating arousal. This smooths noisy data.
     bool use_average_values;
+    // Algorithm used to turn pressure readings into arousal.
+    int arousal_detector;
+    // Run a second detector alongside the live one, which only logs what it would have done.
+    bool use_shadow_detector;
+    // Algorithm used by the shadow detector.
+    int shadow_arousal_detector;
+    // The arousal threshold for the shadow detector. 0 to use sensitivity_threshold.
+    int shadow_sensitivity_threshold;
+    // Stop stimulation when arousal is projected to cross sensitivity_threshold within this many
+    // ms, judging by how fast recent peaks are adding to it. 0 to only stop once it has crossed.
+    int edge_prediction_ms;
+    // Window (ms) for rolling pressure baselines. Peaks are measured from no lower than the lowest
+    // pressure in the window, and the clench threshold falls back to the highest pressure in the
+    // window instead of decaying a little every tick, which keeps both steady when the sensor
+    // drifts. 0 to use the classic rules. Up to 256 updates long.
+    int baseline_window_ms;
+    // Run a spectrum analysis over the last 5 seconds of pressure twice a second, estimating
+    // contraction rate and band levels for the `spectrum` websocket stream.
+    bool spectrum_analysis;
+    // File format for recordings: csv, or binary for files about a tenth the size that take a
+    // fraction of the time to write. Convert binary recordings to CSV with tools/host record2csv.
+    int recording_format;
+    // Keep the last this many seconds of full-rate samples in RAM, and write them to the SD card
+    // as blackbox-*.eom when an orgasm or sensor fault is detected, or on request. Takes 35 KB of
+    // RAM plus about 12 KB per minute at 50 Hz. 0 to turn off.
+    int black_box_seconds;
+    // Start a new file for a recording every this many minutes, so a long session is split into
+    // segments. 0 for one file per recording.
+    int recording_segment_minutes;
+    // Start a new file for a recording once the current one reaches about this many KB. 0 for no
+    // limit.
+    int recording_segment_kb;
+    // Delete the oldest recordings and black box dumps once together they take more than this
+    // many MB of the SD card. 0 to keep everything.
+    int recording_retention_mb;
 
     //= Vibration Output Mode
 
@@ -149,7 +230,7 @@ struct config {
 
 typedef struct config config_t;
 
-extern config_t Config;
+extern CONTROL_LOCAL config_t Config;
 
 // These operations work on the global Config struct. For more lower-level access, check out
 // the ones presented on config_defs.h
@@ -0,0 +1,141 @@
+#ifndef __detector_h
+#define __detector_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "arousal_detector.h"
+#include "config.h"
+#include "util/filter.h"
+#include "util/sliding_minmax.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Per-tick decay of the clench threshold while not clenching.
+#define CLENCH_THRESHOLD_DECAY Q16(0.99)
+
+// Clench threshold a fresh detector starts from.
+#define CLENCH_THRESHOLD_INITIAL 4096
+
+/**
+ * Tuning for one detector instance. The live detector copies these from Config every tick, other
+ * instances (shadow detectors, host parameter sweeps) carry their own.
+ */
+typedef struct detector_params {
+    arousal_detector_mode_t mode;
+    int sensitivity_threshold;
+    int update_frequency_hz;
+    bool use_average_values;
+    uint8_t pressure_smoothing;
+    pressure_filter_t pressure_filter;
+    int baseline_window_ms;
+    int clench_pressure_sensitivity;
+    int clench_threshold_2_orgasm;
+    int max_clench_duration;
+    bool clench_detector_in_edging;
+} detector_params_t;
+
+/**
+ * One arousal and clench detector: pressure in, arousal and orgasm detection out. Holds no
+ * references to globals, so any number can run side by side, and owns nothing that needs freeing.
+ */
+typedef struct detector {
+    detector_params_t params;
+    const arousal_detector_t* arousal_detector;
+    arousal_detector_state_t arousal_state;
+    filter_t pressure_filter;
+    sliding_minmax_t clench_max;
+    uint16_t arousal;
+
+    //  Post Orgasm Clench variables
+    long clench_pressure_threshold; //  4096?
+    int clench_duration;
+    bool detected_orgasm;
+} detector_t;
+
+void detector_params_from_config(detector_params_t* params);
+
+void detector_init(detector_t* detector, const detector_params_t* params);
+
+/**
+ * @return The filter_type_t a pressure_filter_t setting selects.
+ */
+filter_type_t detector_filter_type(pressure_filter_t filter);
+
+/**
+ * @return baseline_window_ms in ticks, or 0 when rolling baselines are off.
+ */
+uint16_t detector_baseline_window(const detector_params_t* params);
+
+/**
+ * @brief Runs one tick of smoothing, arousal detection and clench detection.
+ *
+ * @param pressure Raw pressure reading.
+ * @param permit_orgasm Whether a detected clench may count as an orgasm right now.
+ */
+void detector_update(detector_t* detector, uint16_t pressure, bool permit_orgasm);
+
+/**
+ * @brief Starts smoothing, arousal detection and the clench threshold over from `pressure`,
+ * keeping arousal. For when the pressure scale changes, e.g. with the sensor sensitivity, so the
+ * step isn't read as a contraction.
+ */
+void detector_rebase(detector_t* detector, uint16_t pressure);
+
+uint16_t detector_get_average_pressure(const detector_t* detector);
+
+/**
+ * Struct-of-arrays variant of detector_t for running many peak detectors in lock step. Every
+ * array has `count` entries, one lane per detector, and the update loop is written branch-free so
+ * the compiler can vectorize it. Lanes always use the peak detector with the classic baselines
+ * (baseline_window_ms 0) and take the pressure the detector checks directly, i.e. already
+ * smoothed if wanted. With that input, a lane's arousal and clench state match a detector_t with
+ * the same params tick for tick.
+ */
+typedef struct detector_batch {
+    size_t count;
+
+    // Params, pre-divided so the update loop has no divisions
+    int32_t* peak_threshold;
+    int32_t* clench_pressure_sensitivity;
+    int32_t* clench_pressure_half_sensitivity;
+    int32_t* clench_threshold_2_orgasm;
+    int32_t* clench_edging_threshold;
+    int32_t* max_clench_duration;
+
+    // State
+    int32_t* last_value;
+    int32_t* peak_start;
+    int32_t* arousal;
+    int32_t* clench_pressure_threshold;
+    int32_t* clench_duration;
+    int32_t* detected_orgasm;
+} detector_batch_t;
+
+/**
+ * @brief Allocates a batch of `count` lanes, all using the params currently in Config.
+ *
+ * @return 0 on success, -1 on allocation failure.
+ */
+int detector_batch_init(detector_batch_t* batch, size_t count);
+void detector_batch_free(detector_batch_t* batch);
+
+void detector_batch_set_params(
+    detector_batch_t* batch, size_t lane, const detector_params_t* params
+);
+void detector_batch_reset(detector_batch_t* batch);
+
+/**
+ * @brief Ticks every lane once.
+ *
+ * @param pressure One pressure per lane.
+ */
+void detector_batch_update(detector_batch_t* batch, const uint16_t* pressure, bool permit_orgasm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
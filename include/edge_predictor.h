@@ -0,0 +1,62 @@
+#ifndef __edge_predictor_h
+#define __edge_predictor_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Peaks the trajectory is fitted through.
+#define EDGE_PREDICTOR_PEAKS 3
+
+// Milliseconds after which a peak is forgotten.
+#define EDGE_PREDICTOR_WINDOW_MS 5000
+
+/**
+ * Projects where arousal is heading from the peaks the detector added to it. Arousal decays
+ * between peaks, so the trajectory is taken through the arousal right after each of the last
+ * EDGE_PREDICTOR_PEAKS peaks: a quadratic through those points gives the slope and curvature of the
+ * climb. Only a run of rising peaks is projected, so a single large peak predicts nothing.
+ */
+typedef struct edge_predictor {
+    uint32_t updates;
+    uint16_t last_arousal;
+    bool rising;
+
+    // Oldest first
+    uint8_t peak_count;
+    uint32_t peak_update[EDGE_PREDICTOR_PEAKS];
+    uint16_t peak_arousal[EDGE_PREDICTOR_PEAKS];
+} edge_predictor_t;
+
+void edge_predictor_init(edge_predictor_t* predictor);
+
+/**
+ * @return EDGE_PREDICTOR_WINDOW_MS in updates at update_frequency_hz.
+ */
+uint32_t edge_predictor_window(int update_frequency_hz);
+
+/**
+ * @brief Records the arousal of the update that just ran.
+ *
+ * @param update_frequency_hz Rate updates run at, to forget peaks by time rather than count.
+ */
+void edge_predictor_update(edge_predictor_t* predictor, uint16_t arousal, int update_frequency_hz);
+
+/**
+ * @brief Projects the peak trajectory forward from the current update.
+ *
+ * @param threshold Arousal to predict a crossing of.
+ * @param horizon Number of updates to look ahead.
+ * @return Updates until the trajectory is projected to exceed threshold, or -1 if it isn't within
+ * the horizon.
+ */
+int edge_predictor_updates_to_edge(const edge_predictor_t* predictor, int threshold, int horizon);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -6,6 +6,9 @@ extern "C" {
 #endif
 
 #include "config.h"
+#include "session_stats.h"
+#include "spectrum.h"
+#include "util/ring_buffer.h"
 #include "vibration_mode_controller.h"
 #include <stddef.h>
 #include <stdint.h>
@@ -24,8 +27,169 @@ typedef enum oc_bool {
     ocTRUE,
 } oc_bool_t;
 
+// Number of control updates kept for sample consumers, about 2.5s at 50Hz.
+#define ORGASM_CONTROL_SAMPLE_RING_SIZE 128
+
+// Snapshot of one control update, published to the sample ring.
+typedef struct orgasm_control_sample {
+    unsigned long millis;
+    uint16_t pressure;
+    uint16_t avg_pressure;
+    uint16_t arousal;
+    uint8_t motor_speed;
+    uint8_t denial_count;
+    int sensitivity_threshold;
+    long clench_pressure_threshold;
+    int clench_duration;
+    uint16_t shadow_arousal;
+    uint8_t shadow_denial_count;
+} orgasm_control_sample_t;
+
+// Full-rate pressure readings kept when oversampling, about 0.5s at 1kHz.
+#define ORGASM_CONTROL_RAW_RING_SIZE 512
+
+typedef struct orgasm_control_raw_sample {
+    unsigned long millis;
+    uint32_t seq;
+    uint16_t pressure;
+} orgasm_control_raw_sample_t;
+
+// Number of per-tick events (update, arousal, motor speed) kept for subscribers. Nearly every
+// tick has all three, so this is under a second; a subscriber that misses some only misses
+// values the sample ring and the next events carry anyway.
+#define ORGASM_CONTROL_EVENT_RING_SIZE 128
+
+// Number of state changes (every other event type) kept for subscribers. These only come a few a
+// minute, and are kept in a ring of their own so the per-tick events can't push them out while a
+// subscriber is stalled.
+#define ORGASM_CONTROL_STATE_EVENT_RING_SIZE 64
+
+// This enum has an associated strings array in orgasm_control.c
+typedef enum orgasm_control_event_type {
+    OC_EVENT_UPDATE,            // Something shown on screen changed this tick.
+    OC_EVENT_AROUSAL,           // value: new arousal
+    OC_EVENT_MOTOR_SPEED,       // value: new motor speed, 0..255
+    OC_EVENT_EDGE,              // Arousal crossed sensitivity_threshold. value: arousal
+    OC_EVENT_DENIAL,            // The motor was stopped on an edge. value: denial count
+    OC_EVENT_ORGASM,            // The clench detector detected an orgasm.
+    OC_EVENT_MODE_CHANGE,       // value: new orgasm_output_mode_t
+    OC_EVENT_SENSOR_FAULT,      // value: new sensor_fault_t, SENSOR_FAULT_NONE once clean again
+    OC_EVENT_DETECTOR_CHANGE,   // value: arousal_detector_mode_t now running
+    OC_EVENT_THRESHOLD_SETTLED, // auto_threshold settled. value: new sensitivity_threshold
+    OC_EVENT_SHADOW_DENIAL,     // The shadow detector would have denied. value: its denial count
+    OC_EVENT_SHADOW_ORGASM,     // The shadow detector detected an orgasm.
+    _OC_EVENT_MAX,
+} orgasm_control_event_type_t;
+
+typedef struct orgasm_control_event {
+    unsigned long millis;
+    orgasm_control_event_type_t type;
+    int32_t value;
+} orgasm_control_event_t;
+
+// A subscriber's place in both event rings.
+typedef struct orgasm_control_subscriber {
+    ring_buffer_reader_t ticks;
+    ring_buffer_reader_t changes;
+} orgasm_control_subscriber_t;
+
+// Snapshots are taken when the mode, denial count, menu lock or post-orgasm state changes, but at
+// most this often, so a stuck input can't wear out flash.
+#define ORGASM_CONTROL_SNAPSHOT_MIN_INTERVAL_MS 5000UL
+
+// While a session runs, arousal and timers are snapshotted at least this often.
+#define ORGASM_CONTROL_SNAPSHOT_INTERVAL_MS 60000UL
+
+// Bump when orgasm_control_snapshot_t changes, so stale snapshots are not restored.
+#define ORGASM_CONTROL_SNAPSHOT_VERSION 1
+
+/**
+ * Everything needed to carry a session across a reboot. Timestamps are on the control clock at
+ * `tick_ms`; they are shifted onto the new clock when restored, so the time the device was off
+ * doesn't count. A snapshot in manual mode means there is no session to resume.
+ */
+typedef struct orgasm_control_snapshot {
+    uint16_t version;
+    uint8_t output_mode;
+    uint8_t denial_count;
+    uint8_t menu_is_locked;
+    uint16_t arousal;
+    uint32_t tick_ms;
+    int32_t motor_speed;
+    uint32_t motor_start_ms;
+    uint32_t motor_stop_ms;
+    uint32_t random_additional_delay;
+    int32_t clench_pressure_threshold;
+    int32_t clench_duration;
+    uint32_t auto_edging_start_ms;
+    uint32_t post_orgasm_start_ms;
+    int32_t post_orgasm_duration_seconds;
+    session_stats_t session;
+} orgasm_control_snapshot_t;
+
+// Millisecond clock driving the control loop. Defaults to esp_timer; replace it to run the control
+// path under a simulated clock. Pass NULL to restore the default.
+typedef unsigned long (*orgasm_control_clock_t)(void);
+
+// Resets the control state, then resumes the session saved by control_snapshot if there is one.
 void orgasm_control_init(void);
-void orgasm_control_tick(void);
+void orgasm_control_set_clock(orgasm_control_clock_t clock);
+
+// Takes one pressure reading, at orgasm_control_get_sample_rate_hz(). Every reading is passed
+// through the decimation filter when oversampling, and a control update runs whenever the filter
+// produces an output. Called by the control task on every timer period.
+void orgasm_control_sample(void);
+int orgasm_control_get_sample_rate_hz(void);
+// Readings per control update, 1 unless oversampling.
+uint8_t orgasm_control_get_decimation_ratio(void);
+
+// Runs one control update now, with a fresh reading or with a given pressure.
+void orgasm_control_update(void);
+void orgasm_control_update_pressure(uint16_t pressure);
+
+// Sample stream. Consumers attach their own ring_buffer_reader_t to the ring; the control task
+// never waits on them.
+ring_buffer_t* orgasm_control_get_sample_ring(void);
+ring_buffer_t* orgasm_control_get_raw_ring(void);
+oc_bool_t orgasm_control_get_latest_sample(orgasm_control_sample_t* sample);
+
+// Event stream. Events are published by the control task at the end of each update; every
+// subscriber sees every event, at its own pace. State changes come before any per-tick events
+// still waiting, and each kind is in order. A subscriber that falls more than a ring's size behind
+// skips ahead in that ring, see ring_buffer_reader_t.
+void orgasm_control_subscribe(orgasm_control_subscriber_t* subscriber);
+oc_bool_t orgasm_control_next_event(
+    orgasm_control_subscriber_t* subscriber, orgasm_control_event_t* event
+);
+const char* orgasm_control_event_type_str(orgasm_control_event_type_t type);
+
+// Number of spectrum frames kept for subscribers, a couple of seconds of analyses.
+#define ORGASM_CONTROL_SPECTRUM_RING_SIZE 4
+
+// Spectrum stream, published while Config.spectrum_analysis is on. Like the event stream, every
+// subscriber reads at its own pace and skips ahead when it falls behind.
+void orgasm_control_subscribe_spectrum(ring_buffer_reader_t* subscriber);
+oc_bool_t orgasm_control_next_spectrum(
+    ring_buffer_reader_t* subscriber, spectrum_frame_t* frame
+);
+
+// Finished sessions waiting for the logger to append them to ORGASM_CONTROL_SESSION_LOG.
+#define ORGASM_CONTROL_SESSION_RING_SIZE 4
+#define ORGASM_CONTROL_SESSION_LOG "/sessions.jsonl"
+
+/**
+ * @brief Gets the newest snapshot published by the control task since the last call. Only one
+ * task may take snapshots.
+ *
+ * @return ocFALSE if no snapshot is due.
+ */
+oc_bool_t orgasm_control_take_snapshot(orgasm_control_snapshot_t* snapshot);
+
+// Session stats. A session runs from automatic control being chosen until the mode is back to
+// manual, through any orgasm and post-orgasm phase. Its stats stay readable after it ends, until
+// the next one starts.
+const session_stats_t* orgasm_control_get_session_stats(void);
+oc_bool_t orgasm_control_in_session(void);
 
 // Fetch Data
 uint16_t orgasm_control_getArousal(void);
@@ -34,9 +198,10 @@ uint8_t orgasm_control_getMotorSpeed(void);
 float orgasm_control_getMotorSpeedPercent(void);
 uint16_t orgasm_control_getLastPressure(void);
 uint16_t orgasm_control_getAveragePressure(void);
-oc_bool_t orgasm_control_updated(void);
-void orgasm_control_clear_update_flag(void);
 int orgasm_control_getDenialCount(void);
+
+// The setters below are safe from any task. They queue the change for the control task, which
+// applies it at the start of its next update.
 void orgasm_control_increment_arousal_threshold(int threshold);
 void orgasm_control_set_arousal_threshold(int threshold);
 int orgasm_control_get_arousal_threshold(void);
@@ -52,10 +217,10 @@ void orgasm_control_set_output_mode(orgasm_output_mode_t mode);
 const char *orgasm_control_get_output_mode_str(void);
 orgasm_output_mode_t orgasm_control_str_to_output_mode(const char* str);
 
-// Recording Control
-void orgasm_control_startRecording(void);
-void orgasm_control_stopRecording(void);
-oc_bool_t orgasm_control_isRecording(void);
+// Writes classic serial output and the event and session logs, and carries out the config saves
+// and sensor sensitivity changes the control task asked for. Call from a low-priority task.
+// Recordings are in system/recorder.h.
+void orgasm_control_log_tick(void);
 
 // Twitch Detect (In wrong place for 60hz)
 void orgasm_control_twitchDetect(void);
@@ -0,0 +1,57 @@
+#ifndef __pressure_calibration_h
+#define __pressure_calibration_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "util/quantile.h"
+#include <stdint.h>
+
+// Pressure is watched this long between sensitivity adjustments, and each adjustment starts the
+// estimates over, since it moves the whole signal.
+#define PRESSURE_CALIBRATION_PERIOD_MS 30000
+
+// Where the median and the 95th percentile should sit, as fractions of full scale. The manual's
+// advice is to keep pressure around 60-70%; the upper target leaves headroom above the usual
+// contractions, so peaks aren't flattened by clipping.
+#define PRESSURE_CALIBRATION_MEDIAN 0.65f
+#define PRESSURE_CALIBRATION_HIGH 0.90f
+
+// Largest change per adjustment, and the error below which nothing changes.
+#define PRESSURE_CALIBRATION_MAX_STEP 0.10f
+#define PRESSURE_CALIBRATION_DEADBAND 0.05f
+
+/**
+ * Estimates the 5th, 50th and 95th percentile of pressure in constant memory, and suggests the
+ * sensor sensitivity that would bring them into range. Sensitivity is treated as a gain that
+ * pressure scales with. The 5th percentile doesn't steer the suggestion; it's logged with the
+ * others after each period, to show how much of the range the signal spans.
+ */
+typedef struct pressure_calibration {
+    quantile_t low;
+    quantile_t median;
+    quantile_t high;
+} pressure_calibration_t;
+
+void pressure_calibration_init(pressure_calibration_t* cal);
+void pressure_calibration_add(pressure_calibration_t* cal, uint16_t pressure);
+
+/**
+ * @brief Suggests a sensitivity from the pressure seen since init. The median is brought toward
+ * PRESSURE_CALIBRATION_MEDIAN, unless that would push the 95th percentile past
+ * PRESSURE_CALIBRATION_HIGH. A flat signal near 0, e.g. with the sensor unplugged, changes nothing.
+ *
+ * @param sensitivity Sensitivity the pressure was read at.
+ * @param full_scale Highest pressure reading.
+ * @return The sensitivity to use, which may be the current one.
+ */
+uint8_t pressure_calibration_suggest(
+    const pressure_calibration_t* cal, uint8_t sensitivity, uint16_t full_scale
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef __sensor_guard_h
+#define __sensor_guard_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Previous readings each new one is tested against.
+#define SENSOR_GUARD_WINDOW 7
+
+// A reading is an impulse when it is further from the window's median than this many standard
+// deviations, estimated from the median absolute deviation, and than SENSOR_GUARD_MIN_DEVIATION of
+// full scale. The floor keeps a quiet baseline from turning the first samples of every
+// contraction into impulses.
+#define SENSOR_GUARD_HAMPEL_K 3.0f
+#define SENSOR_GUARD_MIN_DEVIATION 0.125f
+
+// Readings within this fraction of 0 or full scale for SENSOR_GUARD_RAIL_MS mean the sensor is
+// unplugged or saturated.
+#define SENSOR_GUARD_RAIL 0.01f
+#define SENSOR_GUARD_RAIL_MS 200
+
+// More impulses than this in the last 32 readings mean a noisy connection.
+#define SENSOR_GUARD_NOISE_IMPULSES 3
+
+// A fault clears after this long without any of the above.
+#define SENSOR_GUARD_CLEAR_MS 1000
+
+// This enum has an associated strings array in sensor_guard.c
+typedef enum sensor_fault {
+    SENSOR_FAULT_NONE,
+    SENSOR_FAULT_DISCONNECTED,
+    SENSOR_FAULT_SATURATED,
+    SENSOR_FAULT_NOISY,
+    _SENSOR_FAULT_MAX,
+} sensor_fault_t;
+
+/**
+ * Screens pressure readings before they reach the detector. Single impulses are replaced by the
+ * median of the readings before them, a Hampel filter that only looks back, so a real step comes
+ * through SENSOR_GUARD_WINDOW / 2 readings late. Runs at either rail and bursts of impulses raise
+ * a fault. Readings at a rail, and every reading while a fault is raised, are replaced by the last
+ * good one.
+ */
+typedef struct sensor_guard {
+    uint16_t window[SENSOR_GUARD_WINDOW];
+    uint8_t index;
+    uint8_t count;
+
+    // Bit per reading, newest in bit 0, set for impulses.
+    uint32_t impulses;
+    uint32_t impulse_count;
+
+    int sample_rate_hz;
+    uint16_t min_deviation;
+    uint16_t low_rail;
+    uint16_t high_rail;
+    uint16_t low_run;
+    uint16_t high_run;
+    uint16_t rail_samples;
+
+    uint16_t clean_run;
+    uint16_t clear_samples;
+
+    uint16_t held;
+    sensor_fault_t fault;
+} sensor_guard_t;
+
+/**
+ * @param full_scale Highest pressure reading.
+ * @param sample_rate_hz Rate readings arrive at, to turn the time limits into readings.
+ */
+void sensor_guard_init(sensor_guard_t* guard, uint16_t full_scale, int sample_rate_hz);
+
+/**
+ * @brief Screens a reading.
+ *
+ * @return The reading, the median standing in for an impulse, or the last good reading at a rail
+ * or while guard->fault is set.
+ */
+uint16_t sensor_guard_update(sensor_guard_t* guard, uint16_t pressure);
+
+const char* sensor_fault_str(sensor_fault_t fault);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
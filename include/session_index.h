@@ -0,0 +1,71 @@
+#ifndef __session_index_h
+#define __session_index_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Seek index for a recording, log-<date>.idx next to its segments.
+ *
+ * A recording is split into segments when `recording_segment_minutes` or `recording_segment_kb`
+ * is set: log-<date>.csv, then log-<date>_2.csv, log-<date>_3.csv and so on (.eom for binary
+ * recordings, -raw.csv after the segment name for the full-rate pressure). The index is a header
+ * followed by an entry every SESSION_INDEX_INTERVAL_MS, in millis order, each pointing at the row
+ * or block holding that moment, and each segment starts with one. Entries are fixed-size, so a
+ * reader finds any moment by binary search and then reads only the one segment, from that offset
+ * on.
+ *
+ * All fields are little-endian, as in session_record.h.
+ */
+#define SESSION_INDEX_VERSION 1
+#define SESSION_INDEX_INTERVAL_MS 10000
+
+// "EOMI" read in file order.
+#define SESSION_INDEX_MAGIC 0x494d4f45
+
+typedef struct __attribute__((packed)) session_index_header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t entry_size;
+    // Wall clock time at millis 0, as in session_record_file_header_t.
+    uint32_t start_time;
+    // recording_format_t of the segments.
+    uint8_t format;
+    uint8_t reserved[3];
+} session_index_header_t;
+
+typedef struct __attribute__((packed)) session_index_entry {
+    uint32_t millis;
+    // Segment number, 0 for the first.
+    uint16_t segment;
+    uint16_t reserved;
+    // Byte offset in the segment of the CSV row, or binary block, holding the sample at millis.
+    uint32_t offset;
+} session_index_entry_t;
+
+/**
+ * @brief Formats the path of a segment: base, then _<n + 1> past the first, then suffix.
+ *
+ * @param suffix ".csv", ".eom" or "-raw.csv".
+ * @return As snprintf().
+ */
+int session_index_segment_path(
+    char* buf, size_t len, const char* base, uint16_t segment, const char* suffix
+);
+
+/**
+ * @brief Finds the last entry at or before millis, by binary search.
+ *
+ * @return Index of the entry, or 0 if millis is before them all.
+ */
+size_t session_index_find(const session_index_entry_t* entries, size_t count, uint32_t millis);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,245 @@
+#ifndef __session_record_h
+#define __session_record_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Binary session recordings, an alternative to log-*.csv.
+ *
+ * A recording is a sequence of SESSION_RECORD_BLOCK_SIZE blocks, so every write is one whole,
+ * aligned block. The first block is a file header carrying the config the session ran with. Each
+ * following block starts with the full values of its first sample, so any block decodes on its
+ * own, and blocks being a fixed size makes the file its own index: block n is at n + 1 blocks
+ * from the start, and a reader finds a moment by binary search over the blocks' first millis.
+ *
+ * After the first sample, a block holds the rest column by column. Each column is stored as the
+ * differences between samples, or as the differences of those, as zigzag varints, optionally as
+ * runs of equal values, whichever is smallest for that column in that block. Thresholds then take
+ * a few bytes a block, a steady update rate none at all, and pressure a byte or two a sample.
+ *
+ * Version 1 blocks, fixed-size records of differences, are still read.
+ *
+ * All fields are little-endian, as both the ESP32 and the host tools are.
+ */
+#define SESSION_RECORD_BLOCK_SIZE 4096
+#define SESSION_RECORD_VERSION 2
+
+// "EOMR", "EOMB" and "EOMC" read in file order.
+#define SESSION_RECORD_FILE_MAGIC 0x524d4f45
+#define SESSION_RECORD_BLOCK_MAGIC 0x424d4f45
+#define SESSION_RECORD_COLUMN_BLOCK_MAGIC 0x434d4f45
+
+// Most samples in a block, which the encoder holds in RAM until the block is complete, 35 KB.
+// Recorded sessions fit around 1250 samples in a block, so this rarely ends one early.
+#define SESSION_RECORD_MAX_SAMPLES 1280
+
+struct orgasm_control_sample;
+
+typedef struct __attribute__((packed)) session_record_file_header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t block_size;
+    // Wall clock time at millis 0, in seconds since the epoch, or 0 if unknown. For recordings
+    // that's when the recording started.
+    uint32_t start_time;
+    uint16_t update_frequency_hz;
+    // Length of the config JSON following the header, not counting its NUL.
+    uint16_t config_length;
+} session_record_file_header_t;
+
+// Full values of a sample, at the start of every block.
+typedef struct __attribute__((packed)) session_record_keyframe {
+    uint32_t millis;
+    uint16_t pressure;
+    uint16_t avg_pressure;
+    uint16_t arousal;
+    uint8_t motor_speed;
+    uint8_t denial_count;
+    int32_t sensitivity_threshold;
+    int32_t clench_pressure_threshold;
+    int32_t clench_duration;
+    uint16_t shadow_arousal;
+    uint8_t shadow_denial_count;
+    uint8_t reserved;
+} session_record_keyframe_t;
+
+typedef struct __attribute__((packed)) session_record_block_header {
+    uint32_t magic;
+    // Position of the block in the recording, counting from 0 after the file header.
+    uint32_t seq;
+    // Samples in the block, including the keyframe.
+    uint16_t count;
+    // Size of a version 1 record, 0 in column blocks.
+    uint16_t record_size;
+    session_record_keyframe_t first;
+} session_record_block_header_t;
+
+// Columns of a column block, in order, one per keyframe field but reserved. Each is a header
+// followed by length bytes of values for samples 1 to count - 1.
+typedef enum session_record_column_id {
+    SESSION_RECORD_MILLIS,
+    SESSION_RECORD_PRESSURE,
+    SESSION_RECORD_AVG_PRESSURE,
+    SESSION_RECORD_AROUSAL,
+    SESSION_RECORD_MOTOR_SPEED,
+    SESSION_RECORD_DENIAL_COUNT,
+    SESSION_RECORD_SENSITIVITY_THRESHOLD,
+    SESSION_RECORD_CLENCH_PRESSURE_THRESHOLD,
+    SESSION_RECORD_CLENCH_DURATION,
+    SESSION_RECORD_SHADOW_AROUSAL,
+    SESSION_RECORD_SHADOW_DENIAL_COUNT,
+    SESSION_RECORD_COLUMNS,
+} session_record_column_id_t;
+
+// How a column is stored. Bit 0 selects runs, bit 1 differences of differences.
+typedef enum session_record_codec {
+    // Each difference from the sample before, as a zigzag varint.
+    SESSION_RECORD_DELTA = 0,
+    // Runs of equal differences, each a zigzag varint value and a varint length.
+    SESSION_RECORD_DELTA_RLE = 1,
+    // Each change in the difference, starting from a difference of 0, as a zigzag varint.
+    SESSION_RECORD_DELTA2 = 2,
+    SESSION_RECORD_DELTA2_RLE = 3,
+    _SESSION_RECORD_CODEC_MAX,
+} session_record_codec_t;
+
+typedef struct __attribute__((packed)) session_record_column_header {
+    uint8_t codec;
+    uint16_t length;
+} session_record_column_header_t;
+
+// One sample after the first in a version 1 block, as differences from the one before.
+typedef struct __attribute__((packed)) session_record {
+    uint16_t dt_ms;
+    uint8_t motor_speed;
+    uint8_t denial_count;
+    uint8_t shadow_denial_count;
+    uint8_t reserved;
+    int16_t d_pressure;
+    int16_t d_avg_pressure;
+    int16_t d_arousal;
+    int16_t d_sensitivity_threshold;
+    int16_t d_clench_pressure_threshold;
+    int16_t d_clench_duration;
+    int16_t d_shadow_arousal;
+} session_record_t;
+
+// Records in a full version 1 block.
+#define SESSION_RECORD_BLOCK_RECORDS                                                               \
+    ((SESSION_RECORD_BLOCK_SIZE - sizeof(session_record_block_header_t)) / sizeof(session_record_t))
+
+// What a column would take so far with and without runs, for one of its two streams of values.
+typedef struct session_record_stream_size {
+    uint32_t plain;
+    // Bytes for the runs before the current one.
+    uint32_t runs;
+    int64_t run_value;
+    uint32_t run_length;
+} session_record_stream_size_t;
+
+typedef struct session_record_column_state {
+    int64_t last;
+    int64_t last_delta;
+    // Differences, and differences of differences.
+    session_record_stream_size_t streams[2];
+} session_record_column_state_t;
+
+typedef struct session_record_encoder {
+    uint8_t* block;
+    uint32_t seq;
+    uint16_t count;
+    // At least the encoded size of the block so far, exact when it's nearly full.
+    uint32_t size;
+    // The block's samples, kept until it's written, and the sizes of each column with each codec.
+    session_record_keyframe_t* samples;
+    session_record_column_state_t columns[SESSION_RECORD_COLUMNS];
+} session_record_encoder_t;
+
+/**
+ * @brief Writes a file header block.
+ *
+ * @param block SESSION_RECORD_BLOCK_SIZE bytes.
+ * @param config Config JSON, truncated if it doesn't fit in the block.
+ */
+void session_record_write_header(
+    uint8_t* block, uint32_t start_time, uint16_t update_frequency_hz, const char* config
+);
+
+/**
+ * @brief Starts encoding into a caller-provided block, from block seq 0.
+ *
+ * @param block SESSION_RECORD_BLOCK_SIZE bytes, reused for every block.
+ * @return 0 on success, -1 if there's no memory for SESSION_RECORD_MAX_SAMPLES samples.
+ */
+int session_record_encoder_init(session_record_encoder_t* encoder, uint8_t* block);
+void session_record_encoder_free(session_record_encoder_t* encoder);
+
+/**
+ * @brief Adds a sample to the current block.
+ *
+ * @return false if the sample doesn't fit. The block is then complete: write it out, call
+ * session_record_next_block() and add the sample again, which always fits an empty block.
+ */
+bool session_record_add(
+    session_record_encoder_t* encoder, const struct orgasm_control_sample* sample
+);
+
+/**
+ * @brief Encodes the samples added so far into the block, which is otherwise only done once it's
+ * complete. Call before writing out a partly filled block; more samples can still be added after.
+ */
+void session_record_finish(session_record_encoder_t* encoder);
+
+/**
+ * @brief Clears the block for the next seq. Call after writing out a complete block.
+ */
+void session_record_next_block(session_record_encoder_t* encoder);
+
+/**
+ * @brief Like session_record_next_block(), but continues in another block, for encoders writing
+ * straight into a ring of blocks.
+ */
+void session_record_next_block_at(session_record_encoder_t* encoder, uint8_t* block);
+
+static inline bool session_record_empty(const session_record_encoder_t* encoder) {
+    return encoder->count == 0;
+}
+
+/**
+ * @brief Reads the file header block.
+ *
+ * @param config Set to the config JSON inside the block.
+ * @return 0 on success, -1 if the block isn't a file header of a version this reads.
+ */
+int session_record_read_header(
+    const uint8_t* block, session_record_file_header_t* header, const char** config
+);
+
+/**
+ * @brief Reads the millis of the first sample in a data block, to seek by.
+ *
+ * @return 0 on success, -1 if the block isn't a data block.
+ */
+int session_record_block_millis(const uint8_t* block, uint32_t* millis);
+
+/**
+ * @brief Decodes a data block of either version.
+ *
+ * @param samples Room for at least SESSION_RECORD_MAX_SAMPLES samples.
+ * @return Number of samples decoded, or -1 if the block is damaged or isn't a data block.
+ */
+int session_record_decode(
+    const uint8_t* block, struct orgasm_control_sample* samples, uint32_t* seq
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef __session_stats_h
+#define __session_stats_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "util/histogram.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Width of the time to edge buckets, 32 of them cover 160s.
+#define SESSION_STATS_EDGE_BUCKET_MS 5000
+
+struct orgasm_control_sample;
+
+/**
+ * Running totals for one edging session, from automatic control being chosen until the output
+ * mode is back to manual. Every update is O(1) and nothing is kept per tick, so a session can run
+ * for hours without recording to SD.
+ */
+typedef struct session_stats {
+    unsigned long start_ms;
+    unsigned long duration_ms;
+    unsigned long over_threshold_ms;
+    uint32_t ticks;
+    uint64_t motor_speed_sum;
+    uint16_t peak_arousal;
+    uint16_t denials;
+    uint16_t orgasms;
+    uint16_t clenches;
+
+    // Time from the motor starting to the denial that stopped it, in ms.
+    histogram_t time_to_edge;
+
+    // Previous tick
+    unsigned long last_ms;
+    unsigned long motor_start_ms;
+    uint8_t motor_speed;
+    uint8_t denial_count;
+    bool clenching;
+    bool orgasm;
+} session_stats_t;
+
+void session_stats_start(session_stats_t* stats, unsigned long now_ms);
+
+/**
+ * @brief Adds one control update to the session.
+ *
+ * @param sample The sample the update produced.
+ * @param orgasm Whether the clench detector currently reports an orgasm.
+ */
+void session_stats_update(
+    session_stats_t* stats, const struct orgasm_control_sample* sample, bool orgasm
+);
+
+/**
+ * @return Average motor speed over the session as a fraction of full speed.
+ */
+float session_stats_motor_duty(const session_stats_t* stats);
+
+/**
+ * @brief Writes the session as one line of JSON. Times are in ms, and trailing empty time to edge
+ * buckets are left out.
+ *
+ * @param end_time Wall clock time the session ended at, 0 if unknown.
+ */
+void session_stats_write_json(const session_stats_t* stats, long end_time, FILE* file);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
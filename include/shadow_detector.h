@@ -0,0 +1,56 @@
+#ifndef __shadow_detector_h
+#define __shadow_detector_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "arousal_detector.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * A second detector that runs in the same tick as the live one, on the same pressure, with its own
+ * algorithm or threshold (see use_shadow_detector in config.h). It never touches the motor. It
+ * follows the same stop / edge delay / minimum on time rules as automatic control, without the
+ * random additional delay, and counts the denials it would have made so they can be logged next
+ * to the live ones.
+ */
+
+void shadow_detector_init(void);
+
+/**
+ * @brief Runs one shadow tick. Does nothing while the shadow detector is disabled.
+ *
+ * @param pressure The pressure the live detector was given this tick.
+ * @param permit_orgasm Whether the live session currently permits an orgasm.
+ * @param controlling Whether the live session is controlling the motor. Denials are only counted
+ * while it is.
+ * @param now_ms Tick timestamp.
+ */
+void shadow_detector_update(
+    uint16_t pressure, bool permit_orgasm, bool controlling, unsigned long now_ms
+);
+
+/**
+ * @brief Starts the shadow detector's baselines over from `pressure`, see detector_rebase().
+ */
+void shadow_detector_rebase(uint16_t pressure);
+
+bool shadow_detector_enabled(void);
+uint16_t shadow_detector_get_arousal(void);
+uint8_t shadow_detector_get_denial_count(void);
+uint8_t shadow_detector_get_orgasm_count(void);
+
+/**
+ * @brief Cost of the whole shadow update (smoothing, detector and clench logic) in perf counter
+ * cycles. This is the extra per-tick cost of running the shadow.
+ */
+const arousal_detector_stats_t* shadow_detector_get_stats(void);
+void shadow_detector_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef __spectrum_h
+#define __spectrum_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "util/fft.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Updates per analysis window, 5.12s at 50Hz.
+#define SPECTRUM_SIZE 256
+#define SPECTRUM_BINS (SPECTRUM_SIZE / 2 + 1)
+
+// Updates between analyses, so windows overlap by 90%.
+#define SPECTRUM_HOP 25
+
+// Band pelvic floor contractions are looked for in. Slower changes are drift and posture, faster
+// ones are sensor and motor noise.
+#define SPECTRUM_CONTRACTION_MIN_HZ 0.3f
+#define SPECTRUM_CONTRACTION_MAX_HZ 3.0f
+
+// A contraction rate is only reported when its bin has this many times the band's mean power.
+#define SPECTRUM_RATE_PROMINENCE 3.0f
+
+typedef enum spectrum_band {
+    SPECTRUM_BAND_DRIFT,
+    SPECTRUM_BAND_CONTRACTION,
+    SPECTRUM_BAND_NOISE,
+    _SPECTRUM_BAND_MAX,
+} spectrum_band_t;
+
+/**
+ * One analysis of the last SPECTRUM_SIZE pressure updates. Amplitudes are RMS pressure, so a
+ * sine of amplitude A in the window shows as A / √2 summed over its bins' band.
+ */
+typedef struct spectrum_frame {
+    unsigned long millis;
+    float bin_hz;
+
+    // Dominant rhythm in the contraction band, interpolated between bins. 0 if none stands out.
+    float contraction_rate_hz;
+    float band_rms[_SPECTRUM_BAND_MAX];
+
+    float amplitude[SPECTRUM_BINS];
+} spectrum_frame_t;
+
+/**
+ * Windowed FFT over a sliding history of pressure. The mean is removed and a Hann window applied
+ * before each transform. The window's cosines are the FFT's own twiddles, so no other tables are
+ * kept.
+ */
+typedef struct spectrum {
+    fft_plan_t plan;
+    uint16_t samples[SPECTRUM_SIZE];
+    uint16_t index;
+    uint16_t count;
+    uint16_t since_analysis;
+    float work[SPECTRUM_SIZE];
+    float power[SPECTRUM_BINS];
+} spectrum_t;
+
+void spectrum_init(spectrum_t* spectrum);
+
+/**
+ * @brief Adds a pressure update, and analyzes the window every SPECTRUM_HOP updates once it is
+ * full.
+ *
+ * @param sample_rate_hz Rate updates arrive at.
+ * @return true if frame was filled in.
+ */
+bool spectrum_update(
+    spectrum_t* spectrum,
+    uint16_t pressure,
+    float sample_rate_hz,
+    unsigned long millis,
+    spectrum_frame_t* frame
+);
+
+const char* spectrum_band_str(spectrum_band_t band);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef __system__black_box_h
+#define __system__black_box_h
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Always-on flight recorder: the last `black_box_seconds` of samples, kept in RAM as a ring of
+ * session_record blocks, and written to the SD card as /blackbox-*.eom only when asked.
+ *
+ * Dumps are taken on request, and automatically BLACK_BOX_TRIGGER_DELAY_MS after an orgasm or a
+ * sensor fault, so the file shows what led up to it and what followed. Blocks go to the card
+ * through an sd_logger, so neither keeping the ring nor dumping it ever waits on the card.
+ */
+
+// How long after an orgasm or sensor fault the dump is taken.
+#define BLACK_BOX_TRIGGER_DELAY_MS 10000
+
+/**
+ * @brief Moves new samples into the ring, and carries on with any dump. Call often from a
+ * low-priority task; the sample ring holds about 2.5s.
+ */
+void black_box_tick(void);
+
+/**
+ * @brief Asks for the ring to be written to the SD card on the next tick. Safe from any task.
+ *
+ * @return false if the black box is off.
+ */
+bool black_box_dump(void);
+
+bool black_box_enabled(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
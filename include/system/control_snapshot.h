@@ -0,0 +1,35 @@
+#ifndef __system__control_snapshot_h
+#define __system__control_snapshot_h
+
+#include "orgasm_control.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Keeps the latest orgasm control snapshot in NVS, so a session survives a brownout, crash or
+ * watchdog reset. NVS replaces a blob atomically, so a reset during a write leaves the previous
+ * snapshot intact.
+ */
+
+/**
+ * @brief Loads the saved snapshot, if the last reset was one a session should survive. After a
+ * power-on reset the snapshot is discarded instead, since the device was switched off on purpose.
+ *
+ * @return true if snapshot holds a session to resume.
+ */
+bool control_snapshot_load(orgasm_control_snapshot_t* snapshot);
+
+/**
+ * @brief Writes the newest snapshot published by the control task, or erases the saved one when
+ * the session has ended. Call from a low-priority task; flash writes take a few ms.
+ */
+void control_snapshot_tick(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef __system__control_task_h
+#define __system__control_task_h
+
+#include "esp_err.h"
+#include "util/histogram.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Starts the control task, which samples pressure and runs control updates.
+ *
+ * The task is woken by a periodic esp_timer rather than the FreeRTOS tick, runs above every UI
+ * and network task, and is pinned to the APP core so that display flushes, toasts and SD writes on
+ * the main loop can't delay pressure sampling.
+ */
+esp_err_t control_task_init(void);
+
+/**
+ * @brief Wakeup jitter of the control task, in microseconds of deviation from the nominal period.
+ */
+const histogram_t* control_task_get_jitter(void);
+
+/**
+ * @brief Asks the control task to clear the jitter histogram before it next records. Safe from
+ * any task.
+ */
+void control_task_reset_jitter(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef __system__perf_stats_h
+#define __system__perf_stats_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "esp_timer.h"
+#include "util/histogram.h"
+#include "util/perf_counter.h"
+
+// This enum has associated name and bucket width arrays in perf_stats.c
+typedef enum perf_stage {
+    // Control task, once per update. Timed with the cycle counter.
+    PERF_STAGE_SENSOR_READ,
+    PERF_STAGE_AROUSAL,
+    PERF_STAGE_EDGING_TIME,
+    PERF_STAGE_MOTOR,
+    PERF_STAGE_SHADOW,
+    PERF_STAGE_SPECTRUM,
+    PERF_STAGE_CONTROL_UPDATE,
+
+    // Main task, once per loop. This and the rest are timed with esp_timer.
+    PERF_STAGE_MAIN_API,
+    PERF_STAGE_MAIN_HAL,
+    PERF_STAGE_MAIN_UI,
+    PERF_STAGE_MAIN_LOGGER,
+
+    // Per logged sample, and per batch of accessory / BT broadcasts
+    PERF_STAGE_CSV_FORMAT,
+    PERF_STAGE_RECORD_ENCODE,
+    PERF_STAGE_BROADCAST,
+    _PERF_STAGE_MAX,
+} perf_stage_t;
+
+/**
+ * Per-stage duration histograms, in microseconds, for finding out which part of a control update
+ * or main loop pass ran long. Each stage is only recorded from one task, so recording takes no
+ * locks; readers may see a histogram mid-update.
+ */
+
+// Each timed stage costs two cycle counter reads. The host build turns timing off, since there the
+// counter is a clock call that would dominate replay time.
+//
+// The cycle counter is per core, so it only times the control task, which is pinned. The main,
+// logger and accessory tasks may move between cores mid-stage, so they time with the _us
+// variants, which read esp_timer at 1us resolution.
+#ifndef PERF_STATS_ENABLED
+#define PERF_STATS_ENABLED 1
+#endif
+
+#if PERF_STATS_ENABLED
+static inline uint32_t perf_stats_begin(void) {
+    return perf_counter_get();
+}
+
+/**
+ * @brief Records the time since start, a perf_stats_begin() value, against a stage.
+ */
+void perf_stats_record(perf_stage_t stage, uint32_t start);
+
+static inline uint32_t perf_stats_begin_us(void) {
+    return (uint32_t)esp_timer_get_time();
+}
+
+/**
+ * @brief Records the time since start, a perf_stats_begin_us() value, against a stage.
+ */
+void perf_stats_record_us(perf_stage_t stage, uint32_t start);
+#else
+static inline uint32_t perf_stats_begin(void) {
+    return 0;
+}
+
+static inline void perf_stats_record(perf_stage_t stage, uint32_t start) {}
+
+static inline uint32_t perf_stats_begin_us(void) {
+    return 0;
+}
+
+static inline void perf_stats_record_us(perf_stage_t stage, uint32_t start) {}
+#endif
+
+const histogram_t* perf_stats_get(perf_stage_t stage);
+const char* perf_stats_stage_name(perf_stage_t stage);
+void perf_stats_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
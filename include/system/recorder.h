@@ -0,0 +1,63 @@
+#ifndef __system__recorder_h
+#define __system__recorder_h
+
+#include "system/sd_logger.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Session recordings on the SD card, as CSV or in the binary format of session_record.h depending
+ * on `recording_format`. Oversampled sessions also record the full-rate pressure to a -raw.csv.
+ *
+ * Samples are taken from the orgasm control rings and handed to an sd_logger, so nothing here
+ * waits on the card while a segment is being written. Long recordings are split into segments by
+ * `recording_segment_minutes` and `recording_segment_kb`, with a seek index alongside, see
+ * session_index.h. The last segment closes in the background while the next one fills.
+ */
+
+void recorder_start(void);
+void recorder_stop(void);
+bool recorder_is_recording(void);
+
+/**
+ * @brief Moves new samples into the recording. Call often from a low-priority task; the sample
+ * ring holds about 2.5s.
+ */
+void recorder_tick(void);
+
+/**
+ * @brief Writes a session_record file header carrying the current config, less the WiFi password.
+ *
+ * @param block SESSION_RECORD_BLOCK_SIZE bytes.
+ */
+void recorder_write_header(uint8_t* block, time_t start_time);
+
+/**
+ * @brief Deletes the oldest recordings and black box dumps, but never the running recording's,
+ * until they fit in `recording_retention_mb`. Lists the whole card the first time it's needed;
+ * after that it works from that list and the files passed to recorder_retain().
+ */
+void recorder_apply_retention(void);
+
+/**
+ * @brief Counts a closed recording file or black box dump towards `recording_retention_mb`.
+ *
+ * @param path Path on the SD card, as passed to SDHelper_open().
+ */
+void recorder_retain(const char* path);
+
+/**
+ * @brief Logger counters for the current or last recording, over all its segments.
+ */
+void recorder_get_stats(sd_logger_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef __system__sd_logger_h
+#define __system__sd_logger_h
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Buffered file writer for the SD card, so a slow card never holds up whoever is logging.
+ *
+ * Records are copied into the active RAM buffer. A full buffer is handed to a low-priority writer
+ * task and the next free one becomes active. FAT writes stall now and then for tens of ms, and
+ * the spare buffers cover that. Records are only dropped while every buffer waits on the card.
+ *
+ * Each logger has one producer task and its own writer task. The handoff is two counters, one
+ * advanced by each side, so neither ever waits on the other.
+ */
+
+#define SD_LOGGER_BUFFER_SIZE 4096
+#define SD_LOGGER_BUFFERS 4
+
+// Records taking longer than this from a full buffer to the card count as late.
+#define SD_LOGGER_LATE_MS 100
+
+typedef struct sd_logger_stats {
+    // Records written to the card.
+    uint32_t records;
+    // Records lost while every buffer was waiting on the card, or before reaching the logger.
+    uint32_t dropped;
+    // Records that took longer than SD_LOGGER_LATE_MS from a full buffer to the card.
+    uint32_t late;
+    // Longest single buffer write.
+    uint32_t max_write_ms;
+} sd_logger_stats_t;
+
+typedef struct sd_logger_buffer {
+    size_t used;
+    uint32_t records;
+    int64_t queued_us;
+    uint8_t data[SD_LOGGER_BUFFER_SIZE];
+} sd_logger_buffer_t;
+
+typedef struct sd_logger {
+    FILE* file;
+    sd_logger_buffer_t* buffers;
+    TaskHandle_t writer;
+    TaskHandle_t closer;
+
+    // Buffers queued by the producer and written by the writer, counting from open. The producer
+    // fills buffers[queued % SD_LOGGER_BUFFERS] while fewer than SD_LOGGER_BUFFERS are queued.
+    _Atomic uint32_t queued;
+    _Atomic uint32_t written;
+    _Atomic bool closing;
+    _Atomic bool closed;
+
+    // Each counter has one owner: dropped is the producer's, the rest and failed are the writer's.
+    sd_logger_stats_t stats;
+    uint32_t failed;
+} sd_logger_t;
+
+/**
+ * @brief Starts logging to an open file, which the logger then owns.
+ *
+ * @return ESP_ERR_NO_MEM if the buffers or writer task can't be allocated. The file is left open.
+ */
+esp_err_t sd_logger_open(sd_logger_t* logger, FILE* file);
+
+/**
+ * @brief Copies data into the active buffer. Data is never split across buffers.
+ *
+ * @param records Number of records the data holds, for the counters: 1 for a CSV row, the samples
+ * in a binary block, 0 for a file header.
+ * @return false if the data was dropped.
+ */
+bool sd_logger_write(sd_logger_t* logger, const void* data, size_t len, uint32_t records);
+
+/**
+ * @brief Whether len bytes would be taken right now rather than dropped.
+ */
+bool sd_logger_has_room(sd_logger_t* logger, size_t len);
+
+/**
+ * @brief Hands a partly filled buffer to the writer.
+ */
+void sd_logger_flush(sd_logger_t* logger);
+
+/**
+ * @brief Counts records the producer lost before they reached the logger.
+ */
+void sd_logger_drop(sd_logger_t* logger, uint32_t records);
+
+/**
+ * @brief Writes out everything buffered, then closes the file. Blocks until the card is done.
+ */
+void sd_logger_close(sd_logger_t* logger);
+
+/**
+ * @brief Starts sd_logger_close() without waiting for it. Nothing more may be written to it, but
+ * it stays open until sd_logger_close_poll() sees the writer is done.
+ */
+void sd_logger_close_begin(sd_logger_t* logger);
+
+/**
+ * @brief Finishes a close started by sd_logger_close_begin() if the writer is done.
+ *
+ * @return true once the logger is closed, or if it wasn't open.
+ */
+bool sd_logger_close_poll(sd_logger_t* logger);
+
+/**
+ * @brief Counters since the logger was last opened, kept after it's closed.
+ */
+void sd_logger_get_stats(const sd_logger_t* logger, sd_logger_stats_t* stats);
+
+static inline bool sd_logger_is_open(const sd_logger_t* logger) {
+    return logger->file != NULL;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
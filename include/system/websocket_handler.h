@@ -35,6 +35,9 @@ enum {
 
     // Broadcast system info, including periodic SD and WiFi updates:
     WS_BROADCAST_SYSTEM = (1 << 1),
+
+    // Broadcast pressure spectrum analyses:
+    WS_BROADCAST_SPECTRUM = (1 << 2),
 };
 
 esp_err_t websocket_handler(httpd_req_t* req);
@@ -0,0 +1,64 @@
+#ifndef __util__command_queue_h
+#define __util__command_queue_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Lock-free multi-writer, single-reader queue of fixed-size records.
+ *
+ * Any task may push; one task pops, in push order. Unlike ring_buffer_t nothing is ever
+ * overwritten: a push to a full queue fails instead. Each slot carries a sequence number that
+ * tells writers when it is free and the reader when it has been filled, so a writer that is
+ * preempted mid-copy only holds up the reader, never another writer.
+ */
+typedef struct command_queue {
+    uint8_t* data;
+    _Atomic uint32_t* seqs;
+    size_t item_size;
+    uint32_t mask;
+    _Atomic uint32_t tail;
+    uint32_t head;
+} command_queue_t;
+
+/**
+ * @brief Initializes a queue over caller-provided storage.
+ *
+ * @param storage At least item_size * capacity bytes.
+ * @param seqs capacity sequence numbers.
+ * @param capacity Number of records, must be a power of two.
+ * @return 0 on success, -1 if capacity is not a power of two.
+ */
+int command_queue_init(
+    command_queue_t* queue,
+    void* storage,
+    _Atomic uint32_t* seqs,
+    size_t item_size,
+    size_t capacity
+);
+
+/**
+ * @brief Appends a record. Safe from any task.
+ *
+ * @return false if the queue is full.
+ */
+bool command_queue_push(command_queue_t* queue, const void* item);
+
+/**
+ * @brief Copies the oldest record into item and removes it. Only one task may pop.
+ *
+ * @return false if the queue is empty, or its oldest record is still being written.
+ */
+bool command_queue_pop(command_queue_t* queue, void* item);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef __util__decimator_h
+#define __util__decimator_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define DECIMATOR_ORDER 3
+#define DECIMATOR_MAX_RATIO 32
+
+/**
+ * Third-order CIC (sinc^3) decimator for oversampled pressure readings.
+ *
+ * Integrators run at the input rate and combs at the output rate, so the per-sample cost is three
+ * additions with no multiplies. Registers are 32-bit and allowed to wrap: with 16-bit input and a
+ * ratio up to 32 the output fits in 31 bits, so the modular result is exact. The output is scaled
+ * back down by ratio^3 to the input range.
+ */
+typedef struct decimator {
+    uint8_t ratio;
+    uint8_t phase;
+    uint32_t gain;
+    uint32_t integrators[DECIMATOR_ORDER];
+    uint32_t combs[DECIMATOR_ORDER];
+} decimator_t;
+
+/**
+ * @param ratio Input samples per output sample, clamped to 1..DECIMATOR_MAX_RATIO.
+ */
+void decimator_init(decimator_t* dec, uint8_t ratio);
+
+/**
+ * @brief Feeds one input sample.
+ *
+ * @param out Receives the decimated sample when one is ready.
+ * @return true on every ratio-th input, when out was written.
+ */
+bool decimator_push(decimator_t* dec, uint16_t in, uint16_t* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef __util__fft_h
+#define __util__fft_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+// Largest transform, in real samples.
+#define FFT_MAX_SIZE 256
+
+/**
+ * Twiddle factors and bit reversal order for one transform size, computed once so a transform is
+ * nothing but loads, multiplies and adds.
+ */
+typedef struct fft_plan {
+    uint16_t size;
+
+    // e^(-2πik/size) for k < size / 2, interleaved re, im.
+    float twiddle[FFT_MAX_SIZE];
+
+    // Bit reversed index for each of the size / 2 complex points of the half-size transform.
+    uint16_t bitrev[FFT_MAX_SIZE / 2];
+} fft_plan_t;
+
+/**
+ * @param size Number of real samples, a power of two from 4 to FFT_MAX_SIZE.
+ * @return 0 on success, -1 for an unsupported size.
+ */
+int fft_plan_init(fft_plan_t* plan, uint16_t size);
+
+/**
+ * @brief In-place FFT of `plan->size` real samples. The real input is transformed as a complex
+ * sequence of half the length with an iterative radix-2 FFT, then split into the real spectrum.
+ *
+ * Output is packed: data[0] is bin 0 and data[1] is bin size / 2, both purely real. Bins 1 to
+ * size / 2 - 1 follow as re, im pairs, bin k at data[2k] and data[2k + 1].
+ */
+void fft_real(const fft_plan_t* plan, float* data);
+
+/**
+ * @brief Squared magnitude of each bin of a packed fft_real() result.
+ *
+ * @param power size / 2 + 1 entries.
+ */
+void fft_power(const fft_plan_t* plan, const float* data, float* power);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef __util__filter_h
+#define __util__filter_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "util/fixed.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Longest window the moving average and median keep samples for. Longer windows are clamped.
+#define FILTER_MAX_WINDOW 64
+
+// This enum has an associated filter table in filter.c
+typedef enum filter_type {
+    FILTER_MOVING_AVERAGE,
+    FILTER_EMA,
+    FILTER_MEDIAN,
+    FILTER_LOWPASS,
+    FILTER_DC_BLOCK,
+    _FILTER_TYPE_MAX,
+} filter_type_t;
+
+/**
+ * Streaming filters over a uint16_t sample stream, one sample in and one value out per update.
+ * Every type is sized by a window in samples, chosen so the smoothing filters lag about as much
+ * as a moving average of that window:
+ *
+ * - moving average: mean of the last `window` samples.
+ * - EMA: exponential average with alpha = 2 / (window + 1).
+ * - median: median of the last `window` samples, which drops spikes shorter than half of it.
+ * - lowpass: 2nd order Butterworth with its -3dB point where the moving average has it, at
+ *   0.443 / window of the sample rate, but with a much steeper rolloff.
+ * - DC block: removes the baseline, with a time constant of `window` samples. The output is
+ *   signed.
+ *
+ * Filters live entirely in the filter_t, so init never allocates and a filter can be copied.
+ * Accumulators are wide enough for any uint16_t input at any window.
+ */
+typedef struct filter {
+    filter_type_t type;
+    uint16_t window;
+    int32_t value;
+
+    union {
+        struct filter_average {
+            uint16_t samples[FILTER_MAX_WINDOW];
+            uint16_t length;
+            uint16_t index;
+            uint16_t count;
+            uint32_t sum;
+        } average;
+
+        struct filter_ema {
+            q16_t alpha;
+            int64_t y; // Q16
+            bool primed;
+        } ema;
+
+        struct filter_median {
+            uint16_t samples[FILTER_MAX_WINDOW];
+            uint16_t sorted[FILTER_MAX_WINDOW];
+            uint16_t length;
+            uint16_t index;
+            uint16_t count;
+        } median;
+
+        struct filter_lowpass {
+            int32_t b0, b1, b2, a1, a2; // Q28
+            int32_t x1, x2;
+            int64_t y1, y2; // Q16
+            bool primed;
+        } lowpass;
+
+        struct filter_dc_block {
+            q16_t pole;
+            int32_t x1;
+            int64_t y; // Q16
+            bool primed;
+        } dc_block;
+    } state;
+} filter_t;
+
+/**
+ * @brief Sets up a filter in caller storage. The first sample primes EMA, lowpass and DC block
+ * filters, so they don't ramp up from 0.
+ *
+ * @param window Window in samples, at least 1.
+ */
+void filter_init(filter_t* filter, filter_type_t type, uint16_t window);
+
+/**
+ * @brief Clears the filter's history, keeping its type and window.
+ */
+void filter_reset(filter_t* filter);
+
+/**
+ * @brief Adds a sample.
+ *
+ * @return The filtered value.
+ */
+int32_t filter_update(filter_t* filter, uint16_t sample);
+
+static inline int32_t filter_get(const filter_t* filter) {
+    return filter->value;
+}
+
+const char* filter_type_str(filter_type_t type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef __util__fixed_h
+#define __util__fixed_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/**
+ * Q16.16 signed fixed point for the control loop. Everything here is integer math, so results are
+ * identical on the ESP32 and on the host tools. Right shifts of negative values rely on GCC's
+ * arithmetic shift, which both toolchains use, and round toward negative infinity; divisions round
+ * toward zero. Products and ratios saturate instead of wrapping.
+ */
+typedef int32_t q16_t;
+
+#define Q16_SHIFT 16
+#define Q16_ONE ((q16_t)1 << Q16_SHIFT)
+
+// Compile-time constant from a literal, rounded to nearest. Not for use on runtime values.
+#define Q16(x) ((q16_t)((x) * (double)Q16_ONE + ((x) >= 0 ? 0.5 : -0.5)))
+
+static inline q16_t q16_sat(int64_t value) {
+    if (value > INT32_MAX) return INT32_MAX;
+    if (value < INT32_MIN) return INT32_MIN;
+    return (q16_t)value;
+}
+
+static inline q16_t q16_from_int(int32_t value) {
+    return (q16_t)((uint32_t)value << Q16_SHIFT);
+}
+
+// Floor to an integer.
+static inline int32_t q16_to_int(q16_t value) {
+    return value >> Q16_SHIFT;
+}
+
+static inline q16_t q16_mul(q16_t a, q16_t b) {
+    return q16_sat(((int64_t)a * b) >> Q16_SHIFT);
+}
+
+// num / den as a Q16 value. Returns 0 when den is 0.
+static inline q16_t q16_ratio(int32_t num, int32_t den) {
+    return den != 0 ? q16_sat((int64_t)num * Q16_ONE / den) : 0;
+}
+
+// Scales an integer by a Q16 factor, flooring the result.
+static inline int32_t q16_scale(int32_t value, q16_t factor) {
+    return (int32_t)(((int64_t)value * factor) >> Q16_SHIFT);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef __util__histogram_h
+#define __util__histogram_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HISTOGRAM_BUCKETS 32
+
+/**
+ * Fixed-bucket histogram for timing data. Recording is a handful of integer ops and never
+ * allocates, so it is safe to call from the control task. Values past the last bucket are clamped
+ * into it, but still count towards min/max/avg.
+ */
+typedef struct histogram {
+    uint32_t bucket_width;
+    uint32_t buckets[HISTOGRAM_BUCKETS];
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+} histogram_t;
+
+void histogram_init(histogram_t* hist, uint32_t bucket_width);
+void histogram_reset(histogram_t* hist);
+void histogram_add(histogram_t* hist, uint32_t value);
+uint32_t histogram_avg(const histogram_t* hist);
+
+/**
+ * @brief Estimates a percentile from the buckets.
+ *
+ * @param percent 0..100
+ * @return Upper edge of the bucket holding that percentile, capped to the observed max.
+ */
+uint32_t histogram_percentile(const histogram_t* hist, uint8_t percent);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef __util__perf_counter_h
+#define __util__perf_counter_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "esp_cpu.h"
+#include "sdkconfig.h"
+#include <stdint.h>
+
+/**
+ * Cycle counter for measuring short code paths. On device this is the CPU cycle count register,
+ * which wraps every ~27s at 160MHz, so only measure spans well under that. The host build maps it
+ * to a nanosecond clock.
+ */
+#define PERF_COUNTER_HZ (CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ * 1000000UL)
+
+static inline uint32_t perf_counter_get(void) {
+    return (uint32_t)esp_cpu_get_ccount();
+}
+
+static inline uint32_t perf_counter_to_ns(uint64_t cycles) {
+    return (uint32_t)(cycles * 1000ULL / CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ);
+}
+
+// 32-bit only, for converting single spans on hot paths.
+static inline uint32_t perf_counter_to_us(uint32_t cycles) {
+    return cycles / CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
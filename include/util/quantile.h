@@ -0,0 +1,43 @@
+#ifndef __util__quantile_h
+#define __util__quantile_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define QUANTILE_MARKERS 5
+
+/**
+ * Streaming estimate of one quantile of a sample stream, using the P² algorithm (Jain & Chlamtac,
+ * 1985). Five markers track the minimum, the quantile, the maximum and the two midpoints between
+ * them; each sample moves the markers toward their ideal ranks with a parabolic fit. Memory and
+ * the cost per sample are constant however many samples are seen, and the estimate is exact until
+ * five samples are in.
+ */
+typedef struct quantile {
+    float p;
+    uint32_t count;
+    float height[QUANTILE_MARKERS];
+    int32_t position[QUANTILE_MARKERS];
+    float desired[QUANTILE_MARKERS];
+} quantile_t;
+
+/**
+ * @param p Quantile to track, between 0 and 1, e.g. 0.95 for the 95th percentile.
+ */
+void quantile_init(quantile_t* q, float p);
+
+void quantile_add(quantile_t* q, float value);
+
+/**
+ * @return The estimate, or 0 before any sample is added.
+ */
+float quantile_get(const quantile_t* q);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef __util__ring_buffer_h
+#define __util__ring_buffer_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Lock-free single-writer, multi-reader ring of fixed-size records.
+ *
+ * The writer never blocks and never waits on readers: once the ring is full it overwrites the
+ * oldest record. Each reader keeps its own position, so any number of consumers can follow the
+ * same stream at their own pace. A reader that falls more than `capacity` records behind skips
+ * ahead and counts what it missed in `dropped`.
+ */
+typedef struct ring_buffer {
+    uint8_t* data;
+    size_t item_size;
+    uint32_t mask;
+    _Atomic uint32_t head;
+} ring_buffer_t;
+
+typedef struct ring_buffer_reader {
+    uint32_t seq;
+    uint32_t dropped;
+} ring_buffer_reader_t;
+
+/**
+ * @brief Initializes a ring over caller-provided storage.
+ *
+ * @param storage At least item_size * capacity bytes.
+ * @param capacity Number of records, must be a power of two.
+ * @return 0 on success, -1 if capacity is not a power of two.
+ */
+int ring_buffer_init(ring_buffer_t* ring, void* storage, size_t item_size, size_t capacity);
+
+/**
+ * @brief Appends a record. Only one task may push to a given ring.
+ */
+void ring_buffer_push(ring_buffer_t* ring, const void* item);
+
+/**
+ * @brief Positions a reader at the current end of the ring, so it only sees new records.
+ */
+void ring_buffer_reader_init(ring_buffer_t* ring, ring_buffer_reader_t* reader);
+
+/**
+ * @brief Copies the reader's next record into item.
+ *
+ * @return true if a record was read, false if the reader is caught up.
+ */
+bool ring_buffer_read(ring_buffer_t* ring, ring_buffer_reader_t* reader, void* item);
+
+/**
+ * @brief Copies the most recently pushed record into item.
+ *
+ * @return false if nothing has been pushed yet.
+ */
+bool ring_buffer_latest(ring_buffer_t* ring, void* item);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
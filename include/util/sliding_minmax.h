@@ -0,0 +1,64 @@
+#ifndef __util__sliding_minmax_h
+#define __util__sliding_minmax_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Longest window, in samples. Must be a power of two; longer windows are clamped.
+#define SLIDING_MINMAX_CAPACITY 256
+
+typedef enum sliding_minmax_kind {
+    SLIDING_MIN,
+    SLIDING_MAX,
+} sliding_minmax_kind_t;
+
+/**
+ * Minimum or maximum of the last `window` samples, kept as a monotonic deque: each push drops the
+ * queued samples the new one beats and any that have left the window, so a push costs amortized
+ * O(1) whatever the window. The deque never holds more than `window` entries, so it lives inside
+ * the struct and needs no allocation.
+ */
+typedef struct sliding_minmax {
+    sliding_minmax_kind_t kind;
+    uint16_t window;
+
+    // Sample count, and the deque as free-running positions into the arrays below.
+    uint16_t tick;
+    uint16_t head;
+    uint16_t tail;
+    uint16_t values[SLIDING_MINMAX_CAPACITY];
+    uint16_t ticks[SLIDING_MINMAX_CAPACITY];
+} sliding_minmax_t;
+
+/**
+ * @param window Window in samples, clamped to 1 - SLIDING_MINMAX_CAPACITY.
+ */
+void sliding_minmax_init(sliding_minmax_t* s, sliding_minmax_kind_t kind, uint16_t window);
+
+/**
+ * @brief Adds a sample.
+ *
+ * @return The minimum or maximum of the window, including this sample.
+ */
+uint16_t sliding_minmax_push(sliding_minmax_t* s, uint16_t value);
+
+static inline bool sliding_minmax_empty(const sliding_minmax_t* s) {
+    return s->head == s->tail;
+}
+
+/**
+ * @return The current minimum or maximum. Only valid once a sample has been pushed.
+ */
+static inline uint16_t sliding_minmax_get(const sliding_minmax_t* s) {
+    return s->values[s->head & (SLIDING_MINMAX_CAPACITY - 1)];
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
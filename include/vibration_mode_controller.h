@@ -2,6 +2,7 @@
 #define __VibrationModeController_h
 
 #include "config.h"
+#include "util/fixed.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -18,8 +19,9 @@ typedef struct vibration_pattern {
     vibration_pattern_step_t steps[];
 } vibration_pattern_t;
 
-typedef float (*vibration_mode_callback_t)(void);
-typedef void (*vibration_mode_tick_func_t)(float motor_speed, uint16_t arousal);
+// Motor speeds are Q16.16 fixed point, 0..255. See util/fixed.h.
+typedef q16_t (*vibration_mode_callback_t)(void);
+typedef void (*vibration_mode_tick_func_t)(q16_t motor_speed, uint16_t arousal);
 
 typedef struct vibration_mode_controller {
     vibration_mode_callback_t start;
@@ -30,13 +32,13 @@ typedef struct vibration_mode_controller {
 
 // Helper Functions
 
-// Returns the increment per tick of a given span:
+// Returns the increment per tick of a given span, as a Q16.16 value:
 //   increment_per_second = (target - start) / time_s
 //   increment_per_tick = increment_per_second / ticks_per_second
 //
 #define calculate_increment(start, target, time_s)                                                 \
     ((time_s > 0 && Config.update_frequency_hz > 0)                                                \
-         ? ((float)(target - start) / ((float)time_s)) / Config.update_frequency_hz                \
+         ? q16_ratio((target) - (start), (time_s)*Config.update_frequency_hz)                      \
          : 0)
 
 // Vibration Modes
@@ -18,12 +18,16 @@ void api_broadcast_config(void) {
 void api_broadcast_readings(void) {
     cJSON* payload = cJSON_CreateObject();
     cJSON* root = cJSON_AddObjectToObject(payload, "readings");
+    orgasm_control_sample_t sample;
 
-    cJSON_AddNumberToObject(root, "pressure", orgasm_control_getLastPressure());
-    cJSON_AddNumberToObject(root, "pavg", orgasm_control_getAveragePressure());
-    cJSON_AddNumberToObject(root, "motor", eom_hal_get_motor_speed());
-    cJSON_AddNumberToObject(root, "arousal", orgasm_control_getArousal());
-    cJSON_AddNumberToObject(root, "millis", esp_timer_get_time() / 1000);
+    // One sample from the control task, so these readings all come from the same tick:
+    if (orgasm_control_get_latest_sample(&sample)) {
+        cJSON_AddNumberToObject(root, "pressure", sample.pressure);
+        cJSON_AddNumberToObject(root, "pavg", sample.avg_pressure);
+        cJSON_AddNumberToObject(root, "motor", sample.motor_speed);
+        cJSON_AddNumberToObject(root, "arousal", sample.arousal);
+        cJSON_AddNumberToObject(root, "millis", sample.millis);
+    }
 
     // Everything around this is deprecated and should be moved into its own broadcast.
     cJSON_AddStringToObject(root, "runMode", orgasm_control_get_output_mode_str());
@@ -35,6 +39,72 @@ void api_broadcast_readings(void) {
     cJSON_Delete(payload);
 }
 
+void api_broadcast_events(void) {
+    static orgasm_control_subscriber_t subscriber;
+    static bool subscribed = false;
+    orgasm_control_event_t event;
+
+    if (!subscribed) {
+        orgasm_control_subscribe(&subscriber);
+        subscribed = true;
+    }
+
+    while (orgasm_control_next_event(&subscriber, &event)) {
+        // Arousal and motor speed already go out with the readings.
+        if (event.type == OC_EVENT_UPDATE || event.type == OC_EVENT_AROUSAL ||
+            event.type == OC_EVENT_MOTOR_SPEED) {
+            continue;
+        }
+
+        cJSON* payload = cJSON_CreateObject();
+        cJSON* root = cJSON_AddObjectToObject(payload, "controlEvent");
+
+        cJSON_AddStringToObject(root, "type", orgasm_control_event_type_str(event.type));
+        cJSON_AddNumberToObject(root, "value", event.value);
+        cJSON_AddNumberToObject(root, "millis", event.millis);
+
+        if (event.type == OC_EVENT_MODE_CHANGE) {
+            cJSON_AddStringToObject(root, "runMode", orgasm_control_get_output_mode_str());
+        }
+
+        websocket_broadcast(payload, WS_BROADCAST_READINGS);
+        cJSON_Delete(payload);
+    }
+}
+
+void api_broadcast_spectrum(void) {
+    static ring_buffer_reader_t subscriber;
+    static bool subscribed = false;
+    static spectrum_frame_t frame;
+
+    if (!subscribed) {
+        orgasm_control_subscribe_spectrum(&subscriber);
+        subscribed = true;
+    }
+
+    while (orgasm_control_next_spectrum(&subscriber, &frame)) {
+        cJSON* payload = cJSON_CreateObject();
+        cJSON* root = cJSON_AddObjectToObject(payload, "spectrum");
+
+        cJSON_AddNumberToObject(root, "millis", frame.millis);
+        cJSON_AddNumberToObject(root, "binHz", frame.bin_hz);
+        cJSON_AddNumberToObject(root, "contractionRate", frame.contraction_rate_hz);
+
+        cJSON* bands = cJSON_AddObjectToObject(root, "bands");
+        for (spectrum_band_t band = 0; band < _SPECTRUM_BAND_MAX; band++) {
+            cJSON_AddNumberToObject(bands, spectrum_band_str(band), frame.band_rms[band]);
+        }
+
+        cJSON* amplitude = cJSON_AddArrayToObject(root, "amplitude");
+        for (size_t i = 0; i < SPECTRUM_BINS; i++) {
+            cJSON_AddItemToArray(amplitude, cJSON_CreateNumber(frame.amplitude[i]));
+        }
+
+        websocket_broadcast(payload, WS_BROADCAST_SPECTRUM);
+        cJSON_Delete(payload);
+    }
+}
+
 void api_broadcast_storage_status(void) {
     cJSON* payload = cJSON_CreateObject();
     cJSON* root = cJSON_AddObjectToObject(payload, "sdStatus");
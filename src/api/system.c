@@ -1,5 +1,9 @@
 #include "api/index.h"
 #include "eom-hal.h"
+#include "system/black_box.h"
+#include "system/control_task.h"
+#include "system/perf_stats.h"
+#include "system/recorder.h"
 #include "system/websocket_handler.h"
 #include "version.h"
 
@@ -56,9 +60,97 @@ static const websocket_command_t cmd_system_stream_readings_s = {
     .func = &cmd_system_stream_readings,
 };
 
+static void add_histogram(cJSON* parent, const char* name, const histogram_t* hist) {
+    cJSON* root = cJSON_AddObjectToObject(parent, name);
+
+    cJSON_AddNumberToObject(root, "count", hist->count);
+    cJSON_AddNumberToObject(root, "min", hist->count > 0 ? hist->min : 0);
+    cJSON_AddNumberToObject(root, "avg", histogram_avg(hist));
+    cJSON_AddNumberToObject(root, "p99", histogram_percentile(hist, 99));
+    cJSON_AddNumberToObject(root, "max", hist->max);
+    cJSON_AddNumberToObject(root, "bucketWidth", hist->bucket_width);
+
+    cJSON* buckets = cJSON_AddArrayToObject(root, "buckets");
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        cJSON_AddItemToArray(buckets, cJSON_CreateNumber(hist->buckets[i]));
+    }
+}
+
+static command_err_t
+cmd_system_stream_spectrum(cJSON* command, cJSON* response, websocket_client_t* client) {
+    if (client != NULL) {
+        client->broadcast_flags |= WS_BROADCAST_SPECTRUM;
+        return CMD_OK;
+    } else {
+        return CMD_NOT_FOUND;
+    }
+}
+
+static const websocket_command_t cmd_system_stream_spectrum_s = {
+    .command = "streamSpectrum",
+    .func = &cmd_system_stream_spectrum,
+};
+
+static command_err_t
+cmd_system_perf_stats(cJSON* command, cJSON* response, websocket_client_t* client) {
+    cJSON* reset = cJSON_GetObjectItem(command, "reset");
+    cJSON* stages = cJSON_AddObjectToObject(response, "stages");
+
+    for (int stage = 0; stage < _PERF_STAGE_MAX; stage++) {
+        add_histogram(stages, perf_stats_stage_name(stage), perf_stats_get(stage));
+    }
+
+    add_histogram(response, "jitter", control_task_get_jitter());
+
+    if (cJSON_IsTrue(reset)) {
+        perf_stats_reset();
+        control_task_reset_jitter();
+    }
+
+    return CMD_OK;
+}
+
+static const websocket_command_t cmd_system_perf_stats_s = {
+    .command = "perfStats",
+    .func = &cmd_system_perf_stats,
+};
+
+static command_err_t
+cmd_system_logger_stats(cJSON* command, cJSON* response, websocket_client_t* client) {
+    sd_logger_stats_t stats;
+    recorder_get_stats(&stats);
+
+    cJSON_AddBoolToObject(response, "recording", recorder_is_recording());
+    cJSON_AddNumberToObject(response, "records", stats.records);
+    cJSON_AddNumberToObject(response, "dropped", stats.dropped);
+    cJSON_AddNumberToObject(response, "late", stats.late);
+    cJSON_AddNumberToObject(response, "maxWriteMs", stats.max_write_ms);
+    return CMD_OK;
+}
+
+static const websocket_command_t cmd_system_logger_stats_s = {
+    .command = "loggerStats",
+    .func = &cmd_system_logger_stats,
+};
+
+static command_err_t
+cmd_system_black_box_dump(cJSON* command, cJSON* response, websocket_client_t* client) {
+    cJSON_AddBoolToObject(response, "dumping", black_box_dump());
+    return CMD_OK;
+}
+
+static const websocket_command_t cmd_system_black_box_dump_s = {
+    .command = "blackBoxDump",
+    .func = &cmd_system_black_box_dump,
+};
+
 void api_register_system(void) {
     websocket_register_command(&cmd_system_restart_s);
     websocket_register_command(&cmd_system_time_s);
     websocket_register_command(&cmd_system_info_s);
     websocket_register_command(&cmd_system_stream_readings_s);
+    websocket_register_command(&cmd_system_stream_spectrum_s);
+    websocket_register_command(&cmd_system_perf_stats_s);
+    websocket_register_command(&cmd_system_logger_stats_s);
+    websocket_register_command(&cmd_system_black_box_dump_s);
 }
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include "arousal_detector.h"
+#include "util/perf_counter.h"
+#include <string.h>
+
+static const arousal_detector_t* const detectors[] = {
+    [DetectPeaks] = &PeakDetector,
+    [DetectDerivative] = &DerivativeDetector,
+    [DetectBaseline] = &BaselineDetector,
+};
+
+#define DETECTOR_COUNT (sizeof(detectors) / sizeof(detectors[0]))
+
+static CONTROL_LOCAL arousal_detector_stats_t stats[DETECTOR_COUNT];
+
+static size_t arousal_detector_index(const arousal_detector_t* detector) {
+    for (size_t i = 0; i < DETECTOR_COUNT; i++) {
+        if (detectors[i] == detector) return i;
+    }
+
+    return DetectPeaks;
+}
+
+const arousal_detector_t* arousal_detector_get(arousal_detector_mode_t mode) {
+    if ((size_t)mode >= DETECTOR_COUNT) {
+        return detectors[DetectPeaks];
+    }
+
+    return detectors[mode];
+}
+
+uint16_t arousal_detector_tick(
+    const arousal_detector_t* detector,
+    arousal_detector_state_t* state,
+    const struct detector_params* params,
+    long pressure,
+    uint16_t arousal
+) {
+    uint32_t start = perf_counter_get();
+    arousal = detector->tick(state, params, pressure, arousal);
+    uint32_t cycles = perf_counter_get() - start;
+
+    arousal_detector_stats_t* s = &stats[arousal_detector_index(detector)];
+    s->calls++;
+    s->last_cycles = cycles;
+    s->total_cycles += cycles;
+    if (cycles > s->max_cycles) s->max_cycles = cycles;
+
+    return arousal;
+}
+
+const arousal_detector_stats_t* arousal_detector_get_stats(arousal_detector_mode_t mode) {
+    if ((size_t)mode >= DETECTOR_COUNT) {
+        return NULL;
+    }
+
+    return &stats[mode];
+}
+
+void arousal_detector_reset_stats(void) {
+    memset(stats, 0, sizeof(stats));
+}
@@ -0,0 +1,66 @@
+#include "arousal_detector.h"
+#include "detector.h"
+
+// Tracks a resting baseline and integrates pressure held above it. The baseline follows drops
+// quickly and rises slowly, and only while pressure is near it, so a contraction does not drag it
+// up but a plug shift or sensor drift is absorbed within a few seconds.
+
+// Baseline is kept in 8.8 fixed point.
+#define BASELINE_SHIFT 8
+
+// Baseline filter rates, as right shifts per tick.
+#define BASELINE_FALL_RATE 4
+#define BASELINE_RISE_RATE 8
+
+static void start(arousal_detector_state_t* state) {
+    state->baseline.baseline = 0;
+    state->baseline.primed = false;
+}
+
+// The next tick primes the baseline from its pressure:
+static void rebase(arousal_detector_state_t* state, long pressure) {
+    state->baseline.primed = false;
+}
+
+static uint16_t tick(
+    arousal_detector_state_t* state,
+    const detector_params_t* params,
+    long pressure,
+    uint16_t arousal
+) {
+    long deadband = params->sensitivity_threshold / 10;
+
+    if (!state->baseline.primed) {
+        state->baseline.baseline = pressure << BASELINE_SHIFT;
+        state->baseline.primed = true;
+    }
+
+    long baseline = state->baseline.baseline >> BASELINE_SHIFT;
+    long excess = pressure - baseline - deadband;
+
+    long error = (pressure << BASELINE_SHIFT) - state->baseline.baseline;
+
+    if (pressure < baseline) {
+        state->baseline.baseline += error >> BASELINE_FALL_RATE;
+    } else if (excess <= 0) {
+        state->baseline.baseline += error >> BASELINE_RISE_RATE;
+    }
+
+    // Decay stale arousal value:
+    arousal = arousal_detector_decay(arousal);
+
+    // Scaled so a held excess adds about 6x its height to arousal per second, independent of the
+    // update rate. That puts a typical contraction on par with the peak detector.
+    if (excess > 0 && params->update_frequency_hz > 0) {
+        arousal = arousal + (excess * 6) / params->update_frequency_hz;
+    }
+
+    return arousal;
+}
+
+const arousal_detector_t BaselineDetector = {
+    .name = "Baseline",
+    .start = start,
+    .rebase = rebase,
+    .tick = tick,
+};
@@ -0,0 +1,54 @@
+#include "arousal_detector.h"
+#include "detector.h"
+
+// Follows the slope of the pressure signal. Once a rise has climbed past the noise floor (a tenth
+// of the sensitivity threshold), the whole rise is added to arousal and every further increase is
+// added as it happens, so arousal moves during the contraction instead of after its peak. Any
+// falling tick ends the rise.
+
+static void start(arousal_detector_state_t* state) {
+    state->derivative.last_value = 0;
+    state->derivative.rise = 0;
+    state->derivative.credited = 0;
+}
+
+static void rebase(arousal_detector_state_t* state, long pressure) {
+    state->derivative.last_value = pressure;
+    state->derivative.rise = 0;
+    state->derivative.credited = 0;
+}
+
+static uint16_t tick(
+    arousal_detector_state_t* state,
+    const detector_params_t* params,
+    long pressure,
+    uint16_t arousal
+) {
+    long delta = pressure - state->derivative.last_value;
+    state->derivative.last_value = pressure;
+
+    // Decay stale arousal value:
+    arousal = arousal_detector_decay(arousal);
+
+    if (delta < 0) {
+        state->derivative.rise = 0;
+        state->derivative.credited = 0;
+        return arousal;
+    }
+
+    state->derivative.rise += delta;
+
+    if (state->derivative.rise >= params->sensitivity_threshold / 10) {
+        arousal = arousal + (state->derivative.rise - state->derivative.credited);
+        state->derivative.credited = state->derivative.rise;
+    }
+
+    return arousal;
+}
+
+const arousal_detector_t DerivativeDetector = {
+    .name = "Derivative",
+    .start = start,
+    .rebase = rebase,
+    .tick = tick,
+};
@@ -0,0 +1,66 @@
+#include "arousal_detector.h"
+#include "detector.h"
+
+// Waits for each pressure peak to pass, then adds its height above the preceding minimum to
+// arousal. Peaks smaller than a tenth of the sensitivity threshold are ignored as noise. With
+// baseline_window_ms set, the minimum is never older than the window, so a slow upward drift
+// can't make every wiggle look like a big peak measured from a long-gone low.
+
+static void start(arousal_detector_state_t* state) {
+    state->peak.last_value = 0;
+    state->peak.peak_start = 0;
+    state->peak.floor.window = 0; // Built on the first tick that uses it
+}
+
+static void rebase(arousal_detector_state_t* state, long pressure) {
+    state->peak.last_value = pressure;
+    state->peak.peak_start = pressure;
+    state->peak.floor.window = 0;
+}
+
+static uint16_t tick(
+    arousal_detector_state_t* state,
+    const detector_params_t* params,
+    long pressure,
+    uint16_t arousal
+) {
+    uint16_t window = detector_baseline_window(params);
+    long peak_start = state->peak.peak_start;
+
+    if (window > 0) {
+        if (window != state->peak.floor.window) {
+            sliding_minmax_init(&state->peak.floor, SLIDING_MIN, window);
+        }
+
+        uint16_t floor = sliding_minmax_push(&state->peak.floor, pressure);
+        if (floor > peak_start) peak_start = floor;
+    }
+
+    // Decay stale arousal value:
+    arousal = arousal_detector_decay(arousal);
+
+    if (pressure < state->peak.last_value) {       // falling edge of peak
+        if (state->peak.last_value > peak_start) { // first tick past peak?
+            if (state->peak.last_value - peak_start >= params->sensitivity_threshold / 10) {
+                // big peak
+                arousal = arousal + (state->peak.last_value - peak_start);
+                state->peak.peak_start = pressure;
+            }
+        }
+
+        if (pressure < state->peak.peak_start) {
+            // run this value down to a new minimum after a peak detected.
+            state->peak.peak_start = pressure;
+        }
+    }
+
+    state->peak.last_value = pressure;
+    return arousal;
+}
+
+const arousal_detector_t PeakDetector = {
+    .name = "Peaks",
+    .start = start,
+    .rebase = rebase,
+    .tick = tick,
+};
@@ -0,0 +1,53 @@
+#include "auto_threshold.h"
+#include <math.h>
+
+void auto_threshold_init(
+    auto_threshold_t* control, int threshold, unsigned long target_ms, unsigned long now_ms
+) {
+    if (threshold < 1) threshold = 1;
+
+    control->threshold = threshold;
+    control->min = threshold / AUTO_THRESHOLD_RANGE;
+    control->max = threshold * AUTO_THRESHOLD_RANGE;
+    control->target_ms = target_ms > 0 ? target_ms : 1;
+    control->last_ms = now_ms;
+    control->last_error = 0.0f;
+    control->updates = 0;
+    control->settled = 0;
+}
+
+static void auto_threshold_step(auto_threshold_t* control, unsigned long interval_ms) {
+    // Positive when denials come too often, calling for a higher threshold. Working on the log
+    // makes twice and half as fast equally wrong, and one odd interval can't swing it far:
+    float error = logf((float)control->target_ms / (interval_ms > 0 ? interval_ms : 1));
+    if (error > 1.0f) error = 1.0f;
+    if (error < -1.0f) error = -1.0f;
+
+    if (fabsf(error) < logf(AUTO_THRESHOLD_TOLERANCE)) {
+        if (control->settled < UINT8_MAX) control->settled++;
+    } else {
+        control->settled = 0;
+    }
+
+    float step = AUTO_THRESHOLD_KP * (error - control->last_error) + AUTO_THRESHOLD_KI * error;
+    if (step > AUTO_THRESHOLD_MAX_STEP) step = AUTO_THRESHOLD_MAX_STEP;
+    if (step < -AUTO_THRESHOLD_MAX_STEP) step = -AUTO_THRESHOLD_MAX_STEP;
+
+    control->threshold *= 1.0f + step;
+    if (control->threshold < control->min) control->threshold = control->min;
+    if (control->threshold > control->max) control->threshold = control->max;
+
+    control->last_error = error;
+    control->updates++;
+}
+
+int auto_threshold_update(auto_threshold_t* control, bool denied, unsigned long now_ms) {
+    unsigned long elapsed_ms = now_ms - control->last_ms;
+
+    if (denied || elapsed_ms >= control->target_ms * 2) {
+        auto_threshold_step(control, elapsed_ms);
+        control->last_ms = now_ms;
+    }
+
+    return auto_threshold_get(control);
+}
@@ -1,5 +1,63 @@
 #include "commands/index.h"
+#include "console.h"
+#include "orgasm_control.h"
 
-void commands_register_edging(void) {
-    
-}
\ No newline at end of file
+static command_err_t cmd_edging_stats(int argc, char** argv, console_t* console) {
+    if (argc != 0) {
+        return CMD_ARG_ERR;
+    }
+
+    const session_stats_t* stats = orgasm_control_get_session_stats();
+    const histogram_t* edges = &stats->time_to_edge;
+
+    fprintf(
+        console->out,
+        "%s session: %lus, %u denials, %u orgasms, %u clenches\n",
+        orgasm_control_in_session() ? "Current" : "Last",
+        stats->duration_ms / 1000,
+        stats->denials,
+        stats->orgasms,
+        stats->clenches
+    );
+
+    fprintf(
+        console->out,
+        "Peak arousal %u, %lus over threshold, motor duty %.0f%%\n",
+        stats->peak_arousal,
+        stats->over_threshold_ms / 1000,
+        session_stats_motor_duty(stats) * 100.0f
+    );
+
+    fprintf(
+        console->out,
+        "Time to edge: min %ums, avg %ums, p50 %ums, p90 %ums, max %ums\n",
+        edges->count > 0 ? edges->min : 0,
+        histogram_avg(edges),
+        histogram_percentile(edges, 50),
+        histogram_percentile(edges, 90),
+        edges->max
+    );
+
+    return CMD_OK;
+}
+
+static const command_t cmd_edging_stats_s = {
+    .command = "stats",
+    .help = "Show stats for the current or last edging session",
+    .alias = 's',
+    .func = &cmd_edging_stats,
+    .subcommands = { NULL },
+};
+
+static const command_t cmd_edging_s = {
+    .command = "edging",
+    .help = "Edging session control",
+    .alias = '\0',
+    .func = NULL,
+    .subcommands = {
+        &cmd_edging_stats_s,
+        NULL,
+    },
+};
+
+void commands_register_edging(void) { console_register_command(&cmd_edging_s); }
@@ -1,8 +1,14 @@
+#include "arousal_detector.h"
 #include "commands/index.h"
 #include "console.h"
 #include "eom-hal.h"
 #include "esp_system.h"
+#include "shadow_detector.h"
+#include "system/black_box.h"
+#include "system/control_task.h"
+#include "system/perf_stats.h"
 #include "system/screenshot.h"
+#include "util/perf_counter.h"
 
 static command_err_t cmd_system_restart(int argc, char** argv, console_t* console) {
     if (argc != 0) {
@@ -102,6 +108,28 @@ static const command_t cmd_system_screenshot_s = {
 
 
 
+static command_err_t cmd_system_blackbox(int argc, char** argv, console_t* console) {
+    if (argc != 0) {
+        return CMD_ARG_ERR;
+    }
+
+    if (!black_box_dump()) {
+        fprintf(console->out, "The black box is off, set black_box_seconds to turn it on.\n");
+        return CMD_FAIL;
+    }
+
+    fprintf(console->out, "Dumping the black box to the SD card.\n");
+    return CMD_OK;
+}
+
+static const command_t cmd_system_blackbox_s = {
+    .command = "blackbox",
+    .help = "Write the last black_box_seconds of samples to the SD card",
+    .alias = 'b',
+    .func = &cmd_system_blackbox,
+    .subcommands = { NULL },
+};
+
 static command_err_t cmd_system_tasklist(int argc, char** argv, console_t* console) {
     size_t n = uxTaskGetNumberOfTasks();
     TaskHandle_t th = NULL;
@@ -141,6 +169,123 @@ static const command_t cmd_system_tasklist_s = {
     .subcommands = { NULL },
 };
 
+static command_err_t cmd_system_jitter(int argc, char** argv, console_t* console) {
+    if (argc == 1 && !strcasecmp(argv[0], "reset")) {
+        control_task_reset_jitter();
+        return CMD_OK;
+    } else if (argc != 0) {
+        return CMD_ARG_ERR;
+    }
+
+    const histogram_t* jitter = control_task_get_jitter();
+
+    fprintf(
+        console->out,
+        "Control tick jitter over %u ticks: min %uus, avg %uus, p99 %uus, max %uus\n",
+        jitter->count,
+        jitter->count > 0 ? jitter->min : 0,
+        histogram_avg(jitter),
+        histogram_percentile(jitter, 99),
+        jitter->max
+    );
+
+    return CMD_OK;
+}
+
+static const command_t cmd_system_jitter_s = {
+    .command = "jitter",
+    .help = "Show control tick jitter, or \"reset\" it",
+    .alias = 'j',
+    .func = &cmd_system_jitter,
+    .subcommands = { NULL },
+};
+
+static command_err_t cmd_system_detectors(int argc, char** argv, console_t* console) {
+    if (argc == 1 && !strcasecmp(argv[0], "reset")) {
+        arousal_detector_reset_stats();
+        shadow_detector_reset_stats();
+        return CMD_OK;
+    } else if (argc != 0) {
+        return CMD_ARG_ERR;
+    }
+
+    fprintf(console->out, "ID  Detector     Ticks      Avg ns   Max ns\n");
+
+    for (int mode = DetectPeaks; mode <= DetectBaseline; mode++) {
+        const arousal_detector_stats_t* stats = arousal_detector_get_stats(mode);
+
+        fprintf(
+            console->out,
+            "%-3d %-12s %-10u %-8u %u%s\n",
+            mode,
+            arousal_detector_get(mode)->name,
+            stats->calls,
+            stats->calls > 0 ? perf_counter_to_ns(stats->total_cycles / stats->calls) : 0,
+            perf_counter_to_ns(stats->max_cycles),
+            mode == Config.arousal_detector ? " *" : ""
+        );
+    }
+
+    if (shadow_detector_enabled()) {
+        const arousal_detector_stats_t* stats = shadow_detector_get_stats();
+
+        fprintf(
+            console->out,
+            "Shadow (%s): %u ticks, avg %uns, max %uns per tick, %d denials\n",
+            arousal_detector_get(Config.shadow_arousal_detector)->name,
+            stats->calls,
+            stats->calls > 0 ? perf_counter_to_ns(stats->total_cycles / stats->calls) : 0,
+            perf_counter_to_ns(stats->max_cycles),
+            shadow_detector_get_denial_count()
+        );
+    }
+
+    return CMD_OK;
+}
+
+static const command_t cmd_system_detectors_s = {
+    .command = "detectors",
+    .help = "Show arousal detector CPU cost, or \"reset\" it",
+    .alias = 'd',
+    .func = &cmd_system_detectors,
+    .subcommands = { NULL },
+};
+
+static command_err_t cmd_system_perf(int argc, char** argv, console_t* console) {
+    if (argc == 1 && !strcasecmp(argv[0], "reset")) {
+        perf_stats_reset();
+        return CMD_OK;
+    } else if (argc != 0) {
+        return CMD_ARG_ERR;
+    }
+
+    fprintf(console->out, "Stage          Count      Avg us   P99 us   Max us\n");
+
+    for (int stage = 0; stage < _PERF_STAGE_MAX; stage++) {
+        const histogram_t* hist = perf_stats_get(stage);
+
+        fprintf(
+            console->out,
+            "%-14s %-10u %-8u %-8u %u\n",
+            perf_stats_stage_name(stage),
+            hist->count,
+            histogram_avg(hist),
+            histogram_percentile(hist, 99),
+            hist->max
+        );
+    }
+
+    return CMD_OK;
+}
+
+static const command_t cmd_system_perf_s = {
+    .command = "perf",
+    .help = "Show per-stage control and main loop timings, or \"reset\" them",
+    .alias = 'p',
+    .func = &cmd_system_perf,
+    .subcommands = { NULL },
+};
+
 static const command_t cmd_system_s = {
     .command = "system",
     .help = "System control",
@@ -151,7 +296,11 @@ static const command_t cmd_system_s = {
         &cmd_system_time_s,
         &cmd_system_color_s,
         &cmd_system_screenshot_s,
+        &cmd_system_blackbox_s,
         &cmd_system_tasklist_s,
+        &cmd_system_jitter_s,
+        &cmd_system_detectors_s,
+        &cmd_system_perf_s,
         NULL,
     },
 };
@@ -3,7 +3,7 @@
 #include <string.h>
 
 // Initialize the global Config struct with its private members:
-config_t Config = {
+CONTROL_LOCAL config_t Config = {
     ._filename = "",
 };
 
@@ -42,11 +42,29 @@ CONFIG_DEFS {
     CFG_NUMBER(max_additional_delay, 1000);
     CFG_NUMBER(minimum_on_time, 1000);
     CFG_NUMBER(pressure_smoothing, 5);
+    CFG_ENUM(pressure_filter, pressure_filter_t, FilterAverage);
     CFG_NUMBER(sensitivity_threshold, 600);
+    CFG_BOOL(auto_threshold, false);
+    CFG_NUMBER(auto_threshold_interval_s, 30);
     CFG_NUMBER(motor_ramp_time_s, 30);
     CFG_NUMBER(update_frequency_hz, 50);
+    CFG_NUMBER(pressure_sample_rate_hz, 0);
     CFG_NUMBER(sensor_sensitivity, 128);
+    CFG_BOOL(auto_sensor_sensitivity, false);
+    CFG_BOOL(sensor_fault_rejection, false);
     CFG_BOOL(use_average_values, false);
+    CFG_ENUM(arousal_detector, arousal_detector_mode_t, DetectPeaks);
+    CFG_BOOL(use_shadow_detector, false);
+    CFG_ENUM(shadow_arousal_detector, arousal_detector_mode_t, DetectPeaks);
+    CFG_NUMBER(shadow_sensitivity_threshold, 0);
+    CFG_NUMBER(edge_prediction_ms, 0);
+    CFG_NUMBER(baseline_window_ms, 0);
+    CFG_BOOL(spectrum_analysis, false);
+    CFG_ENUM(recording_format, recording_format_t, RecordCSV);
+    CFG_NUMBER(black_box_seconds, 0);
+    CFG_NUMBER(recording_segment_minutes, 0);
+    CFG_NUMBER(recording_segment_kb, 0);
+    CFG_NUMBER(recording_retention_mb, 0);
 
     // Vibration Settings
     CFG_ENUM(vibration_mode, vibration_mode_t, RampStop);
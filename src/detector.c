@@ -0,0 +1,319 @@
+#include "detector.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+void detector_params_from_config(detector_params_t* params) {
+    params->mode = Config.arousal_detector;
+    params->sensitivity_threshold = Config.sensitivity_threshold;
+    params->update_frequency_hz = Config.update_frequency_hz;
+    params->use_average_values = Config.use_average_values;
+    params->pressure_smoothing = Config.pressure_smoothing;
+    params->pressure_filter = Config.pressure_filter;
+    params->baseline_window_ms = Config.baseline_window_ms;
+    params->clench_pressure_sensitivity = Config.clench_pressure_sensitivity;
+    params->clench_threshold_2_orgasm = Config.clench_threshold_2_orgasm;
+    params->max_clench_duration = Config.max_clench_duration;
+    params->clench_detector_in_edging = Config.clench_detector_in_edging;
+}
+
+void detector_init(detector_t* detector, const detector_params_t* params) {
+    memset(detector, 0, sizeof(detector_t));
+    detector->params = *params;
+    detector->clench_pressure_threshold = CLENCH_THRESHOLD_INITIAL;
+    filter_init(
+        &detector->pressure_filter,
+        detector_filter_type(params->pressure_filter),
+        params->pressure_smoothing
+    );
+}
+
+uint16_t detector_baseline_window(const detector_params_t* params) {
+    if (params->baseline_window_ms <= 0 || params->update_frequency_hz <= 0) {
+        return 0;
+    }
+
+    long ticks = (long)params->baseline_window_ms * params->update_frequency_hz / 1000;
+    return ticks < 1 ? 1 : ticks > SLIDING_MINMAX_CAPACITY ? SLIDING_MINMAX_CAPACITY : ticks;
+}
+
+filter_type_t detector_filter_type(pressure_filter_t filter) {
+    switch (filter) {
+    case FilterEMA: return FILTER_EMA;
+    case FilterMedian: return FILTER_MEDIAN;
+    case FilterLowpass: return FILTER_LOWPASS;
+    case FilterAverage:
+    default: return FILTER_MOVING_AVERAGE;
+    }
+}
+
+static void detector_update_clench(detector_t* detector, long p_check, bool permit_orgasm) {
+    const detector_params_t* params = &detector->params;
+    uint16_t window = detector_baseline_window(params);
+
+    if (window > 0) {
+        if (window != detector->clench_max.window) {
+            sliding_minmax_init(&detector->clench_max, SLIDING_MAX, window);
+        }
+
+        sliding_minmax_push(&detector->clench_max, p_check);
+    }
+
+    // detect muscle clenching.  Used in Edging+orgasm routine to detect an orgasm
+    // Can also be used as an other method to compliment detecting edging
+
+    // raise clench threshold to pressure - 1/2 sensitivity
+    if (p_check >= (detector->clench_pressure_threshold + params->clench_pressure_sensitivity)) {
+        detector->clench_pressure_threshold = (p_check - (params->clench_pressure_sensitivity / 2));
+    }
+
+    // Start counting clench time if pressure over threshold
+    if (p_check >= detector->clench_pressure_threshold) {
+        detector->clench_duration += 1;
+
+        // Orgasm detected
+        if (detector->clench_duration >= params->clench_threshold_2_orgasm && permit_orgasm) {
+            detector->detected_orgasm = true;
+            detector->clench_duration = 0;
+        }
+
+        // ajust arousal if Clench_detector in Edge is turned on
+        if (params->clench_detector_in_edging) {
+            if (detector->clench_duration > (params->clench_threshold_2_orgasm / 2)) {
+                detector->arousal += 5;
+            }
+        }
+
+        // desensitize clench threshold when clench too long. this is to stop arousal from going up
+        if (detector->clench_duration >= params->max_clench_duration) {
+            detector->clench_pressure_threshold += 10;
+            detector->clench_duration = params->max_clench_duration;
+        }
+
+        // when not clenching lower clench time and decay clench threshold
+    } else {
+        detector->clench_duration -= 5;
+
+        if (detector->clench_duration <= 0) {
+            detector->clench_duration = 0;
+
+            if (window > 0) {
+                // Fall back to where the highest pressure in the window would have raised it, but
+                // still no lower than pressure + 1/2 sensitivity:
+                long settled = p_check + (params->clench_pressure_sensitivity / 2);
+                long peak = (long)sliding_minmax_get(&detector->clench_max) -
+                            (params->clench_pressure_sensitivity / 2);
+                long target = peak > settled ? peak : settled;
+
+                if (target < detector->clench_pressure_threshold) {
+                    detector->clench_pressure_threshold = target;
+                }
+
+                return;
+            }
+
+            // clench pressure threshold value decays over time to a min of pressure + 1/2
+            // sensitivity
+            if ((p_check + (params->clench_pressure_sensitivity / 2)) <
+                detector->clench_pressure_threshold) {
+                detector->clench_pressure_threshold =
+                    q16_scale(detector->clench_pressure_threshold, CLENCH_THRESHOLD_DECAY);
+            }
+        }
+    } // END of clench detector
+}
+
+void detector_update(detector_t* detector, uint16_t pressure, bool permit_orgasm) {
+    const detector_params_t* params = &detector->params;
+
+    // Start the filter over when its settings change:
+    filter_type_t filter_type = detector_filter_type(params->pressure_filter);
+    uint16_t window = params->pressure_smoothing > 0 ? params->pressure_smoothing : 1;
+    filter_t* filter = &detector->pressure_filter;
+    if (filter_type != filter->type || window != filter->window) {
+        filter_init(filter, filter_type, window);
+    }
+
+    long p_avg = filter_update(filter, pressure);
+    long p_check = params->use_average_values ? p_avg : pressure;
+
+    // Switch detectors when the mode changes, starting the new one fresh:
+    const arousal_detector_t* arousal_detector = arousal_detector_get(params->mode);
+    if (arousal_detector != detector->arousal_detector) {
+        arousal_detector->start(&detector->arousal_state);
+        detector->arousal_detector = arousal_detector;
+    }
+
+    // Decay and increment arousal
+    detector->arousal = arousal_detector_tick(
+        arousal_detector, &detector->arousal_state, params, p_check, detector->arousal
+    );
+
+    detector_update_clench(detector, p_check, permit_orgasm);
+}
+
+void detector_rebase(detector_t* detector, uint16_t pressure) {
+    const detector_params_t* params = &detector->params;
+    uint16_t window = params->pressure_smoothing > 0 ? params->pressure_smoothing : 1;
+
+    filter_init(&detector->pressure_filter, detector_filter_type(params->pressure_filter), window);
+
+    if (detector->arousal_detector != NULL) {
+        detector->arousal_detector->rebase(&detector->arousal_state, pressure);
+    }
+
+    // Where the clench threshold settles at rest:
+    detector->clench_pressure_threshold = pressure + (params->clench_pressure_sensitivity / 2);
+    detector->clench_duration = 0;
+    detector->clench_max.window = 0;
+}
+
+uint16_t detector_get_average_pressure(const detector_t* detector) {
+    int32_t average = filter_get(&detector->pressure_filter);
+    return average < 0 ? 0 : average > UINT16_MAX ? UINT16_MAX : average;
+}
+
+// Batch
+
+#define BATCH_ARRAYS 12
+
+int detector_batch_init(detector_batch_t* batch, size_t count) {
+    int32_t* block = (int32_t*)calloc(BATCH_ARRAYS * count, sizeof(int32_t));
+    if (block == NULL) {
+        return -1;
+    }
+
+    int32_t** arrays[BATCH_ARRAYS] = {
+        &batch->peak_threshold,
+        &batch->clench_pressure_sensitivity,
+        &batch->clench_pressure_half_sensitivity,
+        &batch->clench_threshold_2_orgasm,
+        &batch->clench_edging_threshold,
+        &batch->max_clench_duration,
+        &batch->last_value,
+        &batch->peak_start,
+        &batch->arousal,
+        &batch->clench_pressure_threshold,
+        &batch->clench_duration,
+        &batch->detected_orgasm,
+    };
+
+    for (size_t i = 0; i < BATCH_ARRAYS; i++) {
+        *arrays[i] = block + i * count;
+    }
+
+    batch->count = count;
+
+    detector_params_t params;
+    detector_params_from_config(&params);
+
+    for (size_t lane = 0; lane < count; lane++) {
+        detector_batch_set_params(batch, lane, &params);
+    }
+
+    detector_batch_reset(batch);
+    return 0;
+}
+
+void detector_batch_free(detector_batch_t* batch) {
+    // All arrays share the block allocated for the first one.
+    free(batch->peak_threshold);
+    memset(batch, 0, sizeof(detector_batch_t));
+}
+
+void detector_batch_set_params(
+    detector_batch_t* batch, size_t lane, const detector_params_t* params
+) {
+    batch->peak_threshold[lane] = params->sensitivity_threshold / 10;
+    batch->clench_pressure_sensitivity[lane] = params->clench_pressure_sensitivity;
+    batch->clench_pressure_half_sensitivity[lane] = params->clench_pressure_sensitivity / 2;
+    batch->clench_threshold_2_orgasm[lane] = params->clench_threshold_2_orgasm;
+    batch->clench_edging_threshold[lane] =
+        params->clench_detector_in_edging ? params->clench_threshold_2_orgasm / 2 : INT32_MAX;
+    batch->max_clench_duration[lane] = params->max_clench_duration;
+}
+
+void detector_batch_reset(detector_batch_t* batch) {
+    for (size_t i = 0; i < batch->count; i++) {
+        batch->last_value[i] = 0;
+        batch->peak_start[i] = 0;
+        batch->arousal[i] = 0;
+        batch->clench_pressure_threshold[i] = CLENCH_THRESHOLD_INITIAL;
+        batch->clench_duration[i] = 0;
+        batch->detected_orgasm[i] = 0;
+    }
+}
+
+// The same steps as the peak detector and detector_update_clench(), with every branch turned into
+// a select. Arousal is kept as a uint16_t would be, and both decays are done in 32 bits, which is
+// exact for the non-negative 16 bit values they are applied to.
+void detector_batch_update(detector_batch_t* batch, const uint16_t* pressure, bool permit_orgasm) {
+    const int32_t permit = permit_orgasm;
+    const size_t count = batch->count;
+
+    const int32_t* peak_threshold = batch->peak_threshold;
+    const int32_t* clench_pressure_sensitivity = batch->clench_pressure_sensitivity;
+    const int32_t* clench_pressure_half_sensitivity =
+        batch->clench_pressure_half_sensitivity;
+    const int32_t* clench_threshold_2_orgasm = batch->clench_threshold_2_orgasm;
+    const int32_t* clench_edging_threshold = batch->clench_edging_threshold;
+    const int32_t* max_clench_duration = batch->max_clench_duration;
+
+    int32_t* last_value = batch->last_value;
+    int32_t* peak_start = batch->peak_start;
+    int32_t* arousal = batch->arousal;
+    int32_t* clench_pressure_threshold = batch->clench_pressure_threshold;
+    int32_t* clench_duration = batch->clench_duration;
+    int32_t* detected_orgasm = batch->detected_orgasm;
+
+    // Lanes never alias each other or the input; without this GCC gives up on the alias checks.
+#pragma GCC ivdep
+    for (size_t i = 0; i < count; i++) {
+        int32_t p = pressure[i];
+
+        // Peak detector:
+        int32_t a = ((uint32_t)arousal[i] * (uint32_t)AROUSAL_DECAY) >> Q16_SHIFT;
+        int32_t last = last_value[i];
+        int32_t start = peak_start[i];
+        int32_t falling = p < last;
+        int32_t big = falling & (last > start) & (last - start >= peak_threshold[i]);
+
+        a = (a + (big ? last - start : 0)) & 0xFFFF;
+        start = big ? p : start;
+        start = (falling & (p < start)) ? p : start;
+
+        last_value[i] = p;
+        peak_start[i] = start;
+
+        // Clench detector:
+        int32_t threshold = clench_pressure_threshold[i];
+        int32_t duration = clench_duration[i];
+
+        threshold = (p >= threshold + clench_pressure_sensitivity[i])
+                        ? p - clench_pressure_half_sensitivity[i]
+                        : threshold;
+
+        int32_t clenched = p >= threshold;
+
+        int32_t clench_duration_on = duration + 1;
+        int32_t orgasm = (clench_duration_on >= clench_threshold_2_orgasm[i]) & permit;
+        clench_duration_on = orgasm ? 0 : clench_duration_on;
+        int32_t bump = clench_duration_on > clench_edging_threshold[i];
+        int32_t too_long = clench_duration_on >= max_clench_duration[i];
+        int32_t threshold_on = too_long ? threshold + 10 : threshold;
+        clench_duration_on = too_long ? max_clench_duration[i] : clench_duration_on;
+
+        int32_t clench_duration_off = duration - 5;
+        int32_t settled = clench_duration_off <= 0;
+        clench_duration_off = settled ? 0 : clench_duration_off;
+        int32_t decayed =
+            ((uint32_t)threshold * (uint32_t)CLENCH_THRESHOLD_DECAY) >> Q16_SHIFT;
+        int32_t decay = settled & (p + clench_pressure_half_sensitivity[i] < threshold);
+        int32_t threshold_off = decay ? decayed : threshold;
+
+        clench_pressure_threshold[i] = clenched ? threshold_on : threshold_off;
+        clench_duration[i] = clenched ? clench_duration_on : clench_duration_off;
+        detected_orgasm[i] |= clenched & orgasm;
+        arousal[i] = (a + ((clenched & bump) ? 5 : 0)) & 0xFFFF;
+    }
+}
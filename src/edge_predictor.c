@@ -0,0 +1,86 @@
+#include "edge_predictor.h"
+#include "arousal_detector.h"
+#include "util/fixed.h"
+#include <string.h>
+
+void edge_predictor_init(edge_predictor_t* predictor) {
+    memset(predictor, 0, sizeof(edge_predictor_t));
+}
+
+uint32_t edge_predictor_window(int update_frequency_hz) {
+    long updates = (long)EDGE_PREDICTOR_WINDOW_MS * update_frequency_hz / 1000;
+    return updates < 1 ? 1 : updates;
+}
+
+static void edge_predictor_forget_oldest(edge_predictor_t* predictor) {
+    for (int i = 1; i < predictor->peak_count; i++) {
+        predictor->peak_update[i - 1] = predictor->peak_update[i];
+        predictor->peak_arousal[i - 1] = predictor->peak_arousal[i];
+    }
+
+    predictor->peak_count--;
+}
+
+void edge_predictor_update(edge_predictor_t* predictor, uint16_t arousal, int update_frequency_hz) {
+    // Anything over the decayed arousal of the last update was added by a peak. Consecutive
+    // updates that add to it, like a held clench, are one peak.
+    bool rising = arousal > arousal_detector_decay(predictor->last_arousal);
+    predictor->updates++;
+    predictor->last_arousal = arousal;
+
+    if (rising) {
+        if (!predictor->rising || predictor->peak_count == 0) {
+            if (predictor->peak_count == EDGE_PREDICTOR_PEAKS) {
+                edge_predictor_forget_oldest(predictor);
+            }
+
+            predictor->peak_count++;
+        }
+
+        predictor->peak_update[predictor->peak_count - 1] = predictor->updates;
+        predictor->peak_arousal[predictor->peak_count - 1] = arousal;
+    }
+
+    predictor->rising = rising;
+
+    uint32_t window = edge_predictor_window(update_frequency_hz);
+    while (predictor->peak_count > 0 && predictor->updates - predictor->peak_update[0] > window) {
+        edge_predictor_forget_oldest(predictor);
+    }
+}
+
+int edge_predictor_updates_to_edge(const edge_predictor_t* predictor, int threshold, int horizon) {
+    if (predictor->peak_count < EDGE_PREDICTOR_PEAKS) {
+        return -1;
+    }
+
+    int64_t t0 = predictor->peak_update[0];
+    int64_t t1 = predictor->peak_update[1];
+    int64_t t2 = predictor->peak_update[2];
+    int64_t a0 = predictor->peak_arousal[0];
+    int64_t a1 = predictor->peak_arousal[1];
+    int64_t a2 = predictor->peak_arousal[2];
+
+    if (a1 <= a0 || a2 <= a1) {
+        return -1;
+    }
+
+    // Newton form of the quadratic through the three peaks, in Q16.16 per update:
+    // a(t) = a2 + slope * (t - t2) + curvature * (t - t2) * (t - t1)
+    int64_t slope_before = (a1 - a0) * Q16_ONE / (t1 - t0);
+    int64_t slope = (a2 - a1) * Q16_ONE / (t2 - t1);
+    int64_t curvature = (slope - slope_before) / (t2 - t0);
+
+    // The next peak is expected one peak interval after the last one. Arousal only climbs on
+    // peaks, so that is where it would cross. Once that time has passed without a peak, the climb
+    // has stalled.
+    int64_t dt = t2 - t1;
+    int64_t projected = a2 * Q16_ONE + slope * dt + curvature * dt * (dt + t2 - t1);
+    int64_t updates = t2 + dt - predictor->updates;
+
+    if (projected > (int64_t)threshold * Q16_ONE && updates >= 0 && updates <= horizon) {
+        return updates;
+    }
+
+    return -1;
+}
@@ -11,7 +11,12 @@
 #include "freertos/task.h"
 #include "orgasm_control.h"
 #include "polyfill.h"
+#include "system/black_box.h"
+#include "system/control_snapshot.h"
+#include "system/control_task.h"
 #include "system/http_server.h"
+#include "system/perf_stats.h"
+#include "system/recorder.h"
 #include "ui/ui.h"
 #include "util/i18n.h"
 #include "version.h"
@@ -37,7 +42,11 @@ void resetSD() {
 
 static void orgasm_task(void* args) {
     // for (;;) {
-    orgasm_control_tick();
+    // Control updates run in the control task, this only drains samples to the loggers.
+    orgasm_control_log_tick();
+    recorder_tick();
+    black_box_tick();
+    control_snapshot_tick();
 
     // vTaskDelay(1);
     // }
@@ -85,15 +94,40 @@ static void loop_task(void* args) {
         api_broadcast_readings();
     }
 
+    api_broadcast_events();
+    api_broadcast_spectrum();
+
     // Tick and see if we need to save config:
     config_enqueue_save(-1);
-
-    vTaskDelay(1);
     // }
 }
 
 static void accessory_driver_task(void* args) {
+    orgasm_control_subscriber_t subscriber;
+    orgasm_control_event_t event;
+
+    orgasm_control_subscribe(&subscriber);
+
     while (true) {
+        uint32_t start = perf_stats_begin_us();
+        bool broadcast = false;
+
+        while (orgasm_control_next_event(&subscriber, &event)) {
+            if (event.type == OC_EVENT_AROUSAL) {
+                accessory_driver_broadcast_arousal(event.value);
+                bluetooth_driver_broadcast_arousal(event.value);
+                broadcast = true;
+            } else if (event.type == OC_EVENT_MOTOR_SPEED) {
+                accessory_driver_broadcast_speed(event.value);
+                bluetooth_driver_broadcast_speed(event.value);
+                broadcast = true;
+            }
+        }
+
+        if (broadcast) {
+            perf_stats_record_us(PERF_STAGE_BROADCAST, start);
+        }
+
         bluetooth_driver_tick();
         vTaskDelay(1);
     }
@@ -106,10 +140,24 @@ static void main_task(void* args) {
     ui_reset_idle_timer();
 
     for (;;) {
+        uint32_t start = perf_stats_begin_us();
         loop_task(NULL);
+        perf_stats_record_us(PERF_STAGE_MAIN_API, start);
+
+        start = perf_stats_begin_us();
         hal_task(NULL);
+        perf_stats_record_us(PERF_STAGE_MAIN_HAL, start);
+
+        start = perf_stats_begin_us();
         ui_task(NULL);
+        perf_stats_record_us(PERF_STAGE_MAIN_UI, start);
+
+        start = perf_stats_begin_us();
         orgasm_task(NULL);
+        perf_stats_record_us(PERF_STAGE_MAIN_LOGGER, start);
+
+        // Yield outside of the timed stages:
+        vTaskDelay(1);
     }
 }
 
@@ -153,6 +201,7 @@ void app_main() {
         ui_set_icon(UI_ICON_BT, -1);
     }
 
+    control_task_init();
     xTaskCreate(accessory_driver_task, "ACCESSORY", 1024 * 4, NULL, tskIDLE_PRIORITY, NULL);
     xTaskCreate(main_task, "MAIN", 1024 * 8, NULL, tskIDLE_PRIORITY + 1, NULL);
 }
\ No newline at end of file
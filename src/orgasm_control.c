@@ -1,17 +1,29 @@
 #include "orgasm_control.h"
-#include "accessory_driver.h"
-#include "bluetooth_driver.h"
+#include "auto_threshold.h"
+#include "detector.h"
+#include "edge_predictor.h"
 #include "config.h"
 #include "eom-hal.h"
 #include "esp_log.h"
 #include "esp_timer.h"
+#include "pressure_calibration.h"
+#include "sensor_guard.h"
+#include "shadow_detector.h"
+#include "spectrum.h"
+#include "system/control_snapshot.h"
+#include "system/perf_stats.h"
 #include "system/websocket_handler.h"
 #include "ui/toast.h"
 #include "ui/ui.h"
+#include "util/command_queue.h"
+#include "util/decimator.h"
+#include "util/fixed.h"
 #include "util/i18n.h"
-#include "util/running_average.h"
+#include "util/ring_buffer.h"
 #include <math.h>
+#include <stdatomic.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
@@ -24,18 +36,21 @@ static const char* orgasm_output_mode_str[] = {
     "LOCKOUT_POST_MODE",
 };
 
-static struct {
-    unsigned long last_update_ms;
-    running_average_t* average;
-    uint16_t last_value;
+static const char* orgasm_control_event_type_strs[] = {
+    "update",         "arousal",          "motorSpeed",   "edge",
+    "denial",         "orgasm",           "modeChange",   "sensorFault",
+    "detectorChange", "thresholdSettled", "shadowDenial", "shadowOrgasm",
+};
+
+static CONTROL_LOCAL struct {
+    detector_t detector;
+    edge_predictor_t predictor;
     uint16_t pressure_value;
-    uint16_t peak_start;
-    uint16_t arousal;
     uint8_t update_flag;
     uint8_t denial_count;
 } arousal_state;
 
-static struct {
+static CONTROL_LOCAL struct {
     orgasm_output_mode_t output_mode;
     vibration_mode_t vibration_mode;
     unsigned long motor_stop_time;
@@ -45,26 +60,158 @@ static struct {
     int twitch_count;
     uint8_t control_motor;
     uint8_t prev_control_motor;
-    float motor_speed;
+    q16_t motor_speed;
 } output_state;
 
-static struct {
-    // File Writer
-    unsigned long recording_start_ms;
-    FILE* logfile;
+static CONTROL_LOCAL struct {
+    orgasm_control_clock_t now;
+
+    // Timestamp captured once at the start of each update, so every decision in a tick agrees on
+    // the time.
+    unsigned long tick_ms;
+} clock_state;
+
+static CONTROL_LOCAL struct {
+    ring_buffer_t ring;
+    orgasm_control_sample_t storage[ORGASM_CONTROL_SAMPLE_RING_SIZE];
+} sample_state;
+
+static CONTROL_LOCAL struct {
+    ring_buffer_t ring;
+    orgasm_control_event_t storage[ORGASM_CONTROL_EVENT_RING_SIZE];
+    ring_buffer_t state_ring;
+    orgasm_control_event_t state_storage[ORGASM_CONTROL_STATE_EVENT_RING_SIZE];
+
+    // What subscribers were last told, to publish changes only:
+    orgasm_output_mode_t output_mode;
+    uint16_t arousal;
+    uint8_t motor_speed;
+    uint8_t denial_count;
+    bool over_threshold;
+    bool detected_orgasm;
+    sensor_fault_t sensor_fault;
+    const arousal_detector_t* arousal_detector;
+    uint8_t shadow_denial_count;
+    uint8_t shadow_orgasm_count;
+} event_state;
+
+static CONTROL_LOCAL struct {
+    bool active;
+    session_stats_t stats;
+
+    ring_buffer_t finished;
+    session_stats_t storage[ORGASM_CONTROL_SESSION_RING_SIZE];
+} session_state;
+
+static CONTROL_LOCAL struct {
+    ring_buffer_t ring;
+    orgasm_control_snapshot_t storage[2];
+    ring_buffer_reader_t reader;
+
+    // Last snapshot published, to tell when the next one is due.
+    orgasm_control_snapshot_t last;
+    unsigned long last_ms;
+} snapshot_state;
+
+// How long the detectors are held on the new pressure scale after a sensor sensitivity change,
+// covering readings taken while the new setting reaches the sensor.
+#define SENSOR_SENSITIVITY_SETTLE_MS 100
+
+static CONTROL_LOCAL struct {
+    pressure_calibration_t calibration;
+    uint32_t samples;
+
+    // Sensitivity the detectors are running on, and when it last changed.
+    uint8_t sensitivity;
+    unsigned long sensitivity_changed_ms;
+    bool settling;
+} calibration_state;
+
+typedef enum orgasm_control_command_type {
+    OC_COMMAND_SET_OUTPUT_MODE,
+    OC_COMMAND_PAUSE_CONTROL,
+    OC_COMMAND_RESUME_CONTROL,
+    OC_COMMAND_PERMIT_ORGASM,
+    OC_COMMAND_LOCK_MENU,
+    OC_COMMAND_SET_THRESHOLD,
+    OC_COMMAND_INCREMENT_THRESHOLD,
+} orgasm_control_command_type_t;
+
+typedef struct orgasm_control_command {
+    orgasm_control_command_type_t type;
+    int value;
+} orgasm_control_command_t;
+
+// Enough for a burst of encoder clicks between two updates.
+#define ORGASM_CONTROL_COMMAND_QUEUE_SIZE 16
+
+static CONTROL_LOCAL struct {
+    // Changes asked for by other tasks. The control task applies them at the start of its next
+    // update, so none lands halfway through one.
+    command_queue_t queue;
+    orgasm_control_command_t storage[ORGASM_CONTROL_COMMAND_QUEUE_SIZE];
+    _Atomic uint32_t seqs[ORGASM_CONTROL_COMMAND_QUEUE_SIZE];
+
+    // The other way round: work the control task leaves to orgasm_control_log_tick(), as config
+    // saves and the sensor HAL are shared with the UI, console and API tasks.
+    _Atomic bool save_config;
+    // -1 when there is no change waiting.
+    _Atomic int sensor_sensitivity;
+} command_state;
+
+static CONTROL_LOCAL struct {
+    auto_threshold_t controller;
+    bool active;
+
+    // Threshold the session started with, or the user last set, to fall back to if the
+    // controller never settles.
+    int start_threshold;
+    bool manual_change;
+
+    // What the controller last applied and denials it has seen, to spot changes since.
+    int applied;
+    uint8_t denial_count;
+} threshold_state;
+
+static CONTROL_LOCAL struct {
+    sensor_guard_t guard;
+    bool enabled;
+} guard_state;
+
+static CONTROL_LOCAL struct {
+    spectrum_t spectrum;
+    bool enabled;
+
+    ring_buffer_t ring;
+    spectrum_frame_t storage[ORGASM_CONTROL_SPECTRUM_RING_SIZE];
+} spectrum_state;
+
+static CONTROL_LOCAL struct {
+    decimator_t decimator;
+    uint32_t raw_count;
+    ring_buffer_t raw_ring;
+    orgasm_control_raw_sample_t raw_storage[ORGASM_CONTROL_RAW_RING_SIZE];
+} acquisition_state;
+
+static CONTROL_LOCAL struct {
+    // Classic serial output, event log and session log. Recordings are in system/recorder.
+    ring_buffer_reader_t reader;
+    orgasm_control_subscriber_t events;
+    ring_buffer_reader_t sessions;
 } logger_state;
 
-static struct {
+static CONTROL_LOCAL struct {
     //  Post Orgasm Clench variables
     long clench_pressure_threshold; //  4096?
     int clench_duration;
 
     // Autoedging Time and Post-Orgasm varables
-    long auto_edging_start_millis;
-    long post_orgasm_start_millis;
+    // On the control clock, which may have wrapped past them after a restore, so only ever
+    // compared by elapsed time. Zero means not started.
+    unsigned long auto_edging_start_millis;
+    unsigned long post_orgasm_start_millis;
     long post_orgasm_duration_millis;
     oc_bool_t menu_is_locked;
-    oc_bool_t detected_orgasm;
     int post_orgasm_duration_seconds;
 } post_orgasm_state;
 
@@ -77,13 +224,26 @@ static struct {
         }                                                                                          \
     }
 
-void orgasm_control_init(void) {
-    output_state.output_mode = OC_MANUAL_CONTROL;
-    output_state.vibration_mode = Config.vibration_mode;
-    output_state.edge_time_out = 10000;
-    post_orgasm_state.clench_pressure_threshold = 4096;
+static unsigned long orgasm_control_default_clock(void) {
+    return esp_timer_get_time() / 1000UL;
+}
+
+static unsigned long orgasm_control_now(void) {
+    return clock_state.now != NULL ? clock_state.now() : orgasm_control_default_clock();
+}
+
+void orgasm_control_set_clock(orgasm_control_clock_t clock) {
+    clock_state.now = clock;
+}
+
+uint8_t orgasm_control_get_decimation_ratio(void) {
+    if (Config.update_frequency_hz <= 0 ||
+        Config.pressure_sample_rate_hz <= Config.update_frequency_hz) {
+        return 1;
+    }
 
-    running_average_init(&arousal_state.average, Config.pressure_smoothing);
+    int ratio = Config.pressure_sample_rate_hz / Config.update_frequency_hz;
+    return ratio > DECIMATOR_MAX_RATIO ? DECIMATOR_MAX_RATIO : ratio;
 }
 
 // Rename to get_vibration_mode_controller();
@@ -100,112 +260,329 @@ static const vibration_mode_controller_t* orgasm_control_getVibrationMode() {
     }
 }
 
-/**
- * Main orgasm detection / edging algorithm happens here.
- * This happens with a default update frequency of 50Hz.
- */
-static void orgasm_control_updateArousal() {
-    // Decay stale arousal value:
-    update_check(arousal_state.arousal, arousal_state.arousal * 0.99);
-
-    // Acquire new pressure and take average:
-    update_check(arousal_state.pressure_value, eom_hal_get_pressure_reading());
-    running_average_add_value(arousal_state.average, arousal_state.pressure_value);
-    long p_avg = running_avergae_get_average(arousal_state.average);
-    long p_check = Config.use_average_values ? p_avg : arousal_state.pressure_value;
-
-    // Increment arousal
-    if (p_check < arousal_state.last_value) {                      // falling edge of peak
-        if (arousal_state.last_value > arousal_state.peak_start) { // first tick past peak?
-            if (arousal_state.last_value - arousal_state.peak_start >=
-                Config.sensitivity_threshold / 10) { // big peak
-
-                update_check(
-                    arousal_state.arousal,
-                    arousal_state.arousal + (arousal_state.last_value - arousal_state.peak_start)
-                );
-
-                arousal_state.peak_start = p_check;
-            }
-        }
+static void orgasm_control_applyOutputMode(orgasm_output_mode_t control) {
+    orgasm_output_mode_t old = output_state.output_mode;
+    output_state.output_mode = control;
+    output_state.control_motor = control != OC_MANUAL_CONTROL;
+
+    if (old == OC_MANUAL_CONTROL) {
+        const vibration_mode_controller_t* controller = orgasm_control_getVibrationMode();
+        controller->start();
+    } else if (control == OC_MANUAL_CONTROL) {
+        const vibration_mode_controller_t* controller = orgasm_control_getVibrationMode();
+        controller->stop();
+    }
+}
+
+static void orgasm_control_applyPauseControl() {
+    output_state.prev_control_motor = output_state.control_motor;
+    output_state.control_motor = OC_MANUAL_CONTROL;
+}
+
+static void orgasm_control_applyPermitOrgasm(int seconds) {
+    arousal_state.detector.detected_orgasm = false;
+    orgasm_control_applyOutputMode(OC_ORGASM_MODE);
+    post_orgasm_state.auto_edging_start_millis =
+        clock_state.tick_ms - (Config.auto_edging_duration_minutes * 60 * 1000);
+    post_orgasm_state.post_orgasm_duration_seconds = seconds;
+}
+
+static void orgasm_control_applyThreshold(int threshold) {
+    Config.sensitivity_threshold = threshold >= 0 ? threshold : 0;
+
+    // auto_threshold saves once its session ends:
+    if (!threshold_state.active) {
+        atomic_store_explicit(&command_state.save_config, true, memory_order_release);
+    }
+}
 
-        if (p_check < arousal_state.peak_start) {
-            // run this value down to a new minimum after a peak detected.
-            arousal_state.peak_start = p_check;
+static void orgasm_control_applyCommands() {
+    orgasm_control_command_t command;
+
+    while (command_queue_pop(&command_state.queue, &command)) {
+        switch (command.type) {
+        case OC_COMMAND_SET_OUTPUT_MODE: orgasm_control_applyOutputMode(command.value); break;
+        case OC_COMMAND_PAUSE_CONTROL: orgasm_control_applyPauseControl(); break;
+        case OC_COMMAND_RESUME_CONTROL:
+            output_state.control_motor = output_state.prev_control_motor;
+            break;
+        case OC_COMMAND_PERMIT_ORGASM: orgasm_control_applyPermitOrgasm(command.value); break;
+        case OC_COMMAND_LOCK_MENU: post_orgasm_state.menu_is_locked = command.value; break;
+        case OC_COMMAND_SET_THRESHOLD: orgasm_control_applyThreshold(command.value); break;
+        case OC_COMMAND_INCREMENT_THRESHOLD:
+            orgasm_control_applyThreshold(Config.sensitivity_threshold + command.value);
+            break;
         }
     }
+}
 
-    arousal_state.last_value = p_check;
+static void orgasm_control_sendCommand(orgasm_control_command_type_t type, int value) {
+    orgasm_control_command_t command = {.type = type, .value = value};
 
-    // detect muscle clenching.  Used in Edging+orgasm routine to detect an orgasm
-    // Can also be used as an other method to compliment detecting edging
+    if (!command_queue_push(&command_state.queue, &command)) {
+        ESP_LOGW(TAG, "Control command queue full, dropped command %d.", type);
+    }
+}
+
+// A session runs from automatic control being chosen until the mode is back to manual. That covers
+// the permit and post-orgasm phases of orgasm mode, where control of the motor is paused.
+static bool orgasm_control_isSessionRunning() {
+    return output_state.output_mode != OC_MANUAL_CONTROL;
+}
+
+// Moves a snapshot timestamp onto the current clock, keeping its age. Anything older than the
+// current uptime wraps below zero, which elapsed-time comparisons handle. Zero means unset and
+// stays zero; a set timestamp that lands on zero is nudged off it.
+static unsigned long orgasm_control_restoreTime(uint32_t ms, uint32_t tick_ms, unsigned long now) {
+    if (ms == 0) return 0;
+    unsigned long restored = now - (uint32_t)(tick_ms - ms);
+    return restored != 0 ? restored : 1;
+}
 
-    // raise clench threshold to pressure - 1/2 sensitivity
-    if (p_check >=
-        (post_orgasm_state.clench_pressure_threshold + Config.clench_pressure_sensitivity)) {
-        post_orgasm_state.clench_pressure_threshold =
-            (p_check - (Config.clench_pressure_sensitivity / 2));
+static void orgasm_control_restoreSnapshot(const orgasm_control_snapshot_t* snapshot) {
+    unsigned long now = orgasm_control_now();
+    uint32_t tick_ms = snapshot->tick_ms;
+
+    // Readers before the first update compare against tick_ms, so it has to be on the new clock:
+    clock_state.tick_ms = now;
+    orgasm_control_applyOutputMode(snapshot->output_mode);
+    output_state.motor_speed = snapshot->motor_speed;
+    output_state.motor_start_time =
+        orgasm_control_restoreTime(snapshot->motor_start_ms, tick_ms, now);
+    output_state.motor_stop_time =
+        orgasm_control_restoreTime(snapshot->motor_stop_ms, tick_ms, now);
+    output_state.random_additional_delay = snapshot->random_additional_delay;
+
+    arousal_state.denial_count = snapshot->denial_count;
+    arousal_state.detector.arousal = snapshot->arousal;
+    arousal_state.detector.clench_pressure_threshold = snapshot->clench_pressure_threshold;
+    arousal_state.detector.clench_duration = snapshot->clench_duration;
+
+    post_orgasm_state.menu_is_locked = snapshot->menu_is_locked ? ocTRUE : ocFALSE;
+    post_orgasm_state.auto_edging_start_millis =
+        orgasm_control_restoreTime(snapshot->auto_edging_start_ms, tick_ms, now);
+    post_orgasm_state.post_orgasm_start_millis =
+        orgasm_control_restoreTime(snapshot->post_orgasm_start_ms, tick_ms, now);
+    post_orgasm_state.post_orgasm_duration_seconds = snapshot->post_orgasm_duration_seconds;
+
+    session_state.stats = snapshot->session;
+    session_state.stats.start_ms =
+        orgasm_control_restoreTime(snapshot->session.start_ms, tick_ms, now);
+    session_state.stats.last_ms =
+        orgasm_control_restoreTime(snapshot->session.last_ms, tick_ms, now);
+    session_state.stats.motor_start_ms =
+        orgasm_control_restoreTime(snapshot->session.motor_start_ms, tick_ms, now);
+    session_state.active = orgasm_control_isSessionRunning();
+
+    event_state.output_mode = output_state.output_mode;
+    event_state.denial_count = arousal_state.denial_count;
+    snapshot_state.last = *snapshot;
+
+    ESP_LOGI(
+        TAG,
+        "Resumed %s with %d denials.",
+        orgasm_control_get_output_mode_str(),
+        arousal_state.denial_count
+    );
+}
+
+void orgasm_control_init(void) {
+    memset(&arousal_state, 0, sizeof(arousal_state));
+    memset(&output_state, 0, sizeof(output_state));
+    memset(&post_orgasm_state, 0, sizeof(post_orgasm_state));
+
+    output_state.output_mode = OC_MANUAL_CONTROL;
+    output_state.vibration_mode = Config.vibration_mode;
+    output_state.edge_time_out = 10000;
+
+    detector_params_t params;
+    detector_params_from_config(&params);
+    detector_init(&arousal_state.detector, &params);
+    edge_predictor_init(&arousal_state.predictor);
+    shadow_detector_init();
+
+    ring_buffer_init(
+        &sample_state.ring,
+        sample_state.storage,
+        sizeof(orgasm_control_sample_t),
+        ORGASM_CONTROL_SAMPLE_RING_SIZE
+    );
+
+    ring_buffer_reader_init(&sample_state.ring, &logger_state.reader);
+
+    ring_buffer_init(
+        &event_state.ring,
+        event_state.storage,
+        sizeof(orgasm_control_event_t),
+        ORGASM_CONTROL_EVENT_RING_SIZE
+    );
+
+    ring_buffer_init(
+        &event_state.state_ring,
+        event_state.state_storage,
+        sizeof(orgasm_control_event_t),
+        ORGASM_CONTROL_STATE_EVENT_RING_SIZE
+    );
+
+    orgasm_control_subscribe(&logger_state.events);
+    event_state.output_mode = output_state.output_mode;
+    event_state.arousal = 0;
+    event_state.motor_speed = eom_hal_get_motor_speed();
+    event_state.denial_count = 0;
+    event_state.over_threshold = false;
+    event_state.detected_orgasm = false;
+    event_state.sensor_fault = SENSOR_FAULT_NONE;
+    event_state.arousal_detector = NULL;
+    event_state.shadow_denial_count = 0;
+    event_state.shadow_orgasm_count = 0;
+
+    session_state.active = false;
+    session_stats_start(&session_state.stats, orgasm_control_now());
+    ring_buffer_init(
+        &session_state.finished,
+        session_state.storage,
+        sizeof(session_stats_t),
+        ORGASM_CONTROL_SESSION_RING_SIZE
+    );
+
+    ring_buffer_reader_init(&session_state.finished, &logger_state.sessions);
+
+    threshold_state.active = false;
+    guard_state.enabled = false;
+    spectrum_state.enabled = false;
+    ring_buffer_init(
+        &spectrum_state.ring,
+        spectrum_state.storage,
+        sizeof(spectrum_frame_t),
+        ORGASM_CONTROL_SPECTRUM_RING_SIZE
+    );
+
+    decimator_init(&acquisition_state.decimator, 1);
+    ring_buffer_init(
+        &acquisition_state.raw_ring,
+        acquisition_state.raw_storage,
+        sizeof(orgasm_control_raw_sample_t),
+        ORGASM_CONTROL_RAW_RING_SIZE
+    );
+
+    ring_buffer_init(
+        &snapshot_state.ring,
+        snapshot_state.storage,
+        sizeof(orgasm_control_snapshot_t),
+        sizeof(snapshot_state.storage) / sizeof(snapshot_state.storage[0])
+    );
+
+    ring_buffer_reader_init(&snapshot_state.ring, &snapshot_state.reader);
+    memset(&snapshot_state.last, 0, sizeof(snapshot_state.last));
+    snapshot_state.last.output_mode = OC_MANUAL_CONTROL;
+    snapshot_state.last_ms = orgasm_control_now();
+
+    command_queue_init(
+        &command_state.queue,
+        command_state.storage,
+        command_state.seqs,
+        sizeof(orgasm_control_command_t),
+        ORGASM_CONTROL_COMMAND_QUEUE_SIZE
+    );
+
+    atomic_store(&command_state.save_config, false);
+    atomic_store(&command_state.sensor_sensitivity, -1);
+    calibration_state.sensitivity = Config.sensor_sensitivity;
+    calibration_state.settling = false;
+
+    orgasm_control_snapshot_t snapshot;
+    if (control_snapshot_load(&snapshot)) {
+        orgasm_control_restoreSnapshot(&snapshot);
     }
+}
 
-    // Start counting clench time if pressure over threshold
-    if (p_check >= post_orgasm_state.clench_pressure_threshold) {
-        post_orgasm_state.clench_duration += 1;
+static sensor_fault_t orgasm_control_getSensorFault() {
+    return guard_state.enabled ? guard_state.guard.fault : SENSOR_FAULT_NONE;
+}
 
-        // Orgasm detected
-        if (post_orgasm_state.clench_duration >= Config.clench_threshold_2_orgasm &&
-            orgasm_control_isPermitOrgasmReached()) {
-            post_orgasm_state.detected_orgasm = ocTRUE;
-            post_orgasm_state.clench_duration = 0;
-        }
+// Screens pressure while sensor_fault_rejection is on, see sensor_guard_t.
+static uint16_t orgasm_control_guardPressure(uint16_t pressure) {
+    int rate = Config.update_frequency_hz;
 
-        // ajust arousal if Clench_detector in Edge is turned on
-        if (Config.clench_detector_in_edging) {
-            if (post_orgasm_state.clench_duration > (Config.clench_threshold_2_orgasm / 2)) {
-                arousal_state.arousal += 5;
-                arousal_state.update_flag = ocTRUE;
-            }
-        }
+    if (!Config.sensor_fault_rejection) {
+        guard_state.enabled = false;
+        return pressure;
+    }
 
-        // desensitize clench threshold when clench too long. this is to stop arousal from going up
-        if (post_orgasm_state.clench_duration >= Config.max_clench_duration) {
-            post_orgasm_state.clench_pressure_threshold += 10;
-            post_orgasm_state.clench_duration = Config.max_clench_duration;
-        }
+    if (!guard_state.enabled || guard_state.guard.sample_rate_hz != rate) {
+        sensor_guard_init(&guard_state.guard, EOM_HAL_PRESSURE_MAX, rate);
+        guard_state.enabled = true;
+    }
 
-        // when not clenching lower clench time and decay clench threshold
-    } else {
-        post_orgasm_state.clench_duration -= 5;
-
-        if (post_orgasm_state.clench_duration <= 0) {
-            post_orgasm_state.clench_duration = 0;
-            // clench pressure threshold value decays over time to a min of pressure + 1/2
-            // sensitivity
-            if ((p_check + (Config.clench_pressure_sensitivity / 2)) <
-                post_orgasm_state.clench_pressure_threshold) {
-                post_orgasm_state.clench_pressure_threshold *= 0.99;
-            }
-        }
-    } // END of clench detector
+    return sensor_guard_update(&guard_state.guard, pressure);
+}
 
-    // Update accessories:
-    if (arousal_state.update_flag) {
-        accessory_driver_broadcast_arousal(arousal_state.arousal);
-        bluetooth_driver_broadcast_arousal(arousal_state.arousal);
-        // websocket_driver_broadcast_arousal(arousal_state.arousal);
+/**
+ * Main orgasm detection / edging algorithm happens here.
+ * This happens with a default update frequency of 50Hz.
+ */
+static void orgasm_control_updateArousal(uint16_t pressure) {
+    uint16_t arousal = arousal_state.detector.arousal;
+
+    // Take new pressure, average, and run the detector:
+    update_check(arousal_state.pressure_value, pressure);
+    detector_params_from_config(&arousal_state.detector.params);
+    detector_update(
+        &arousal_state.detector, pressure, orgasm_control_isPermitOrgasmReached() == ocTRUE
+    );
+
+    edge_predictor_update(
+        &arousal_state.predictor, arousal_state.detector.arousal, Config.update_frequency_hz
+    );
+
+    if (arousal_state.detector.arousal != arousal) {
+        arousal_state.update_flag = ocTRUE;
     }
 }
 
+/**
+ * Whether arousal is over the threshold or, with edge_prediction_ms set, projected to cross it
+ * within that time.
+ */
+static oc_bool_t orgasm_control_isEdgeExpected() {
+    if (arousal_state.detector.arousal > Config.sensitivity_threshold) {
+        return ocTRUE;
+    }
+
+    if (Config.edge_prediction_ms <= 0) {
+        return ocFALSE;
+    }
+
+    int horizon = Config.edge_prediction_ms * Config.update_frequency_hz / 1000;
+    int updates = edge_predictor_updates_to_edge(
+        &arousal_state.predictor, Config.sensitivity_threshold, horizon
+    );
+
+    if (updates < 0) {
+        return ocFALSE;
+    }
+
+    ESP_LOGD(
+        TAG,
+        "Edge predicted in %dms at arousal %d",
+        updates * 1000 / Config.update_frequency_hz,
+        arousal_state.detector.arousal
+    );
+
+    return ocTRUE;
+}
+
 static void orgasm_control_updateMotorSpeed() {
     if (!output_state.control_motor) return;
 
     const vibration_mode_controller_t* controller = orgasm_control_getVibrationMode();
-    controller->tick(output_state.motor_speed, arousal_state.arousal);
+    controller->tick(output_state.motor_speed, arousal_state.detector.arousal);
 
     // Calculate timeout delay
     oc_bool_t time_out_over = ocFALSE;
-    long on_time = (esp_timer_get_time() / 1000UL) - output_state.motor_start_time;
+    long on_time = clock_state.tick_ms - output_state.motor_start_time;
 
-    if ((esp_timer_get_time() / 1000UL) - output_state.motor_stop_time >
+    if (clock_state.tick_ms - output_state.motor_stop_time >
         Config.edge_delay + output_state.random_additional_delay) {
         time_out_over = ocTRUE;
     }
@@ -214,12 +591,12 @@ static void orgasm_control_updateMotorSpeed() {
     if (!time_out_over) {
         orgasm_control_twitchDetect();
 
-    } else if (arousal_state.arousal > Config.sensitivity_threshold &&
-               output_state.motor_speed > 0 && on_time > Config.minimum_on_time) {
+    } else if (output_state.motor_speed > 0 && on_time > Config.minimum_on_time &&
+               orgasm_control_isEdgeExpected()) {
         // The motor_speed check above, btw, is so we only hit this once per peak.
         // Set the motor speed to 0, set stop time, and determine the new additional random time.
         output_state.motor_speed = controller->stop();
-        output_state.motor_stop_time = (esp_timer_get_time() / 1000UL);
+        output_state.motor_stop_time = clock_state.tick_ms;
         output_state.motor_start_time = 0;
         arousal_state.denial_count++;
         arousal_state.update_flag = ocTRUE;
@@ -233,7 +610,7 @@ static void orgasm_control_updateMotorSpeed() {
         // Start from 0
     } else if (output_state.motor_speed == 0 && output_state.motor_start_time == 0) {
         output_state.motor_speed = controller->start();
-        output_state.motor_start_time = (esp_timer_get_time() / 1000UL);
+        output_state.motor_start_time = clock_state.tick_ms;
         output_state.random_additional_delay = 0;
         arousal_state.update_flag = ocTRUE;
 
@@ -244,10 +621,7 @@ static void orgasm_control_updateMotorSpeed() {
 
     // Control motor if we are not manually doing so.
     if (output_state.control_motor) {
-        uint8_t speed = orgasm_control_getMotorSpeed();
-        eom_hal_set_motor_speed(speed);
-        accessory_driver_broadcast_speed(speed);
-        bluetooth_driver_broadcast_speed(speed);
+        eom_hal_set_motor_speed(orgasm_control_getMotorSpeed());
     }
 }
 
@@ -261,15 +635,14 @@ static void orgasm_control_updateEdgingTime() { // Edging+Orgasm timer
 
     // keep edging start time to current time as long as system is not in Edge-Orgasm mode 2
     if (output_state.output_mode != OC_ORGASM_MODE) {
-        post_orgasm_state.auto_edging_start_millis = (esp_timer_get_time() / 1000UL);
+        post_orgasm_state.auto_edging_start_millis = clock_state.tick_ms;
         post_orgasm_state.post_orgasm_start_millis = 0;
     }
 
     // Lock Menu if turned on. and in Edging_orgasm mode
     if (Config.edge_menu_lock && !post_orgasm_state.menu_is_locked) {
         // Lock only after 2 minutes
-        if ((esp_timer_get_time() / 1000UL) >
-            post_orgasm_state.auto_edging_start_millis + (2 * 60 * 1000)) {
+        if (clock_state.tick_ms - post_orgasm_state.auto_edging_start_millis > (2 * 60 * 1000)) {
             post_orgasm_state.menu_is_locked = ocTRUE;
             arousal_state.update_flag = ocTRUE;
         }
@@ -278,13 +651,13 @@ static void orgasm_control_updateEdgingTime() { // Edging+Orgasm timer
     // Pre-Orgasm loop -- Orgasm is permited
     if (orgasm_control_isPermitOrgasmReached() && !orgasm_control_isPostOrgasmReached()) {
         if (output_state.control_motor) {
-            orgasm_control_pauseControl(); // make sure orgasm is now possible
+            orgasm_control_applyPauseControl(); // make sure orgasm is now possible
         }
 
         // now detect the orgasm to start post orgasm torture timer
-        if (post_orgasm_state.detected_orgasm) {
+        if (arousal_state.detector.detected_orgasm) {
             post_orgasm_state.post_orgasm_start_millis =
-                (esp_timer_get_time() / 1000UL); // Start Post orgasm torture timer
+                clock_state.tick_ms; // Start Post orgasm torture timer
             // Lock menu if turned on
             if (Config.post_orgasm_menu_lock && !post_orgasm_state.menu_is_locked) {
                 post_orgasm_state.menu_is_locked = ocTRUE;
@@ -296,10 +669,10 @@ static void orgasm_control_updateEdgingTime() { // Edging+Orgasm timer
         }
 
         // raise motor speed to max speep. protect not to go higher than max
-        if (output_state.motor_speed <= (Config.motor_max_speed - 5)) {
-            output_state.motor_speed += 5;
+        if (output_state.motor_speed <= q16_from_int(Config.motor_max_speed - 5)) {
+            output_state.motor_speed += q16_from_int(5);
         } else {
-            update_check(output_state.motor_speed, Config.motor_max_speed);
+            update_check(output_state.motor_speed, q16_from_int(Config.motor_max_speed));
         }
     }
 
@@ -309,17 +682,17 @@ static void orgasm_control_updateEdgingTime() { // Edging+Orgasm timer
             (post_orgasm_state.post_orgasm_duration_seconds * 1000);
 
         // Detect if within post orgasm session
-        if ((esp_timer_get_time() / 1000UL) < (post_orgasm_state.post_orgasm_start_millis +
-                                               post_orgasm_state.post_orgasm_duration_millis)) {
-            output_state.motor_speed = Config.motor_max_speed;
-        } else {                                  // Post_orgasm timer reached
-            if (output_state.motor_speed >= 10) { // Ramp down motor speed to 0
-                output_state.motor_speed = output_state.motor_speed - 10;
+        if (clock_state.tick_ms - post_orgasm_state.post_orgasm_start_millis <
+            (unsigned long)post_orgasm_state.post_orgasm_duration_millis) {
+            output_state.motor_speed = q16_from_int(Config.motor_max_speed);
+        } else { // Post_orgasm timer reached
+            if (output_state.motor_speed >= q16_from_int(10)) { // Ramp down motor speed to 0
+                output_state.motor_speed = output_state.motor_speed - q16_from_int(10);
             } else {
                 post_orgasm_state.menu_is_locked = ocFALSE;
-                post_orgasm_state.detected_orgasm = ocFALSE;
+                arousal_state.detector.detected_orgasm = false;
                 output_state.motor_speed = 0;
-                orgasm_control_set_output_mode(OC_MANUAL_CONTROL);
+                orgasm_control_applyOutputMode(OC_MANUAL_CONTROL);
             }
         }
     }
@@ -328,8 +701,8 @@ static void orgasm_control_updateEdgingTime() { // Edging+Orgasm timer
 }
 
 void orgasm_control_twitchDetect() {
-    if (arousal_state.arousal > Config.sensitivity_threshold) {
-        output_state.motor_stop_time = (esp_timer_get_time() / 1000UL);
+    if (arousal_state.detector.arousal > Config.sensitivity_threshold) {
+        output_state.motor_stop_time = clock_state.tick_ms;
     }
 }
 
@@ -355,112 +728,541 @@ orgasm_output_mode_t orgasm_control_str_to_output_mode(const char* str) {
     return -1;
 }
 
-/**
- * \todo Recording functions don't need to be here.
- */
-void orgasm_control_startRecording() {
-    if (logger_state.logfile) {
-        orgasm_control_stopRecording();
+static void orgasm_control_emit(orgasm_control_event_type_t type, int32_t value) {
+    orgasm_control_event_t event = {
+        .millis = clock_state.tick_ms,
+        .type = type,
+        .value = value,
+    };
+
+    bool per_tick = type == OC_EVENT_UPDATE || type == OC_EVENT_AROUSAL ||
+                    type == OC_EVENT_MOTOR_SPEED;
+    ring_buffer_push(per_tick ? &event_state.ring : &event_state.state_ring, &event);
+}
+
+// Publishes everything that changed during this update, then starts the next one clean.
+static void orgasm_control_emit_events() {
+    uint16_t arousal = arousal_state.detector.arousal;
+    uint8_t motor_speed = eom_hal_get_motor_speed();
+    bool over_threshold = arousal > Config.sensitivity_threshold;
+
+    if (output_state.output_mode != event_state.output_mode) {
+        event_state.output_mode = output_state.output_mode;
+        orgasm_control_emit(OC_EVENT_MODE_CHANGE, output_state.output_mode);
     }
 
-    ui_toast_blocking("%s", _("Preapring recording..."));
+    if (arousal != event_state.arousal) {
+        event_state.arousal = arousal;
+        orgasm_control_emit(OC_EVENT_AROUSAL, arousal);
+    }
 
-    time_t now;
-    struct tm timeinfo;
-    char filename_date[32];
-    time(&now);
+    if (over_threshold && !event_state.over_threshold) {
+        orgasm_control_emit(OC_EVENT_EDGE, arousal);
+    }
+    event_state.over_threshold = over_threshold;
 
-    if (!localtime_r(&now, &timeinfo)) {
-        ESP_LOGE(TAG, "Failed to obtain time");
-        sniprintf(filename_date, 32, "%lld", (esp_timer_get_time() / 1000UL));
-    } else {
-        strftime(filename_date, 32, "%Y%m%d-%H%M%S", &timeinfo);
+    if (arousal_state.denial_count != event_state.denial_count) {
+        event_state.denial_count = arousal_state.denial_count;
+        orgasm_control_emit(OC_EVENT_DENIAL, arousal_state.denial_count);
     }
 
-    char* logfile_name = NULL;
-    asiprintf(&logfile_name, "/log-%s.csv", filename_date);
+    if (arousal_state.detector.detected_orgasm && !event_state.detected_orgasm) {
+        orgasm_control_emit(OC_EVENT_ORGASM, 0);
+    }
+    event_state.detected_orgasm = arousal_state.detector.detected_orgasm;
 
-    ESP_LOGI(TAG, "Opening logfile: %s", logfile_name);
-    logger_state.logfile = fopen(logfile_name, "w+");
+    if (orgasm_control_getSensorFault() != event_state.sensor_fault) {
+        event_state.sensor_fault = orgasm_control_getSensorFault();
+        orgasm_control_emit(OC_EVENT_SENSOR_FAULT, event_state.sensor_fault);
+    }
 
-    if (!logger_state.logfile) {
-        ESP_LOGE(TAG, "Couldn't open logfile to save! (%s)", logfile_name);
-        ui_toast("%s", _("Error opening logfile!"));
-    } else {
-        logger_state.recording_start_ms = (esp_timer_get_time() / 1000UL);
+    if (arousal_state.detector.arousal_detector != event_state.arousal_detector) {
+        event_state.arousal_detector = arousal_state.detector.arousal_detector;
+        orgasm_control_emit(OC_EVENT_DETECTOR_CHANGE, arousal_state.detector.params.mode);
+    }
 
-        fprintf(
-            logger_state.logfile,
-            "millis,pressure,avg_pressure,arousal,motor_speed,sensitivity_threshold,"
-            "clench_pressure_threshold,clench_duration"
-        );
+    if (shadow_detector_get_denial_count() != event_state.shadow_denial_count) {
+        event_state.shadow_denial_count = shadow_detector_get_denial_count();
+        orgasm_control_emit(OC_EVENT_SHADOW_DENIAL, event_state.shadow_denial_count);
+    }
+
+    if (shadow_detector_get_orgasm_count() != event_state.shadow_orgasm_count) {
+        event_state.shadow_orgasm_count = shadow_detector_get_orgasm_count();
+        orgasm_control_emit(OC_EVENT_SHADOW_ORGASM, 0);
+    }
+
+    if (motor_speed != event_state.motor_speed) {
+        event_state.motor_speed = motor_speed;
+        orgasm_control_emit(OC_EVENT_MOTOR_SPEED, motor_speed);
+    }
 
-        ui_set_icon(UI_ICON_RECORD, RECORD_ICON_RECORDING);
-        ui_toast(_("Recording started:\n%s"), logfile_name);
+    if (arousal_state.update_flag) {
+        arousal_state.update_flag = ocFALSE;
+        orgasm_control_emit(OC_EVENT_UPDATE, 0);
     }
 }
 
-void orgasm_control_stopRecording() {
-    if (logger_state.logfile != NULL) {
-        ui_toast_blocking("%s", _("Stopping..."));
-        ESP_LOGI(TAG, "Closing logfile.");
-        fclose(logger_state.logfile);
-        ui_set_icon(UI_ICON_RECORD, -1);
-        ui_toast("%s", _("Recording stopped."));
+static uint16_t orgasm_control_read_pressure() {
+    uint32_t start = perf_stats_begin();
+    uint16_t pressure = eom_hal_get_pressure_reading();
+    perf_stats_record(PERF_STAGE_SENSOR_READ, start);
+    return pressure;
+}
+
+// Starts a session when automatic control is chosen, and hands it to the logger once the mode is
+// back to manual.
+static void orgasm_control_updateSession(const orgasm_control_sample_t* sample) {
+    bool running = orgasm_control_isSessionRunning();
+
+    if (running && !session_state.active) {
+        session_stats_start(&session_state.stats, sample->millis);
+        session_state.active = true;
+    } else if (!running && session_state.active) {
+        ring_buffer_push(&session_state.finished, &session_state.stats);
+        session_state.active = false;
+    }
+
+    if (session_state.active) {
+        session_stats_update(&session_state.stats, sample, arousal_state.detector.detected_orgasm);
     }
 }
 
-oc_bool_t orgasm_control_isRecording() {
-    return (oc_bool_t)logger_state.logfile;
+static void orgasm_control_startThreshold(bool manual_change) {
+    auto_threshold_init(
+        &threshold_state.controller,
+        Config.sensitivity_threshold,
+        Config.auto_threshold_interval_s * 1000UL,
+        clock_state.tick_ms
+    );
+
+    threshold_state.start_threshold = Config.sensitivity_threshold;
+    threshold_state.manual_change = manual_change;
+    threshold_state.applied = Config.sensitivity_threshold;
 }
 
-void orgasm_control_tick() {
-    unsigned long millis = esp_timer_get_time() / 1000UL;
-    unsigned long update_frequency_ms = 1000UL / Config.update_frequency_hz;
+// Runs auto_threshold over automatic sessions. The threshold only changes in RAM while a session
+// runs; at the end it is saved if it settled, or put back otherwise.
+static void orgasm_control_updateThreshold() {
+    bool run = Config.auto_threshold && session_state.active;
+
+    if (run && !threshold_state.active) {
+        orgasm_control_startThreshold(false);
+        threshold_state.denial_count = arousal_state.denial_count;
+        threshold_state.active = true;
+        return;
+    }
 
-    if (millis - arousal_state.last_update_ms > update_frequency_ms) {
-        orgasm_control_updateArousal();
-        orgasm_control_updateEdgingTime();
-        orgasm_control_updateMotorSpeed();
-        arousal_state.last_update_ms = millis;
+    if (!run && threshold_state.active) {
+        threshold_state.active = false;
 
-        // Data for logfile or classic log.
-        char data_csv[255];
-        snprintf(
-            data_csv,
-            255,
-            "%d,%d,%d,%d,%ld,%d",
-            orgasm_control_getAveragePressure(),
-            orgasm_control_getArousal(),
-            eom_hal_get_motor_speed(),
-            Config.sensitivity_threshold,
-            post_orgasm_state.clench_pressure_threshold,
-            post_orgasm_state.clench_duration
-        );
+        if (auto_threshold_settled(&threshold_state.controller)) {
+            orgasm_control_emit(OC_EVENT_THRESHOLD_SETTLED, Config.sensitivity_threshold);
+            atomic_store_explicit(&command_state.save_config, true, memory_order_release);
+        } else {
+            Config.sensitivity_threshold = threshold_state.start_threshold;
+            arousal_state.update_flag = ocTRUE;
+            if (threshold_state.manual_change) {
+                atomic_store_explicit(&command_state.save_config, true, memory_order_release);
+            }
+        }
+
+        return;
+    }
+
+    if (!run) {
+        return;
+    }
+
+    // The user moved the threshold; carry on from there:
+    if (Config.sensitivity_threshold != threshold_state.applied) {
+        orgasm_control_startThreshold(true);
+    }
+
+    bool denied = arousal_state.denial_count != threshold_state.denial_count;
+    threshold_state.denial_count = arousal_state.denial_count;
+
+    int threshold = auto_threshold_update(&threshold_state.controller, denied, clock_state.tick_ms);
+    if (threshold != threshold_state.applied) {
+        Config.sensitivity_threshold = threshold;
+        threshold_state.applied = threshold;
+        arousal_state.update_flag = ocTRUE;
+    }
+}
+
+static void orgasm_control_fillSnapshot(orgasm_control_snapshot_t* snapshot) {
+    memset(snapshot, 0, sizeof(orgasm_control_snapshot_t));
+    snapshot->version = ORGASM_CONTROL_SNAPSHOT_VERSION;
+    snapshot->output_mode = output_state.output_mode;
+    snapshot->denial_count = arousal_state.denial_count;
+    snapshot->menu_is_locked = post_orgasm_state.menu_is_locked;
+    snapshot->arousal = arousal_state.detector.arousal;
+    snapshot->tick_ms = clock_state.tick_ms;
+    snapshot->motor_speed = output_state.motor_speed;
+    snapshot->motor_start_ms = output_state.motor_start_time;
+    snapshot->motor_stop_ms = output_state.motor_stop_time;
+    snapshot->random_additional_delay = output_state.random_additional_delay;
+    snapshot->clench_pressure_threshold = arousal_state.detector.clench_pressure_threshold;
+    snapshot->clench_duration = arousal_state.detector.clench_duration;
+    snapshot->auto_edging_start_ms = post_orgasm_state.auto_edging_start_millis;
+    snapshot->post_orgasm_start_ms = post_orgasm_state.post_orgasm_start_millis;
+    snapshot->post_orgasm_duration_seconds = post_orgasm_state.post_orgasm_duration_seconds;
+    snapshot->session = session_state.stats;
+}
+
+// Publishes a snapshot when the session changes shape, and periodically while it runs. Writing
+// it to flash is left to control_snapshot on a slower task.
+static void orgasm_control_updateSnapshot() {
+    const orgasm_control_snapshot_t* last = &snapshot_state.last;
+    unsigned long since = clock_state.tick_ms - snapshot_state.last_ms;
+
+    bool changed = output_state.output_mode != last->output_mode ||
+                   arousal_state.denial_count != last->denial_count ||
+                   post_orgasm_state.menu_is_locked != last->menu_is_locked ||
+                   (post_orgasm_state.post_orgasm_start_millis != 0) !=
+                       (last->post_orgasm_start_ms != 0);
+
+    if ((changed && since >= ORGASM_CONTROL_SNAPSHOT_MIN_INTERVAL_MS) ||
+        (orgasm_control_isSessionRunning() && since >= ORGASM_CONTROL_SNAPSHOT_INTERVAL_MS)) {
+        orgasm_control_fillSnapshot(&snapshot_state.last);
+        ring_buffer_push(&snapshot_state.ring, &snapshot_state.last);
+        snapshot_state.last_ms = clock_state.tick_ms;
+    }
+}
+
+// A sensor sensitivity change, from calibration or the user, steps the whole pressure signal.
+// Until it has settled, the detectors start over from each reading instead of counting the step.
+static void orgasm_control_updateSensitivity(uint16_t pressure) {
+    if (Config.sensor_sensitivity != calibration_state.sensitivity) {
+        calibration_state.sensitivity = Config.sensor_sensitivity;
+        calibration_state.sensitivity_changed_ms = clock_state.tick_ms;
+        calibration_state.settling = true;
+        calibration_state.samples = 0;
+    }
+
+    if (!calibration_state.settling) {
+        return;
+    }
+
+    if (clock_state.tick_ms - calibration_state.sensitivity_changed_ms >
+        SENSOR_SENSITIVITY_SETTLE_MS) {
+        calibration_state.settling = false;
+        return;
+    }
+
+    detector_rebase(&arousal_state.detector, pressure);
+    shadow_detector_rebase(pressure);
+}
+
+// Keeps pressure in range while auto_sensor_sensitivity is on. Every adjustment shifts the whole
+// signal, so the estimates start over after each one.
+static void orgasm_control_updateCalibration(uint16_t pressure) {
+    pressure_calibration_t* calibration = &calibration_state.calibration;
+
+    if (!Config.auto_sensor_sensitivity) {
+        calibration_state.samples = 0;
+        return;
+    }
+
+    if (calibration_state.samples == 0) {
+        pressure_calibration_init(calibration);
+    }
+
+    pressure_calibration_add(calibration, pressure);
+    calibration_state.samples++;
+
+    int period_hz = Config.update_frequency_hz > 0 ? Config.update_frequency_hz : 1;
+    if (calibration_state.samples < period_hz * (PRESSURE_CALIBRATION_PERIOD_MS / 1000)) {
+        return;
+    }
+
+    calibration_state.samples = 0;
+
+    ESP_LOGD(
+        TAG,
+        "Pressure p5/p50/p95 %.0f/%.0f/%.0f at sensitivity %d",
+        quantile_get(&calibration->low),
+        quantile_get(&calibration->median),
+        quantile_get(&calibration->high),
+        Config.sensor_sensitivity
+    );
+
+    uint8_t sensitivity = pressure_calibration_suggest(
+        calibration, Config.sensor_sensitivity, EOM_HAL_PRESSURE_MAX
+    );
+
+    if (sensitivity != Config.sensor_sensitivity) {
+        // Applied and logged by orgasm_control_log_tick():
+        atomic_store_explicit(&command_state.sensor_sensitivity, sensitivity, memory_order_release);
+    }
+}
+
+static void orgasm_control_updateSpectrum(uint16_t pressure) {
+    static CONTROL_LOCAL spectrum_frame_t frame;
+
+    if (!Config.spectrum_analysis) {
+        spectrum_state.enabled = false;
+        return;
+    }
+
+    // Start from an empty window, rather than one left over from the last time it was on:
+    if (!spectrum_state.enabled) {
+        spectrum_init(&spectrum_state.spectrum);
+        spectrum_state.enabled = true;
+    }
+
+    bool analyzed = spectrum_update(
+        &spectrum_state.spectrum, pressure, Config.update_frequency_hz, clock_state.tick_ms, &frame
+    );
+
+    if (analyzed) {
+        ring_buffer_push(&spectrum_state.ring, &frame);
+    }
+}
+
+void orgasm_control_update() {
+    orgasm_control_update_pressure(orgasm_control_read_pressure());
+}
+
+void orgasm_control_update_pressure(uint16_t pressure) {
+    uint32_t update_start = perf_stats_begin();
+    uint32_t start = update_start;
+
+    clock_state.tick_ms = orgasm_control_now();
+    orgasm_control_applyCommands();
+    pressure = orgasm_control_guardPressure(pressure);
+
+    // Hold arousal and calibration through a sensor fault, rather than reading a glitch as a
+    // contraction:
+    if (orgasm_control_getSensorFault() == SENSOR_FAULT_NONE) {
+        orgasm_control_updateSensitivity(pressure);
+        orgasm_control_updateCalibration(pressure);
+        orgasm_control_updateArousal(pressure);
+    }
+    perf_stats_record(PERF_STAGE_AROUSAL, start);
+
+    start = perf_stats_begin();
+    orgasm_control_updateEdgingTime();
+    perf_stats_record(PERF_STAGE_EDGING_TIME, start);
+
+    start = perf_stats_begin();
+    orgasm_control_updateMotorSpeed();
+    perf_stats_record(PERF_STAGE_MOTOR, start);
+
+    start = perf_stats_begin();
+    shadow_detector_update(
+        pressure,
+        orgasm_control_isPermitOrgasmReached() == ocTRUE,
+        output_state.control_motor,
+        clock_state.tick_ms
+    );
+    perf_stats_record(PERF_STAGE_SHADOW, start);
+
+    start = perf_stats_begin();
+    orgasm_control_updateSpectrum(pressure);
+    perf_stats_record(PERF_STAGE_SPECTRUM, start);
+
+    orgasm_control_sample_t sample = {
+        .millis = clock_state.tick_ms,
+        .pressure = arousal_state.pressure_value,
+        .avg_pressure = orgasm_control_getAveragePressure(),
+        .arousal = arousal_state.detector.arousal,
+        .motor_speed = eom_hal_get_motor_speed(),
+        .denial_count = arousal_state.denial_count,
+        .sensitivity_threshold = Config.sensitivity_threshold,
+        .clench_pressure_threshold = arousal_state.detector.clench_pressure_threshold,
+        .clench_duration = arousal_state.detector.clench_duration,
+        .shadow_arousal = shadow_detector_get_arousal(),
+        .shadow_denial_count = shadow_detector_get_denial_count(),
+    };
+
+    ring_buffer_push(&sample_state.ring, &sample);
+    orgasm_control_updateSession(&sample);
+    orgasm_control_updateThreshold();
+    orgasm_control_updateSnapshot();
+    orgasm_control_emit_events();
+    perf_stats_record(PERF_STAGE_CONTROL_UPDATE, update_start);
+}
+
+int orgasm_control_get_sample_rate_hz(void) {
+    return Config.update_frequency_hz * orgasm_control_get_decimation_ratio();
+}
+
+void orgasm_control_sample() {
+    uint8_t ratio = orgasm_control_get_decimation_ratio();
+
+    if (ratio != acquisition_state.decimator.ratio) {
+        decimator_init(&acquisition_state.decimator, ratio);
+    }
 
-        // Write out to logfile, which includes millis:
-        if (logger_state.logfile != NULL) {
-            fprintf(
-                logger_state.logfile,
-                "%ld,%s\n",
-                arousal_state.last_update_ms - logger_state.recording_start_ms,
-                data_csv
+    if (ratio == 1) {
+        orgasm_control_update();
+        return;
+    }
+
+    uint16_t filtered;
+    orgasm_control_raw_sample_t raw = {
+        .millis = orgasm_control_now(),
+        .seq = acquisition_state.raw_count++,
+        .pressure = orgasm_control_read_pressure(),
+    };
+
+    ring_buffer_push(&acquisition_state.raw_ring, &raw);
+
+    if (decimator_push(&acquisition_state.decimator, raw.pressure, &filtered)) {
+        orgasm_control_update_pressure(filtered);
+    }
+}
+
+void orgasm_control_log_tick() {
+    orgasm_control_sample_t sample;
+    orgasm_control_event_t event;
+
+    int sensitivity = atomic_exchange_explicit(
+        &command_state.sensor_sensitivity, -1, memory_order_acquire
+    );
+
+    if (sensitivity >= 0) {
+        ESP_LOGI(TAG, "Sensor sensitivity %d -> %d", Config.sensor_sensitivity, sensitivity);
+
+        // Config first, so the control task is already holding its detectors when the new
+        // setting reaches the sensor:
+        Config.sensor_sensitivity = sensitivity;
+        eom_hal_set_sensor_sensitivity(sensitivity);
+    }
+
+    if (atomic_exchange_explicit(&command_state.save_config, false, memory_order_acquire)) {
+        config_enqueue_save(30);
+    }
+
+    while (orgasm_control_next_event(&logger_state.events, &event)) {
+        switch (event.type) {
+        case OC_EVENT_EDGE:
+        case OC_EVENT_DENIAL:
+        case OC_EVENT_ORGASM:
+            ESP_LOGI(
+                TAG,
+                "%s at %lums: %d",
+                orgasm_control_event_type_str(event.type),
+                event.millis,
+                event.value
             );
+            break;
+        case OC_EVENT_MODE_CHANGE:
+            ESP_LOGI(
+                TAG, "Mode change at %lums: %s", event.millis, orgasm_output_mode_str[event.value]
+            );
+            break;
+        case OC_EVENT_SENSOR_FAULT:
+            ESP_LOGW(TAG, "Sensor fault at %lums: %s", event.millis, sensor_fault_str(event.value));
+            break;
+        case OC_EVENT_DETECTOR_CHANGE:
+            ESP_LOGI(TAG, "Arousal detector: %s", arousal_detector_get(event.value)->name);
+            break;
+        case OC_EVENT_THRESHOLD_SETTLED:
+            ESP_LOGI(TAG, "Arousal threshold settled at %d", event.value);
+            break;
+        case OC_EVENT_SHADOW_DENIAL:
+            ESP_LOGI(TAG, "Shadow denial #%d at %lums", event.value, event.millis);
+            break;
+        case OC_EVENT_SHADOW_ORGASM:
+            ESP_LOGI(TAG, "Shadow orgasm detected at %lums", event.millis);
+            break;
+        default: break;
+        }
+    }
+
+    while (ring_buffer_read(&sample_state.ring, &logger_state.reader, &sample)) {
+        if (!Config.classic_serial) {
+            continue;
         }
 
-        // Write to console for classic log mode:
-        if (Config.classic_serial) {
-            printf("%s\n", data_csv);
+        uint32_t start = perf_stats_begin_us();
+
+        printf(
+            "%d,%d,%d,%d,%ld,%d\n",
+            sample.avg_pressure,
+            sample.arousal,
+            sample.motor_speed,
+            sample.sensitivity_threshold,
+            sample.clench_pressure_threshold,
+            sample.clench_duration
+        );
+
+        perf_stats_record_us(PERF_STAGE_CSV_FORMAT, start);
+    }
+
+    session_stats_t session;
+
+    while (ring_buffer_read(&session_state.finished, &logger_state.sessions, &session)) {
+        FILE* file = fopen(ORGASM_CONTROL_SESSION_LOG, "a");
+
+        if (file == NULL) {
+            ESP_LOGW(TAG, "Couldn't open session log! (%s)", ORGASM_CONTROL_SESSION_LOG);
+            continue;
         }
+
+        session_stats_write_json(&session, time(NULL), file);
+        fclose(file);
     }
 }
 
-oc_bool_t orgasm_control_updated() {
-    return arousal_state.update_flag;
+ring_buffer_t* orgasm_control_get_sample_ring(void) {
+    return &sample_state.ring;
+}
+
+ring_buffer_t* orgasm_control_get_raw_ring(void) {
+    return &acquisition_state.raw_ring;
+}
+
+oc_bool_t orgasm_control_get_latest_sample(orgasm_control_sample_t* sample) {
+    return ring_buffer_latest(&sample_state.ring, sample) ? ocTRUE : ocFALSE;
 }
 
-void orgasm_control_clear_update_flag(void) {
-    arousal_state.update_flag = ocFALSE;
+void orgasm_control_subscribe(orgasm_control_subscriber_t* subscriber) {
+    ring_buffer_reader_init(&event_state.ring, &subscriber->ticks);
+    ring_buffer_reader_init(&event_state.state_ring, &subscriber->changes);
+}
+
+oc_bool_t orgasm_control_next_event(
+    orgasm_control_subscriber_t* subscriber, orgasm_control_event_t* event
+) {
+    if (ring_buffer_read(&event_state.state_ring, &subscriber->changes, event)) {
+        return ocTRUE;
+    }
+
+    return ring_buffer_read(&event_state.ring, &subscriber->ticks, event) ? ocTRUE : ocFALSE;
+}
+
+void orgasm_control_subscribe_spectrum(ring_buffer_reader_t* subscriber) {
+    ring_buffer_reader_init(&spectrum_state.ring, subscriber);
+}
+
+oc_bool_t orgasm_control_next_spectrum(
+    ring_buffer_reader_t* subscriber, spectrum_frame_t* frame
+) {
+    return ring_buffer_read(&spectrum_state.ring, subscriber, frame) ? ocTRUE : ocFALSE;
+}
+
+const char* orgasm_control_event_type_str(orgasm_control_event_type_t type) {
+    return type < _OC_EVENT_MAX ? orgasm_control_event_type_strs[type] : "";
+}
+
+const session_stats_t* orgasm_control_get_session_stats(void) {
+    return &session_state.stats;
+}
+
+oc_bool_t orgasm_control_take_snapshot(orgasm_control_snapshot_t* snapshot) {
+    oc_bool_t taken = ocFALSE;
+
+    while (ring_buffer_read(&snapshot_state.ring, &snapshot_state.reader, snapshot)) {
+        taken = ocTRUE;
+    }
+
+    return taken;
+}
+
+oc_bool_t orgasm_control_in_session(void) {
+    return session_state.active ? ocTRUE : ocFALSE;
 }
 
 int orgasm_control_getDenialCount() {
@@ -472,11 +1274,12 @@ int orgasm_control_getDenialCount() {
  * @return normalized motor speed byte
  */
 uint8_t orgasm_control_getMotorSpeed() {
-    if (output_state.motor_speed < 0) return 0;
-    if (output_state.motor_speed > 255)
+    int speed = q16_to_int(output_state.motor_speed);
+    if (speed < 0) return 0;
+    if (speed > 255)
         return 255;
     else
-        return (uint8_t)floor(output_state.motor_speed);
+        return (uint8_t)speed;
 }
 
 float orgasm_control_getMotorSpeedPercent() {
@@ -484,20 +1287,19 @@ float orgasm_control_getMotorSpeedPercent() {
 }
 
 uint16_t orgasm_control_getArousal() {
-    return arousal_state.arousal;
+    return arousal_state.detector.arousal;
 }
 
 float orgasm_control_getArousalPercent() {
-    return (float)arousal_state.arousal / Config.sensitivity_threshold;
+    return (float)arousal_state.detector.arousal / Config.sensitivity_threshold;
 }
 
 void orgasm_control_increment_arousal_threshold(int threshold) {
-    orgasm_control_set_arousal_threshold(Config.sensitivity_threshold + threshold);
+    orgasm_control_sendCommand(OC_COMMAND_INCREMENT_THRESHOLD, threshold);
 }
 
 void orgasm_control_set_arousal_threshold(int threshold) {
-    Config.sensitivity_threshold = threshold >= 0 ? threshold : 0;
-    config_enqueue_save(30);
+    orgasm_control_sendCommand(OC_COMMAND_SET_THRESHOLD, threshold);
 }
 
 int orgasm_control_get_arousal_threshold(void) {
@@ -509,7 +1311,7 @@ uint16_t orgasm_control_getLastPressure() {
 }
 
 uint16_t orgasm_control_getAveragePressure() {
-    return running_avergae_get_average(arousal_state.average);
+    return detector_get_average_pressure(&arousal_state.detector);
 }
 
 void orgasm_control_controlMotor(orgasm_output_mode_t control) {
@@ -517,40 +1319,25 @@ void orgasm_control_controlMotor(orgasm_output_mode_t control) {
 }
 
 void orgasm_control_set_output_mode(orgasm_output_mode_t control) {
-    orgasm_output_mode_t old = output_state.output_mode;
-    output_state.output_mode = control;
-    output_state.control_motor = control != OC_MANUAL_CONTROL;
-
-    if (old == OC_MANUAL_CONTROL) {
-        const vibration_mode_controller_t* controller = orgasm_control_getVibrationMode();
-        controller->start();
-    } else if (control == OC_MANUAL_CONTROL) {
-        const vibration_mode_controller_t* controller = orgasm_control_getVibrationMode();
-        controller->stop();
-    }
+    orgasm_control_sendCommand(OC_COMMAND_SET_OUTPUT_MODE, control);
 }
 
 void orgasm_control_pauseControl() {
-    output_state.prev_control_motor = output_state.control_motor;
-    output_state.control_motor = OC_MANUAL_CONTROL;
+    orgasm_control_sendCommand(OC_COMMAND_PAUSE_CONTROL, 0);
 }
 
 void orgasm_control_resumeControl() {
-    output_state.control_motor = output_state.prev_control_motor;
+    orgasm_control_sendCommand(OC_COMMAND_RESUME_CONTROL, 0);
 }
 
 void orgasm_control_permitOrgasmNow(int seconds) {
-    post_orgasm_state.detected_orgasm = ocFALSE;
-    orgasm_control_set_output_mode(OC_ORGASM_MODE);
-    post_orgasm_state.auto_edging_start_millis =
-        (esp_timer_get_time() / 1000UL) - (Config.auto_edging_duration_minutes * 60 * 1000);
-    post_orgasm_state.post_orgasm_duration_seconds = seconds;
+    orgasm_control_sendCommand(OC_COMMAND_PERMIT_ORGASM, seconds);
 }
 
 oc_bool_t orgasm_control_isPermitOrgasmReached() {
     // Detect if edging time has passed
-    if ((esp_timer_get_time() / 1000UL) > (post_orgasm_state.auto_edging_start_millis +
-                                           (Config.auto_edging_duration_minutes * 60 * 1000))) {
+    if (clock_state.tick_ms - post_orgasm_state.auto_edging_start_millis >
+        (unsigned long)(Config.auto_edging_duration_minutes * 60 * 1000)) {
         return ocTRUE;
     } else {
         return ocFALSE;
@@ -559,7 +1346,7 @@ oc_bool_t orgasm_control_isPermitOrgasmReached() {
 
 oc_bool_t orgasm_control_isPostOrgasmReached() {
     // Detect if after orgasm
-    if (post_orgasm_state.post_orgasm_start_millis > 0) {
+    if (post_orgasm_state.post_orgasm_start_millis != 0) {
         return ocTRUE;
     } else {
         return ocFALSE;
@@ -571,5 +1358,5 @@ oc_bool_t orgasm_control_isMenuLocked() {
 };
 
 void orgasm_control_lockMenuNow(oc_bool_t value) {
-    post_orgasm_state.menu_is_locked = value;
+    orgasm_control_sendCommand(OC_COMMAND_LOCK_MENU, value);
 }
\ No newline at end of file
@@ -20,9 +20,12 @@ static struct {
     uint64_t arousal_peak_update_ms;
     uint64_t speed_change_notice_ms;
     uint64_t arousal_change_notice_ms;
+    orgasm_control_subscriber_t events;
 } state;
 
 static void on_open(void* arg) {
+    orgasm_control_subscribe(&state.events);
+
     // ui_toast_multiline(
     //     "Richter: Die monster. You don't belong in this world!\n\n"
     //     "Dracula: It was not by my hand that I am once again given flesh. I was called here by "
@@ -40,14 +43,12 @@ static ui_render_flag_t on_loop(void* arg) {
     ui_render_flag_t render = NORENDER;
     uint32_t millis = esp_timer_get_time() / 1000UL;
 
-    if (orgasm_control_updated()) {
-        orgasm_control_clear_update_flag();
+    orgasm_control_event_t event;
 
+    while (orgasm_control_next_event(&state.events, &event)) {
         // Update Arousal Peak
-        uint16_t arousal = orgasm_control_getArousal();
-
-        if (arousal > state.arousal_peak) {
-            state.arousal_peak = arousal;
+        if (event.type == OC_EVENT_AROUSAL && event.value > state.arousal_peak) {
+            state.arousal_peak = event.value;
             state.arousal_peak_last_ms = millis;
         }
 
@@ -0,0 +1,43 @@
+#include "pressure_calibration.h"
+#include <math.h>
+
+void pressure_calibration_init(pressure_calibration_t* cal) {
+    quantile_init(&cal->low, 0.05f);
+    quantile_init(&cal->median, 0.50f);
+    quantile_init(&cal->high, 0.95f);
+}
+
+void pressure_calibration_add(pressure_calibration_t* cal, uint16_t pressure) {
+    quantile_add(&cal->low, pressure);
+    quantile_add(&cal->median, pressure);
+    quantile_add(&cal->high, pressure);
+}
+
+uint8_t pressure_calibration_suggest(
+    const pressure_calibration_t* cal, uint8_t sensitivity, uint16_t full_scale
+) {
+    float median = quantile_get(&cal->median);
+    float high = quantile_get(&cal->high);
+
+    // Nothing to scale from:
+    if (high < full_scale * 0.01f || median <= 0) {
+        return sensitivity;
+    }
+
+    float gain = PRESSURE_CALIBRATION_MEDIAN * full_scale / median;
+    float headroom = PRESSURE_CALIBRATION_HIGH * full_scale / high;
+    if (headroom < gain) gain = headroom;
+
+    if (fabsf(gain - 1.0f) < PRESSURE_CALIBRATION_DEADBAND) {
+        return sensitivity;
+    }
+
+    if (gain > 1.0f + PRESSURE_CALIBRATION_MAX_STEP) gain = 1.0f + PRESSURE_CALIBRATION_MAX_STEP;
+    if (gain < 1.0f - PRESSURE_CALIBRATION_MAX_STEP) gain = 1.0f - PRESSURE_CALIBRATION_MAX_STEP;
+
+    // At low sensitivities a 10% step rounds away to nothing, so always move by at least one:
+    long suggested = lroundf((sensitivity > 0 ? sensitivity : 1) * gain);
+    if (suggested == sensitivity) suggested += gain > 1.0f ? 1 : -1;
+
+    return suggested < 1 ? 1 : suggested > UINT8_MAX ? UINT8_MAX : suggested;
+}
@@ -0,0 +1,139 @@
+#include "sensor_guard.h"
+#include <string.h>
+
+// Scales a median absolute deviation to a standard deviation for normally distributed noise.
+#define MAD_TO_SIGMA 1.4826f
+
+static const char* sensor_fault_strs[] = {
+    "none",
+    "disconnected",
+    "saturated",
+    "noisy",
+};
+
+static uint16_t sensor_guard_median(uint16_t* values, uint8_t count) {
+    for (uint8_t i = 1; i < count; i++) {
+        uint16_t value = values[i];
+        uint8_t j = i;
+
+        while (j > 0 && values[j - 1] > value) {
+            values[j] = values[j - 1];
+            j--;
+        }
+
+        values[j] = value;
+    }
+
+    return values[count / 2];
+}
+
+// Tests a reading against the window, giving the median to stand in for it if it's an impulse.
+static bool sensor_guard_hampel(sensor_guard_t* guard, uint16_t pressure, uint16_t* median) {
+    uint16_t sorted[SENSOR_GUARD_WINDOW];
+    uint16_t deviations[SENSOR_GUARD_WINDOW];
+
+    // Too little history to tell an impulse from a level:
+    if (guard->count < 3) {
+        return false;
+    }
+
+    memcpy(sorted, guard->window, guard->count * sizeof(uint16_t));
+    *median = sensor_guard_median(sorted, guard->count);
+
+    for (uint8_t i = 0; i < guard->count; i++) {
+        deviations[i] = sorted[i] > *median ? sorted[i] - *median : *median - sorted[i];
+    }
+
+    float limit = SENSOR_GUARD_HAMPEL_K * MAD_TO_SIGMA *
+                  sensor_guard_median(deviations, guard->count);
+    if (limit < guard->min_deviation) limit = guard->min_deviation;
+
+    uint16_t deviation = pressure > *median ? pressure - *median : *median - pressure;
+    return deviation > limit;
+}
+
+static void sensor_guard_push(sensor_guard_t* guard, uint16_t pressure) {
+    guard->window[guard->index] = pressure;
+    if (++guard->index == SENSOR_GUARD_WINDOW) guard->index = 0;
+    if (guard->count < SENSOR_GUARD_WINDOW) guard->count++;
+}
+
+void sensor_guard_init(sensor_guard_t* guard, uint16_t full_scale, int sample_rate_hz) {
+    memset(guard, 0, sizeof(sensor_guard_t));
+
+    if (sample_rate_hz < 1) sample_rate_hz = 1;
+
+    guard->sample_rate_hz = sample_rate_hz;
+    guard->min_deviation = full_scale * SENSOR_GUARD_MIN_DEVIATION;
+    guard->low_rail = full_scale * SENSOR_GUARD_RAIL;
+    guard->high_rail = full_scale - guard->low_rail;
+    guard->rail_samples = sample_rate_hz * SENSOR_GUARD_RAIL_MS / 1000;
+    guard->clear_samples = sample_rate_hz * SENSOR_GUARD_CLEAR_MS / 1000;
+
+    // A single reading at a rail is an impulse, not a run:
+    if (guard->rail_samples < 2) guard->rail_samples = 2;
+    if (guard->clear_samples < 1) guard->clear_samples = 1;
+}
+
+uint16_t sensor_guard_update(sensor_guard_t* guard, uint16_t pressure) {
+    uint16_t median = pressure;
+    bool impulse = sensor_guard_hampel(guard, pressure, &median);
+
+    sensor_guard_push(guard, pressure);
+
+    // Runs only need counting up to the limit, so they can't wrap during a long disconnection:
+    if (pressure > guard->low_rail) {
+        guard->low_run = 0;
+    } else if (guard->low_run < guard->rail_samples) {
+        guard->low_run++;
+    }
+
+    if (pressure < guard->high_rail) {
+        guard->high_run = 0;
+    } else if (guard->high_run < guard->rail_samples) {
+        guard->high_run++;
+    }
+
+    // Only the first reading of a run at a rail counts as an impulse; the rest are left to the
+    // rail test, so unplugging reads as a disconnection and not as noise:
+    bool counted = impulse && guard->low_run <= 1 && guard->high_run <= 1;
+    guard->impulses = (guard->impulses << 1) | counted;
+    if (counted) guard->impulse_count++;
+
+    sensor_fault_t fault = SENSOR_FAULT_NONE;
+    if (guard->low_run >= guard->rail_samples) {
+        fault = SENSOR_FAULT_DISCONNECTED;
+    } else if (guard->high_run >= guard->rail_samples) {
+        fault = SENSOR_FAULT_SATURATED;
+    } else if (__builtin_popcount(guard->impulses) > SENSOR_GUARD_NOISE_IMPULSES) {
+        fault = SENSOR_FAULT_NOISY;
+    }
+
+    // Readings from the rail say nothing about the level the sensor comes back at, so start the
+    // window over rather than calling the first good readings impulses:
+    if (fault == SENSOR_FAULT_DISCONNECTED || fault == SENSOR_FAULT_SATURATED) {
+        guard->index = 0;
+        guard->count = 0;
+        guard->impulses = 0;
+    }
+
+    if (fault != SENSOR_FAULT_NONE) {
+        if (guard->fault == SENSOR_FAULT_NONE) guard->fault = fault;
+        guard->clean_run = 0;
+    } else if (guard->fault != SENSOR_FAULT_NONE && ++guard->clean_run >= guard->clear_samples) {
+        guard->fault = SENSOR_FAULT_NONE;
+    }
+
+    // Readings at a rail are held from the first, so a run never reaches the detector before it
+    // is long enough to raise a fault:
+    if (guard->fault != SENSOR_FAULT_NONE || guard->low_run > 0 || guard->high_run > 0) {
+        return guard->held;
+    }
+
+    if (!impulse) guard->held = pressure;
+    return impulse ? median : pressure;
+}
+
+const char* sensor_fault_str(sensor_fault_t fault) {
+    return (unsigned)fault < _SENSOR_FAULT_MAX ? sensor_fault_strs[fault] : "unknown";
+}
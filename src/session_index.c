@@ -0,0 +1,28 @@
+#include "session_index.h"
+#include <stdio.h>
+
+int session_index_segment_path(
+    char* buf, size_t len, const char* base, uint16_t segment, const char* suffix
+) {
+    if (segment == 0) {
+        return snprintf(buf, len, "%s%s", base, suffix);
+    }
+
+    return snprintf(buf, len, "%s_%u%s", base, segment + 1, suffix);
+}
+
+size_t session_index_find(const session_index_entry_t* entries, size_t count, uint32_t millis) {
+    size_t lo = 0, hi = count;
+
+    while (hi - lo > 1) {
+        size_t mid = (lo + hi) / 2;
+
+        if (entries[mid].millis <= millis) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
@@ -0,0 +1,519 @@
+#include "session_record.h"
+#include "orgasm_control.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define CONFIG_MAX_LEN (SESSION_RECORD_BLOCK_SIZE - sizeof(session_record_file_header_t) - 1)
+
+void session_record_write_header(
+    uint8_t* block, uint32_t start_time, uint16_t update_frequency_hz, const char* config
+) {
+    session_record_file_header_t header = {
+        .magic = SESSION_RECORD_FILE_MAGIC,
+        .version = SESSION_RECORD_VERSION,
+        .block_size = SESSION_RECORD_BLOCK_SIZE,
+        .start_time = start_time,
+        .update_frequency_hz = update_frequency_hz,
+        .config_length = 0,
+    };
+
+    memset(block, 0, SESSION_RECORD_BLOCK_SIZE);
+
+    if (config != NULL) {
+        size_t length = strnlen(config, CONFIG_MAX_LEN);
+        memcpy(block + sizeof(header), config, length);
+        header.config_length = length;
+    }
+
+    memcpy(block, &header, sizeof(header));
+}
+
+int session_record_read_header(
+    const uint8_t* block, session_record_file_header_t* header, const char** config
+) {
+    memcpy(header, block, sizeof(*header));
+
+    if (header->magic != SESSION_RECORD_FILE_MAGIC || header->version < 1 ||
+        header->version > SESSION_RECORD_VERSION ||
+        header->block_size != SESSION_RECORD_BLOCK_SIZE || header->config_length > CONFIG_MAX_LEN) {
+        return -1;
+    }
+
+    // The header block is zeroed past the config, so it's always terminated.
+    if (config != NULL) *config = (const char*)block + sizeof(*header);
+    return 0;
+}
+
+static void keyframe_from_sample(
+    session_record_keyframe_t* frame, const orgasm_control_sample_t* sample
+) {
+    frame->millis = sample->millis;
+    frame->pressure = sample->pressure;
+    frame->avg_pressure = sample->avg_pressure;
+    frame->arousal = sample->arousal;
+    frame->motor_speed = sample->motor_speed;
+    frame->denial_count = sample->denial_count;
+    frame->sensitivity_threshold = sample->sensitivity_threshold;
+    frame->clench_pressure_threshold = sample->clench_pressure_threshold;
+    frame->clench_duration = sample->clench_duration;
+    frame->shadow_arousal = sample->shadow_arousal;
+    frame->shadow_denial_count = sample->shadow_denial_count;
+    frame->reserved = 0;
+}
+
+static void sample_from_keyframe(
+    orgasm_control_sample_t* sample, const session_record_keyframe_t* frame
+) {
+    sample->millis = frame->millis;
+    sample->pressure = frame->pressure;
+    sample->avg_pressure = frame->avg_pressure;
+    sample->arousal = frame->arousal;
+    sample->motor_speed = frame->motor_speed;
+    sample->denial_count = frame->denial_count;
+    sample->sensitivity_threshold = frame->sensitivity_threshold;
+    sample->clench_pressure_threshold = frame->clench_pressure_threshold;
+    sample->clench_duration = frame->clench_duration;
+    sample->shadow_arousal = frame->shadow_arousal;
+    sample->shadow_denial_count = frame->shadow_denial_count;
+}
+
+int session_record_block_millis(const uint8_t* block, uint32_t* millis) {
+    session_record_block_header_t header;
+    memcpy(&header, block, sizeof(header));
+
+    if (header.magic != SESSION_RECORD_BLOCK_MAGIC &&
+        header.magic != SESSION_RECORD_COLUMN_BLOCK_MAGIC) {
+        return -1;
+    }
+
+    *millis = header.first.millis;
+    return 0;
+}
+
+static void keyframe_apply(session_record_keyframe_t* frame, const session_record_t* record) {
+    frame->millis += record->dt_ms;
+    frame->motor_speed = record->motor_speed;
+    frame->denial_count = record->denial_count;
+    frame->shadow_denial_count = record->shadow_denial_count;
+    frame->pressure += record->d_pressure;
+    frame->avg_pressure += record->d_avg_pressure;
+    frame->arousal += record->d_arousal;
+    frame->sensitivity_threshold += record->d_sensitivity_threshold;
+    frame->clench_pressure_threshold += record->d_clench_pressure_threshold;
+    frame->clench_duration += record->d_clench_duration;
+    frame->shadow_arousal += record->d_shadow_arousal;
+}
+
+static int64_t keyframe_column(const session_record_keyframe_t* frame, int column) {
+    switch (column) {
+    case SESSION_RECORD_MILLIS: return frame->millis;
+    case SESSION_RECORD_PRESSURE: return frame->pressure;
+    case SESSION_RECORD_AVG_PRESSURE: return frame->avg_pressure;
+    case SESSION_RECORD_AROUSAL: return frame->arousal;
+    case SESSION_RECORD_MOTOR_SPEED: return frame->motor_speed;
+    case SESSION_RECORD_DENIAL_COUNT: return frame->denial_count;
+    case SESSION_RECORD_SENSITIVITY_THRESHOLD: return frame->sensitivity_threshold;
+    case SESSION_RECORD_CLENCH_PRESSURE_THRESHOLD: return frame->clench_pressure_threshold;
+    case SESSION_RECORD_CLENCH_DURATION: return frame->clench_duration;
+    case SESSION_RECORD_SHADOW_AROUSAL: return frame->shadow_arousal;
+    case SESSION_RECORD_SHADOW_DENIAL_COUNT: return frame->shadow_denial_count;
+    default: return 0;
+    }
+}
+
+static void keyframe_columns(const session_record_keyframe_t* frame, int64_t* values) {
+    values[SESSION_RECORD_MILLIS] = frame->millis;
+    values[SESSION_RECORD_PRESSURE] = frame->pressure;
+    values[SESSION_RECORD_AVG_PRESSURE] = frame->avg_pressure;
+    values[SESSION_RECORD_AROUSAL] = frame->arousal;
+    values[SESSION_RECORD_MOTOR_SPEED] = frame->motor_speed;
+    values[SESSION_RECORD_DENIAL_COUNT] = frame->denial_count;
+    values[SESSION_RECORD_SENSITIVITY_THRESHOLD] = frame->sensitivity_threshold;
+    values[SESSION_RECORD_CLENCH_PRESSURE_THRESHOLD] = frame->clench_pressure_threshold;
+    values[SESSION_RECORD_CLENCH_DURATION] = frame->clench_duration;
+    values[SESSION_RECORD_SHADOW_AROUSAL] = frame->shadow_arousal;
+    values[SESSION_RECORD_SHADOW_DENIAL_COUNT] = frame->shadow_denial_count;
+}
+
+static void sample_set_column(orgasm_control_sample_t* sample, int column, int64_t value) {
+    switch (column) {
+    case SESSION_RECORD_MILLIS: sample->millis = (uint32_t)value; break;
+    case SESSION_RECORD_PRESSURE: sample->pressure = (uint16_t)value; break;
+    case SESSION_RECORD_AVG_PRESSURE: sample->avg_pressure = (uint16_t)value; break;
+    case SESSION_RECORD_AROUSAL: sample->arousal = (uint16_t)value; break;
+    case SESSION_RECORD_MOTOR_SPEED: sample->motor_speed = (uint8_t)value; break;
+    case SESSION_RECORD_DENIAL_COUNT: sample->denial_count = (uint8_t)value; break;
+    case SESSION_RECORD_SENSITIVITY_THRESHOLD: sample->sensitivity_threshold = value; break;
+    case SESSION_RECORD_CLENCH_PRESSURE_THRESHOLD: sample->clench_pressure_threshold = value; break;
+    case SESSION_RECORD_CLENCH_DURATION: sample->clench_duration = value; break;
+    case SESSION_RECORD_SHADOW_AROUSAL: sample->shadow_arousal = (uint16_t)value; break;
+    case SESSION_RECORD_SHADOW_DENIAL_COUNT: sample->shadow_denial_count = (uint8_t)value; break;
+    }
+}
+
+// Small values of either sign map to small unsigned ones: 0, -1, 1, -2 to 0, 1, 2, 3.
+static uint64_t zigzag(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t unzigzag(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static uint32_t varint_length(uint64_t value) {
+    return value == 0 ? 1 : (64 - __builtin_clzll(value) + 6) / 7;
+}
+
+static uint8_t* varint_write(uint8_t* out, uint64_t value) {
+    while (value >= 0x80) {
+        *out++ = value | 0x80;
+        value >>= 7;
+    }
+
+    *out++ = value;
+    return out;
+}
+
+static bool varint_read(const uint8_t** in, const uint8_t* end, uint64_t* value) {
+    *value = 0;
+
+    for (int shift = 0; shift < 64 && *in < end; shift += 7) {
+        uint8_t byte = *(*in)++;
+        *value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+
+    return false;
+}
+
+static uint32_t run_size(int64_t value, uint32_t length) {
+    return length == 0 ? 0 : varint_length(zigzag(value)) + varint_length(length);
+}
+
+static void stream_size_add(session_record_stream_size_t* stream, int64_t value) {
+    stream->plain += varint_length(zigzag(value));
+
+    if (stream->run_length > 0 && value == stream->run_value) {
+        stream->run_length++;
+        return;
+    }
+
+    stream->runs += run_size(stream->run_value, stream->run_length);
+    stream->run_value = value;
+    stream->run_length = 1;
+}
+
+static void column_start(session_record_column_state_t* column, int64_t first) {
+    memset(column, 0, sizeof(*column));
+    column->last = first;
+}
+
+static void column_add(session_record_column_state_t* column, int64_t value) {
+    int64_t delta = value - column->last;
+    stream_size_add(&column->streams[0], delta);
+    stream_size_add(&column->streams[1], delta - column->last_delta);
+    column->last = value;
+    column->last_delta = delta;
+}
+
+// The smallest codec for the column so far, and its length.
+static session_record_codec_t column_codec(
+    const session_record_column_state_t* column, uint32_t* length
+) {
+    session_record_codec_t best = SESSION_RECORD_DELTA;
+    *length = UINT32_MAX;
+
+    for (int codec = 0; codec < _SESSION_RECORD_CODEC_MAX; codec++) {
+        const session_record_stream_size_t* stream = &column->streams[codec >> 1];
+        uint32_t size = codec & 1 ? stream->runs + run_size(stream->run_value, stream->run_length)
+                                  : stream->plain;
+
+        if (size < *length) {
+            best = codec;
+            *length = size;
+        }
+    }
+
+    return best;
+}
+
+static uint8_t* column_write(
+    uint8_t* out,
+    session_record_codec_t codec,
+    const session_record_keyframe_t* samples,
+    uint16_t count,
+    int column
+) {
+    int64_t last = keyframe_column(&samples[0], column), last_delta = 0, run_value = 0;
+    uint32_t run_length = 0;
+
+    for (int i = 1; i < count; i++) {
+        int64_t next = keyframe_column(&samples[i], column);
+        int64_t delta = next - last;
+        int64_t value = codec & 2 ? delta - last_delta : delta;
+        last = next;
+        last_delta = delta;
+
+        if (!(codec & 1)) {
+            out = varint_write(out, zigzag(value));
+        } else if (run_length > 0 && value == run_value) {
+            run_length++;
+        } else {
+            if (run_length > 0) {
+                out = varint_write(out, zigzag(run_value));
+                out = varint_write(out, run_length);
+            }
+            run_value = value;
+            run_length = 1;
+        }
+    }
+
+    if (run_length > 0) {
+        out = varint_write(out, zigzag(run_value));
+        out = varint_write(out, run_length);
+    }
+
+    return out;
+}
+
+static int column_read(
+    const uint8_t* in,
+    const session_record_column_header_t* header,
+    orgasm_control_sample_t* samples,
+    uint16_t count,
+    int column,
+    int64_t first
+) {
+    const uint8_t* end = in + header->length;
+    int64_t last = first, last_delta = 0, value = 0;
+    uint64_t run_length = 0;
+
+    for (int i = 1; i < count; i++) {
+        if (run_length == 0) {
+            uint64_t zigzagged;
+            if (!varint_read(&in, end, &zigzagged)) return -1;
+            value = unzigzag(zigzagged);
+            run_length = 1;
+
+            if (header->codec & 1) {
+                if (!varint_read(&in, end, &run_length) || run_length == 0) return -1;
+            }
+        }
+
+        run_length--;
+        last_delta = header->codec & 2 ? last_delta + value : value;
+        last += last_delta;
+        sample_set_column(&samples[i], column, last);
+    }
+
+    // Every byte of the column accounts for exactly count - 1 values:
+    return in == end && run_length == 0 ? 0 : -1;
+}
+
+// Most a sample can grow a column by: a new run of a 10-byte varint, and a longer run length.
+#define COLUMN_MAX_GROWTH 11
+
+// Encoded size of the block with the given column sizes.
+static uint32_t block_size(const session_record_column_state_t* columns) {
+    uint32_t size = sizeof(session_record_block_header_t);
+
+    for (int i = 0; i < SESSION_RECORD_COLUMNS; i++) {
+        uint32_t length;
+        column_codec(&columns[i], &length);
+        size += sizeof(session_record_column_header_t) + length;
+    }
+
+    return size;
+}
+
+static void block_start(session_record_encoder_t* encoder) {
+    session_record_block_header_t header = {
+        .magic = SESSION_RECORD_COLUMN_BLOCK_MAGIC,
+        .seq = encoder->seq,
+        .count = 0,
+        .record_size = 0,
+    };
+
+    memset(encoder->block, 0, SESSION_RECORD_BLOCK_SIZE);
+    memcpy(encoder->block, &header, sizeof(header));
+    encoder->count = 0;
+}
+
+int session_record_encoder_init(session_record_encoder_t* encoder, uint8_t* block) {
+    encoder->samples = malloc(SESSION_RECORD_MAX_SAMPLES * sizeof(session_record_keyframe_t));
+
+    if (encoder->samples == NULL) {
+        return -1;
+    }
+
+    encoder->block = block;
+    encoder->seq = 0;
+    block_start(encoder);
+    return 0;
+}
+
+void session_record_encoder_free(session_record_encoder_t* encoder) {
+    free(encoder->samples);
+    encoder->samples = NULL;
+}
+
+void session_record_next_block(session_record_encoder_t* encoder) {
+    encoder->seq++;
+    block_start(encoder);
+}
+
+void session_record_next_block_at(session_record_encoder_t* encoder, uint8_t* block) {
+    encoder->block = block;
+    session_record_next_block(encoder);
+}
+
+bool session_record_add(
+    session_record_encoder_t* encoder, const struct orgasm_control_sample* sample
+) {
+    session_record_keyframe_t next;
+    int64_t values[SESSION_RECORD_COLUMNS];
+    keyframe_from_sample(&next, sample);
+    keyframe_columns(&next, values);
+
+    if (encoder->count == 0) {
+        for (int i = 0; i < SESSION_RECORD_COLUMNS; i++) {
+            column_start(&encoder->columns[i], values[i]);
+        }
+
+        encoder->size = block_size(encoder->columns);
+    } else if (encoder->count >= SESSION_RECORD_MAX_SAMPLES) {
+        session_record_finish(encoder);
+        return false;
+    } else if (encoder->size + SESSION_RECORD_COLUMNS * COLUMN_MAX_GROWTH <=
+               SESSION_RECORD_BLOCK_SIZE) {
+        // Fits whatever the sample is, so the exact size can wait:
+        for (int i = 0; i < SESSION_RECORD_COLUMNS; i++) {
+            column_add(&encoder->columns[i], values[i]);
+        }
+
+        encoder->size += SESSION_RECORD_COLUMNS * COLUMN_MAX_GROWTH;
+    } else {
+        // Maybe close to full, so sized exactly on a copy, leaving the block as it was if it
+        // doesn't fit:
+        session_record_column_state_t columns[SESSION_RECORD_COLUMNS];
+
+        for (int i = 0; i < SESSION_RECORD_COLUMNS; i++) {
+            columns[i] = encoder->columns[i];
+            column_add(&columns[i], values[i]);
+        }
+
+        if (block_size(columns) > SESSION_RECORD_BLOCK_SIZE) {
+            session_record_finish(encoder);
+            return false;
+        }
+
+        memcpy(encoder->columns, columns, sizeof(columns));
+        encoder->size = block_size(columns);
+    }
+
+    encoder->samples[encoder->count++] = next;
+    return true;
+}
+
+void session_record_finish(session_record_encoder_t* encoder) {
+    if (encoder->count == 0) {
+        return;
+    }
+
+    session_record_block_header_t header = {
+        .magic = SESSION_RECORD_COLUMN_BLOCK_MAGIC,
+        .seq = encoder->seq,
+        .count = encoder->count,
+        .record_size = 0,
+        .first = encoder->samples[0],
+    };
+    uint8_t* out = encoder->block + sizeof(header);
+
+    for (int i = 0; i < SESSION_RECORD_COLUMNS; i++) {
+        session_record_column_header_t column;
+        uint32_t length;
+
+        column.codec = column_codec(&encoder->columns[i], &length);
+        column.length = length;
+        memcpy(out, &column, sizeof(column));
+        out = column_write(out + sizeof(column), column.codec, encoder->samples, encoder->count, i);
+    }
+
+    memset(out, 0, encoder->block + SESSION_RECORD_BLOCK_SIZE - out);
+    memcpy(encoder->block, &header, sizeof(header));
+}
+
+static int decode_records(
+    const uint8_t* block,
+    const session_record_block_header_t* header,
+    orgasm_control_sample_t* samples
+) {
+    if (header->record_size != sizeof(session_record_t) || header->count == 0 ||
+        header->count > SESSION_RECORD_BLOCK_RECORDS + 1) {
+        return -1;
+    }
+
+    session_record_keyframe_t frame = header->first;
+    const uint8_t* records = block + sizeof(*header);
+    sample_from_keyframe(&samples[0], &frame);
+
+    for (int i = 1; i < header->count; i++) {
+        session_record_t record;
+        memcpy(&record, records + (i - 1) * sizeof(record), sizeof(record));
+        keyframe_apply(&frame, &record);
+        sample_from_keyframe(&samples[i], &frame);
+    }
+
+    return header->count;
+}
+
+static int decode_columns(
+    const uint8_t* block,
+    const session_record_block_header_t* header,
+    orgasm_control_sample_t* samples
+) {
+    if (header->record_size != 0 || header->count == 0 ||
+        header->count > SESSION_RECORD_MAX_SAMPLES) {
+        return -1;
+    }
+
+    session_record_keyframe_t first = header->first;
+    size_t offset = sizeof(*header);
+    sample_from_keyframe(&samples[0], &first);
+
+    for (int i = 0; i < SESSION_RECORD_COLUMNS; i++) {
+        session_record_column_header_t column;
+
+        if (offset + sizeof(column) > SESSION_RECORD_BLOCK_SIZE) return -1;
+        memcpy(&column, block + offset, sizeof(column));
+        offset += sizeof(column);
+
+        if (column.codec >= _SESSION_RECORD_CODEC_MAX ||
+            offset + column.length > SESSION_RECORD_BLOCK_SIZE) {
+            return -1;
+        }
+
+        int64_t value = keyframe_column(&first, i);
+        if (column_read(block + offset, &column, samples, header->count, i, value) < 0) return -1;
+        offset += column.length;
+    }
+
+    return header->count;
+}
+
+int session_record_decode(
+    const uint8_t* block, struct orgasm_control_sample* samples, uint32_t* seq
+) {
+    session_record_block_header_t header;
+    int count = -1;
+    memcpy(&header, block, sizeof(header));
+
+    if (header.magic == SESSION_RECORD_BLOCK_MAGIC) {
+        count = decode_records(block, &header, samples);
+    } else if (header.magic == SESSION_RECORD_COLUMN_BLOCK_MAGIC) {
+        count = decode_columns(block, &header, samples);
+    }
+
+    if (count > 0 && seq != NULL) *seq = header.seq;
+    return count;
+}
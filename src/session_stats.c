@@ -0,0 +1,97 @@
+#include "session_stats.h"
+#include "orgasm_control.h"
+#include <string.h>
+
+void session_stats_start(session_stats_t* stats, unsigned long now_ms) {
+    memset(stats, 0, sizeof(session_stats_t));
+    histogram_init(&stats->time_to_edge, SESSION_STATS_EDGE_BUCKET_MS);
+    stats->start_ms = now_ms;
+    stats->last_ms = now_ms;
+    stats->motor_start_ms = now_ms;
+}
+
+void session_stats_update(
+    session_stats_t* stats, const struct orgasm_control_sample* sample, bool orgasm
+) {
+    unsigned long elapsed_ms = sample->millis - stats->last_ms;
+
+    // The sample's denial count belongs to the whole device, so only count what changed. It's a
+    // uint8_t, so the difference is taken in 8 bits to survive a wrap.
+    if (stats->ticks > 0 && sample->denial_count != stats->denial_count) {
+        stats->denials += (uint8_t)(sample->denial_count - stats->denial_count);
+        histogram_add(&stats->time_to_edge, sample->millis - stats->motor_start_ms);
+    }
+
+    if (sample->motor_speed > 0 && stats->motor_speed == 0) {
+        stats->motor_start_ms = sample->millis;
+    }
+
+    if (sample->arousal > sample->sensitivity_threshold) {
+        stats->over_threshold_ms += elapsed_ms;
+    }
+
+    if (sample->arousal > stats->peak_arousal) {
+        stats->peak_arousal = sample->arousal;
+    }
+
+    if (sample->clench_duration > 0 && !stats->clenching) {
+        stats->clenches++;
+    }
+
+    if (orgasm && !stats->orgasm) {
+        stats->orgasms++;
+    }
+
+    stats->ticks++;
+    stats->motor_speed_sum += sample->motor_speed;
+    stats->duration_ms = sample->millis - stats->start_ms;
+    stats->last_ms = sample->millis;
+    stats->motor_speed = sample->motor_speed;
+    stats->denial_count = sample->denial_count;
+    stats->clenching = sample->clench_duration > 0;
+    stats->orgasm = orgasm;
+}
+
+float session_stats_motor_duty(const session_stats_t* stats) {
+    return stats->ticks > 0 ? (float)stats->motor_speed_sum / (stats->ticks * 255.0f) : 0.0f;
+}
+
+void session_stats_write_json(const session_stats_t* stats, long end_time, FILE* file) {
+    const histogram_t* edges = &stats->time_to_edge;
+    int used = HISTOGRAM_BUCKETS;
+
+    while (used > 0 && edges->buckets[used - 1] == 0) {
+        used--;
+    }
+
+    fprintf(
+        file,
+        "{\"endTime\":%ld,\"durationMs\":%lu,\"denials\":%u,\"orgasms\":%u,\"clenches\":%u,"
+        "\"peakArousal\":%u,\"overThresholdMs\":%lu,\"motorDuty\":%.3f,",
+        end_time,
+        stats->duration_ms,
+        stats->denials,
+        stats->orgasms,
+        stats->clenches,
+        stats->peak_arousal,
+        stats->over_threshold_ms,
+        session_stats_motor_duty(stats)
+    );
+
+    fprintf(
+        file,
+        "\"timeToEdge\":{\"count\":%u,\"min\":%u,\"avg\":%u,\"max\":%u,\"bucketMs\":%u,"
+        "\"buckets\":[",
+        edges->count,
+        edges->count > 0 ? edges->min : 0,
+        histogram_avg(edges),
+        edges->max,
+        edges->bucket_width
+    );
+
+    for (int i = 0; i < used; i++) {
+        fprintf(file, i > 0 ? ",%u" : "%u", edges->buckets[i]);
+    }
+
+    fprintf(file, "]}}\n");
+}
@@ -0,0 +1,122 @@
+#include "shadow_detector.h"
+#include "config.h"
+#include "detector.h"
+#include "util/perf_counter.h"
+#include <string.h>
+
+static CONTROL_LOCAL struct {
+    detector_t detector;
+    bool initialized;
+    bool running;
+    unsigned long motor_start_ms;
+    unsigned long motor_stop_ms;
+    uint8_t denial_count;
+    uint8_t orgasm_count;
+    arousal_detector_stats_t stats;
+} state;
+
+static void shadow_detector_params(detector_params_t* params) {
+    detector_params_from_config(params);
+    params->mode = Config.shadow_arousal_detector;
+
+    if (Config.shadow_sensitivity_threshold > 0) {
+        params->sensitivity_threshold = Config.shadow_sensitivity_threshold;
+    }
+}
+
+void shadow_detector_init(void) {
+    state.initialized = false;
+    state.running = false;
+    state.motor_start_ms = 0;
+    state.motor_stop_ms = 0;
+    state.denial_count = 0;
+    state.orgasm_count = 0;
+}
+
+// The automatic control rules from orgasm_control_updateMotorSpeed(), minus the motor.
+static void shadow_detector_decide(unsigned long now_ms) {
+    uint16_t arousal = state.detector.arousal;
+    int threshold = state.detector.params.sensitivity_threshold;
+
+    if (now_ms - state.motor_stop_ms <= Config.edge_delay) {
+        // Twitch detect, extending the delay while still over threshold:
+        if (arousal > threshold) {
+            state.motor_stop_ms = now_ms;
+        }
+    } else if (!state.running) {
+        state.running = true;
+        state.motor_start_ms = now_ms;
+    } else if (arousal > threshold && now_ms - state.motor_start_ms > Config.minimum_on_time) {
+        state.running = false;
+        state.motor_stop_ms = now_ms;
+        state.denial_count++;
+    }
+}
+
+void shadow_detector_update(
+    uint16_t pressure, bool permit_orgasm, bool controlling, unsigned long now_ms
+) {
+    if (!Config.use_shadow_detector) {
+        state.initialized = false;
+        return;
+    }
+
+    uint32_t start = perf_counter_get();
+
+    if (!state.initialized) {
+        detector_params_t params;
+        shadow_detector_params(&params);
+        detector_init(&state.detector, &params);
+        state.initialized = true;
+    }
+
+    shadow_detector_params(&state.detector.params);
+    detector_update(&state.detector, pressure, permit_orgasm);
+
+    if (state.detector.detected_orgasm) {
+        state.orgasm_count++;
+        state.detector.detected_orgasm = false;
+    }
+
+    if (controlling) {
+        shadow_detector_decide(now_ms);
+    } else {
+        state.running = false;
+    }
+
+    uint32_t cycles = perf_counter_get() - start;
+    state.stats.calls++;
+    state.stats.last_cycles = cycles;
+    state.stats.total_cycles += cycles;
+    if (cycles > state.stats.max_cycles) state.stats.max_cycles = cycles;
+}
+
+void shadow_detector_rebase(uint16_t pressure) {
+    if (state.initialized) {
+        detector_rebase(&state.detector, pressure);
+    }
+}
+
+bool shadow_detector_enabled(void) {
+    return Config.use_shadow_detector;
+}
+
+uint16_t shadow_detector_get_arousal(void) {
+    return state.initialized ? state.detector.arousal : 0;
+}
+
+uint8_t shadow_detector_get_denial_count(void) {
+    return state.denial_count;
+}
+
+uint8_t shadow_detector_get_orgasm_count(void) {
+    return state.orgasm_count;
+}
+
+const arousal_detector_stats_t* shadow_detector_get_stats(void) {
+    return &state.stats;
+}
+
+void shadow_detector_reset_stats(void) {
+    memset(&state.stats, 0, sizeof(state.stats));
+}
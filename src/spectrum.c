@@ -0,0 +1,117 @@
+#include "spectrum.h"
+#include <math.h>
+#include <string.h>
+
+static const char* spectrum_band_strs[] = {
+    "drift",
+    "contraction",
+    "noise",
+};
+
+void spectrum_init(spectrum_t* spectrum) {
+    memset(spectrum, 0, sizeof(spectrum_t));
+    fft_plan_init(&spectrum->plan, SPECTRUM_SIZE);
+}
+
+// Hann window, 0.5 - 0.5 cos(2πn/N), with the cosine read from the twiddle table.
+static float spectrum_window(const fft_plan_t* plan, uint16_t n) {
+    uint16_t k = n < plan->size / 2 ? n : plan->size - n;
+    return 0.5f - 0.5f * plan->twiddle[2 * k];
+}
+
+static void spectrum_analyze(spectrum_t* spectrum, float sample_rate_hz, spectrum_frame_t* frame) {
+    const fft_plan_t* plan = &spectrum->plan;
+    float* work = spectrum->work;
+    float* power = spectrum->power;
+    float mean = 0;
+    float window_energy = 0;
+
+    // Oldest first, starting from the next slot to be overwritten:
+    for (uint16_t n = 0; n < SPECTRUM_SIZE; n++) {
+        work[n] = spectrum->samples[(spectrum->index + n) % SPECTRUM_SIZE];
+        mean += work[n];
+    }
+
+    mean /= SPECTRUM_SIZE;
+
+    for (uint16_t n = 0; n < SPECTRUM_SIZE; n++) {
+        float w = spectrum_window(plan, n);
+        work[n] = (work[n] - mean) * w;
+        window_energy += w * w;
+    }
+
+    fft_real(plan, work);
+    fft_power(plan, work, power);
+
+    // Scales one-sided bin power to mean square pressure:
+    float scale = 2.0f / (SPECTRUM_SIZE * window_energy);
+    float band_power[_SPECTRUM_BAND_MAX] = { 0 };
+    float bin_hz = sample_rate_hz / SPECTRUM_SIZE;
+    uint16_t peak = 0;
+    uint16_t band_bins = 0;
+
+    for (uint16_t k = 1; k < SPECTRUM_BINS; k++) {
+        float hz = k * bin_hz;
+        spectrum_band_t band = hz < SPECTRUM_CONTRACTION_MIN_HZ   ? SPECTRUM_BAND_DRIFT
+                               : hz > SPECTRUM_CONTRACTION_MAX_HZ ? SPECTRUM_BAND_NOISE
+                                                                  : SPECTRUM_BAND_CONTRACTION;
+
+        band_power[band] += power[k];
+        frame->amplitude[k] = sqrtf(power[k] * scale);
+
+        if (band == SPECTRUM_BAND_CONTRACTION) {
+            band_bins++;
+            if (peak == 0 || power[k] > power[peak]) peak = k;
+        }
+    }
+
+    frame->amplitude[0] = 0;
+    frame->bin_hz = bin_hz;
+    frame->contraction_rate_hz = 0;
+
+    for (int b = 0; b < _SPECTRUM_BAND_MAX; b++) {
+        frame->band_rms[b] = sqrtf(band_power[b] * scale);
+    }
+
+    // Only a peak that stands out of the band is a rhythm. Its position is refined with a
+    // parabola through the neighbouring bins.
+    float band_mean = band_bins > 0 ? band_power[SPECTRUM_BAND_CONTRACTION] / band_bins : 0;
+    if (peak > 0 && power[peak] > band_mean * SPECTRUM_RATE_PROMINENCE) {
+        float offset = 0;
+        if (peak + 1 < SPECTRUM_BINS) {
+            float l = power[peak - 1], c = power[peak], r = power[peak + 1];
+            float curve = l - 2 * c + r;
+            if (curve < 0) offset = 0.5f * (l - r) / curve;
+        }
+
+        frame->contraction_rate_hz = (peak + offset) * bin_hz;
+    }
+}
+
+bool spectrum_update(
+    spectrum_t* spectrum,
+    uint16_t pressure,
+    float sample_rate_hz,
+    unsigned long millis,
+    spectrum_frame_t* frame
+) {
+    spectrum->samples[spectrum->index] = pressure;
+    spectrum->index = (spectrum->index + 1) % SPECTRUM_SIZE;
+
+    if (spectrum->count < SPECTRUM_SIZE) {
+        spectrum->count++;
+    }
+
+    if (++spectrum->since_analysis < SPECTRUM_HOP || spectrum->count < SPECTRUM_SIZE) {
+        return false;
+    }
+
+    spectrum->since_analysis = 0;
+    spectrum_analyze(spectrum, sample_rate_hz, frame);
+    frame->millis = millis;
+    return true;
+}
+
+const char* spectrum_band_str(spectrum_band_t band) {
+    return band < _SPECTRUM_BAND_MAX ? spectrum_band_strs[band] : "";
+}
@@ -0,0 +1,247 @@
+#include "system/black_box.h"
+#include "SDHelper.h"
+#include "config.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "orgasm_control.h"
+#include "sensor_guard.h"
+#include "session_record.h"
+#include "system/recorder.h"
+#include "system/sd_logger.h"
+#include "util/ring_buffer.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static const char* TAG = "system/black_box";
+
+// Blocks hold up to SESSION_RECORD_MAX_SAMPLES, depending on how much the samples vary. The ring
+// is sized for a little less than a recorded session fits, so noisier ones keep a bit less time.
+#define BLACK_BOX_SAMPLES_PER_BLOCK 1000
+
+static struct {
+    // Ring of block_count blocks. The block for seq s is at (s % block_count), so it holds the
+    // latest block_count blocks, the current one partly filled.
+    uint8_t* blocks;
+    uint32_t block_count;
+    session_record_encoder_t encoder;
+    // What the ring was sized for.
+    int seconds;
+    int update_frequency_hz;
+
+    ring_buffer_reader_t reader;
+    orgasm_control_subscriber_t events;
+    _Atomic bool requested;
+
+    // Automatic dump waiting for its delay.
+    bool triggered;
+    unsigned long trigger_ms;
+    unsigned long last_auto_ms;
+
+    // Dump in progress, from dump_seq to dump_end.
+    sd_logger_t logger;
+    char path[48];
+    uint32_t dump_seq;
+    uint32_t dump_end;
+} state;
+
+static uint8_t* black_box_block(uint32_t seq) {
+    return state.blocks + (seq % state.block_count) * SESSION_RECORD_BLOCK_SIZE;
+}
+
+// (Re)allocates the ring when the config changes. Returns false while the black box is off.
+static bool black_box_resize(void) {
+    if (Config.black_box_seconds == state.seconds &&
+        Config.update_frequency_hz == state.update_frequency_hz) {
+        return state.blocks != NULL;
+    }
+
+    // Not under a running dump:
+    if (sd_logger_is_open(&state.logger)) {
+        return true;
+    }
+
+    if (state.blocks != NULL) {
+        session_record_encoder_free(&state.encoder);
+        free(state.blocks);
+        state.blocks = NULL;
+    }
+
+    state.seconds = Config.black_box_seconds;
+    state.update_frequency_hz = Config.update_frequency_hz;
+
+    if (state.seconds <= 0 || state.update_frequency_hz <= 0) {
+        return false;
+    }
+
+    // Enough whole blocks for the time asked, plus the one being filled:
+    uint32_t samples = state.seconds * state.update_frequency_hz;
+    uint32_t per_block = BLACK_BOX_SAMPLES_PER_BLOCK;
+    state.block_count = (samples + per_block - 1) / per_block + 1;
+    state.blocks = malloc(state.block_count * SESSION_RECORD_BLOCK_SIZE);
+
+    if (state.blocks != NULL && session_record_encoder_init(&state.encoder, state.blocks) != 0) {
+        free(state.blocks);
+        state.blocks = NULL;
+    }
+
+    if (state.blocks == NULL) {
+        ESP_LOGE(TAG, "No memory for a %ds black box.", state.seconds);
+        return false;
+    }
+
+    ring_buffer_reader_init(orgasm_control_get_sample_ring(), &state.reader);
+    orgasm_control_subscribe(&state.events);
+    state.triggered = false;
+    state.last_auto_ms = 0;
+
+    ESP_LOGI(TAG, "Keeping %ds in %u blocks.", state.seconds, state.block_count);
+    return true;
+}
+
+static void black_box_start_dump(const char* reason) {
+    time_t now;
+    struct tm timeinfo;
+    char filename_date[32];
+    char* path = NULL;
+    unsigned long now_ms = esp_timer_get_time() / 1000UL;
+    time(&now);
+
+    if (!localtime_r(&now, &timeinfo)) {
+        sniprintf(filename_date, 32, "%lu", now_ms);
+    } else {
+        strftime(filename_date, 32, "%Y%m%d-%H%M%S", &timeinfo);
+    }
+
+    asiprintf(&path, "/blackbox-%s.eom", filename_date);
+    FILE* file = SDHelper_open(path, "w+");
+    uint8_t* header = malloc(SESSION_RECORD_BLOCK_SIZE);
+
+    if (file == NULL || header == NULL || sd_logger_open(&state.logger, file) != ESP_OK) {
+        ESP_LOGE(TAG, "Couldn't open %s!", path);
+        if (file != NULL) fclose(file);
+        free(header);
+        free(path);
+        return;
+    }
+
+    // Samples keep their uptime millis, so millis 0 is when the device started:
+    recorder_write_header(header, now - now_ms / 1000);
+    sd_logger_write(&state.logger, header, SESSION_RECORD_BLOCK_SIZE, 0);
+    free(header);
+
+    state.dump_end = state.encoder.seq;
+    state.dump_seq = state.dump_end >= state.block_count ? state.dump_end - state.block_count + 1
+                                                         : 0;
+
+    snprintf(state.path, sizeof(state.path), "%s", path);
+    ESP_LOGI(TAG, "Dumping to %s (%s).", path, reason);
+    free(path);
+}
+
+// Hands blocks to the logger while it has room, oldest first, then has it close the file. The
+// logger stays open until the writer is done, and later ticks check on it.
+static void black_box_dump_tick(void) {
+    while (state.dump_seq <= state.dump_end &&
+           sd_logger_has_room(&state.logger, SESSION_RECORD_BLOCK_SIZE)) {
+        uint32_t seq = state.dump_seq++;
+
+        // The ring moved on past this block before it was dumped:
+        if (state.encoder.seq - seq >= state.block_count) {
+            sd_logger_drop(&state.logger, 1);
+            continue;
+        }
+
+        // The current block is only encoded once complete:
+        if (seq == state.encoder.seq) {
+            session_record_finish(&state.encoder);
+        }
+
+        const uint8_t* block = black_box_block(seq);
+        session_record_block_header_t header;
+        memcpy(&header, block, sizeof(header));
+
+        if (header.count > 0) {
+            sd_logger_write(&state.logger, block, SESSION_RECORD_BLOCK_SIZE, header.count);
+        }
+    }
+
+    if (state.dump_seq <= state.dump_end) {
+        return;
+    }
+
+    sd_logger_close_begin(&state.logger);
+    if (!sd_logger_close_poll(&state.logger)) {
+        return;
+    }
+
+    sd_logger_stats_t stats;
+    sd_logger_get_stats(&state.logger, &stats);
+    ESP_LOGI(TAG, "Dump done: %u samples, %u blocks lost.", stats.records, stats.dropped);
+
+    // Dumps count towards recording_retention_mb too:
+    recorder_retain(state.path);
+    recorder_apply_retention();
+}
+
+static void black_box_trigger(const char* reason, unsigned long now_ms) {
+    // One automatic dump per black box length is enough to cover a burst of triggers:
+    if (state.triggered || sd_logger_is_open(&state.logger) ||
+        (state.last_auto_ms != 0 && now_ms - state.last_auto_ms < state.seconds * 1000UL)) {
+        return;
+    }
+
+    ESP_LOGI(TAG, "Triggered by %s, dumping in %dms.", reason, BLACK_BOX_TRIGGER_DELAY_MS);
+    state.triggered = true;
+    state.trigger_ms = now_ms;
+}
+
+void black_box_tick(void) {
+    if (!black_box_resize()) {
+        return;
+    }
+
+    orgasm_control_sample_t sample;
+
+    while (ring_buffer_read(orgasm_control_get_sample_ring(), &state.reader, &sample)) {
+        if (!session_record_add(&state.encoder, &sample)) {
+            session_record_next_block_at(&state.encoder, black_box_block(state.encoder.seq + 1));
+            session_record_add(&state.encoder, &sample);
+        }
+    }
+
+    unsigned long now_ms = esp_timer_get_time() / 1000UL;
+    orgasm_control_event_t event;
+
+    while (orgasm_control_next_event(&state.events, &event)) {
+        if (event.type == OC_EVENT_ORGASM) {
+            black_box_trigger("orgasm", now_ms);
+        } else if (event.type == OC_EVENT_SENSOR_FAULT && event.value != SENSOR_FAULT_NONE) {
+            black_box_trigger("sensor fault", now_ms);
+        }
+    }
+
+    if (sd_logger_is_open(&state.logger)) {
+        black_box_dump_tick();
+    } else if (atomic_exchange_explicit(&state.requested, false, memory_order_acquire)) {
+        black_box_start_dump("requested");
+    } else if (state.triggered && now_ms - state.trigger_ms >= BLACK_BOX_TRIGGER_DELAY_MS) {
+        state.triggered = false;
+        state.last_auto_ms = now_ms;
+        black_box_start_dump("triggered");
+    }
+}
+
+bool black_box_dump(void) {
+    if (!black_box_enabled()) {
+        return false;
+    }
+
+    atomic_store_explicit(&state.requested, true, memory_order_release);
+    return true;
+}
+
+bool black_box_enabled(void) {
+    return Config.black_box_seconds > 0;
+}
@@ -0,0 +1,116 @@
+#include "system/control_snapshot.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "nvs.h"
+
+#define NVS_NAMESPACE "control"
+#define NVS_SNAPSHOT_KEY "snapshot"
+
+static const char* TAG = "system/control_snapshot";
+
+static struct {
+    // Whether NVS holds a session, so ended sessions are only erased once.
+    bool saved;
+} state;
+
+static bool control_snapshot_resumable(esp_reset_reason_t reason) {
+    switch (reason) {
+    case ESP_RST_BROWNOUT:
+    case ESP_RST_PANIC:
+    case ESP_RST_INT_WDT:
+    case ESP_RST_TASK_WDT:
+    case ESP_RST_WDT: return true;
+    // ESP_RST_SW is a deliberate restart, such as after an update, so it starts clean.
+    default: return false;
+    }
+}
+
+static void control_snapshot_erase(void) {
+    esp_err_t err;
+    nvs_handle_t nvs;
+
+    err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) return;
+
+    err = nvs_erase_key(nvs, NVS_SNAPSHOT_KEY);
+    if (err == ESP_OK) {
+        nvs_commit(nvs);
+    }
+
+    nvs_close(nvs);
+    state.saved = false;
+}
+
+bool control_snapshot_load(orgasm_control_snapshot_t* snapshot) {
+    esp_err_t err;
+    nvs_handle_t nvs;
+    size_t len = sizeof(orgasm_control_snapshot_t);
+    esp_reset_reason_t reason = esp_reset_reason();
+
+    err = nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs);
+    if (err != ESP_OK) return false;
+
+    err = nvs_get_blob(nvs, NVS_SNAPSHOT_KEY, snapshot, &len);
+    nvs_close(nvs);
+
+    if (err != ESP_OK) {
+        return false;
+    }
+
+    state.saved = true;
+
+    if (!control_snapshot_resumable(reason)) {
+        ESP_LOGI(TAG, "Discarding session snapshot after reset reason %d.", reason);
+        control_snapshot_erase();
+        return false;
+    }
+
+    if (len != sizeof(orgasm_control_snapshot_t) ||
+        snapshot->version != ORGASM_CONTROL_SNAPSHOT_VERSION) {
+        ESP_LOGW(TAG, "Discarding incompatible session snapshot.");
+        control_snapshot_erase();
+        return false;
+    }
+
+    ESP_LOGI(
+        TAG,
+        "Resuming session after reset reason %d: mode %d, %d denials",
+        reason,
+        snapshot->output_mode,
+        snapshot->denial_count
+    );
+
+    return true;
+}
+
+void control_snapshot_tick(void) {
+    esp_err_t err;
+    nvs_handle_t nvs = 0;
+    orgasm_control_snapshot_t snapshot;
+
+    if (!orgasm_control_take_snapshot(&snapshot)) {
+        return;
+    }
+
+    if (snapshot.output_mode == OC_MANUAL_CONTROL) {
+        if (state.saved) control_snapshot_erase();
+        return;
+    }
+
+    err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) goto cleanup;
+
+    err = nvs_set_blob(nvs, NVS_SNAPSHOT_KEY, &snapshot, sizeof(snapshot));
+    if (err != ESP_OK) goto cleanup;
+
+    err = nvs_commit(nvs);
+    if (err != ESP_OK) goto cleanup;
+
+    nvs_close(nvs);
+    state.saved = true;
+    return;
+
+cleanup:
+    ESP_LOGW(TAG, "Trouble saving session snapshot: %s", esp_err_to_name(err));
+    if (nvs) nvs_close(nvs);
+}
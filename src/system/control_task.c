@@ -0,0 +1,111 @@
+#include "system/control_task.h"
+#include "config.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "orgasm_control.h"
+#include <stdatomic.h>
+
+static const char* TAG = "system/control_task";
+
+#define CONTROL_TASK_CORE 1
+#define CONTROL_TASK_PRIORITY (configMAX_PRIORITIES - 2)
+#define CONTROL_TASK_STACK_SIZE (1024 * 4)
+
+// 32 buckets of 100us covers up to 3.2ms of jitter before clamping.
+#define CONTROL_JITTER_BUCKET_US 100
+
+static struct {
+    TaskHandle_t task;
+    esp_timer_handle_t timer;
+    int64_t period_us;
+    int64_t last_wake_us;
+    histogram_t jitter;
+    // Set by other tasks; the control task clears the histogram before it next records.
+    _Atomic bool reset_jitter;
+} state;
+
+static void control_timer_cb(void* arg) {
+    xTaskNotifyGive(state.task);
+}
+
+static int64_t control_task_period_us(void) {
+    int hz = orgasm_control_get_sample_rate_hz();
+    return 1000000LL / (hz > 0 ? hz : 50);
+}
+
+// Restarts the timer if the update or sample rate has changed.
+static void control_task_check_period(void) {
+    int64_t period_us = control_task_period_us();
+    if (period_us == state.period_us) return;
+
+    ESP_LOGI(TAG, "Control period: %lldus", period_us);
+    esp_timer_stop(state.timer);
+    esp_timer_start_periodic(state.timer, period_us);
+    state.period_us = period_us;
+    state.last_wake_us = 0;
+}
+
+static void control_task(void* arg) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        int64_t now = esp_timer_get_time();
+
+        if (atomic_exchange_explicit(&state.reset_jitter, false, memory_order_acquire)) {
+            histogram_reset(&state.jitter);
+            state.last_wake_us = 0;
+        }
+
+        if (state.last_wake_us > 0) {
+            int64_t deviation = (now - state.last_wake_us) - state.period_us;
+            histogram_add(&state.jitter, deviation < 0 ? -deviation : deviation);
+        }
+
+        state.last_wake_us = now;
+        orgasm_control_sample();
+        control_task_check_period();
+    }
+}
+
+esp_err_t control_task_init(void) {
+    esp_err_t err;
+    histogram_init(&state.jitter, CONTROL_JITTER_BUCKET_US);
+
+    BaseType_t ok = xTaskCreatePinnedToCore(
+        control_task,
+        "CONTROL",
+        CONTROL_TASK_STACK_SIZE,
+        NULL,
+        CONTROL_TASK_PRIORITY,
+        &state.task,
+        CONTROL_TASK_CORE
+    );
+
+    if (ok != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create control task.");
+        return ESP_ERR_NO_MEM;
+    }
+
+    const esp_timer_create_args_t args = {
+        .callback = control_timer_cb,
+        .name = "control",
+    };
+
+    err = esp_timer_create(&args, &state.timer);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create control timer: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    state.period_us = control_task_period_us();
+    return esp_timer_start_periodic(state.timer, state.period_us);
+}
+
+const histogram_t* control_task_get_jitter(void) {
+    return &state.jitter;
+}
+
+void control_task_reset_jitter(void) {
+    atomic_store_explicit(&state.reset_jitter, true, memory_order_release);
+}
@@ -0,0 +1,64 @@
+#include "system/perf_stats.h"
+#include "config.h"
+
+static const char* perf_stage_names[] = {
+    "sensorRead",    "arousal",   "edgingTime", "motor",  "shadow",     "spectrum",
+    "controlUpdate", "mainApi",   "mainHal",    "mainUi", "mainLogger", "csvFormat",
+    "recordEncode",  "broadcast",
+};
+
+// Control stages take a few us (a spectrum analysis a few hundred), the main loop stages up to a
+// display flush or SD write.
+static const uint32_t perf_stage_bucket_us[] = {
+    [PERF_STAGE_SENSOR_READ] = 2,
+    [PERF_STAGE_AROUSAL] = 2,
+    [PERF_STAGE_EDGING_TIME] = 2,
+    [PERF_STAGE_MOTOR] = 2,
+    [PERF_STAGE_SHADOW] = 2,
+    [PERF_STAGE_SPECTRUM] = 20,
+    [PERF_STAGE_CONTROL_UPDATE] = 5,
+    [PERF_STAGE_MAIN_API] = 500,
+    [PERF_STAGE_MAIN_HAL] = 500,
+    [PERF_STAGE_MAIN_UI] = 500,
+    [PERF_STAGE_MAIN_LOGGER] = 100,
+    [PERF_STAGE_CSV_FORMAT] = 20,
+    [PERF_STAGE_RECORD_ENCODE] = 2,
+    [PERF_STAGE_BROADCAST] = 50,
+};
+
+static CONTROL_LOCAL histogram_t perf_stages[_PERF_STAGE_MAX];
+
+#if PERF_STATS_ENABLED
+static void perf_stats_add(perf_stage_t stage, uint32_t us) {
+    histogram_t* hist = &perf_stages[stage];
+
+    // Histograms start zeroed, and are set up by the first recording.
+    if (hist->bucket_width == 0) {
+        histogram_init(hist, perf_stage_bucket_us[stage]);
+    }
+
+    histogram_add(hist, us);
+}
+
+void perf_stats_record(perf_stage_t stage, uint32_t start) {
+    perf_stats_add(stage, perf_counter_to_us(perf_counter_get() - start));
+}
+
+void perf_stats_record_us(perf_stage_t stage, uint32_t start) {
+    perf_stats_add(stage, (uint32_t)esp_timer_get_time() - start);
+}
+#endif
+
+const histogram_t* perf_stats_get(perf_stage_t stage) {
+    return &perf_stages[stage];
+}
+
+const char* perf_stats_stage_name(perf_stage_t stage) {
+    return stage < _PERF_STAGE_MAX ? perf_stage_names[stage] : "";
+}
+
+void perf_stats_reset(void) {
+    for (int i = 0; i < _PERF_STAGE_MAX; i++) {
+        histogram_init(&perf_stages[i], perf_stage_bucket_us[i]);
+    }
+}
@@ -0,0 +1,646 @@
+#include "system/recorder.h"
+#include "SDHelper.h"
+#include "config.h"
+#include "config_defs.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "orgasm_control.h"
+#include "session_index.h"
+#include "session_record.h"
+#include "system/perf_stats.h"
+#include "ui/toast.h"
+#include "ui/ui.h"
+#include "util/fs.h"
+#include "util/i18n.h"
+#include "util/ring_buffer.h"
+#include <dirent.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+static const char* TAG = "system/recorder";
+
+// Index entries kept between appends to the index file, about five minutes' worth.
+#define RECORDER_INDEX_BATCH 32
+
+typedef struct recording_file {
+    char* name;
+    off_t size;
+} recording_file_t;
+
+static struct {
+    unsigned long start_ms;
+    time_t start_time;
+    // Path of the recording less segment number and extension, as /log-20230101-120000.
+    char base[40];
+    // Each segment's loggers take turns, so one segment can finish writing out while the next
+    // fills. log and raw point at the current segment's.
+    sd_logger_t logs[2];
+    sd_logger_t raws[2];
+    sd_logger_t* log;
+    sd_logger_t* raw;
+    // The last segment, while its loggers are closing.
+    bool closing;
+    uint16_t closing_segment;
+    ring_buffer_reader_t reader;
+    ring_buffer_reader_t raw_reader;
+    // Binary recordings build one block here, and log it once full. NULL for CSV.
+    uint8_t* block;
+    session_record_encoder_t encoder;
+
+    // The current segment: its number, when it started, and the bytes logged to it so far.
+    uint16_t segment;
+    unsigned long segment_ms;
+    uint32_t segment_bytes;
+    // Counters of the segments already closed.
+    sd_logger_stats_t closed_stats;
+
+    session_index_entry_t index[RECORDER_INDEX_BATCH];
+    size_t index_count;
+    unsigned long next_index_ms;
+} state = {
+    .log = &state.logs[0],
+    .raw = &state.raws[0],
+};
+
+// Recordings and black box dumps on the card, oldest first, for recording_retention_mb. The card
+// is only listed once; files are added as they're closed after that.
+static struct {
+    recording_file_t* files;
+    size_t count;
+    size_t capacity;
+    bool listed;
+} retention;
+
+static bool recorder_open(sd_logger_t* logger, const char* path) {
+    FILE* file = SDHelper_open(path, "w+");
+
+    if (file == NULL) {
+        ESP_LOGE(TAG, "Couldn't open %s!", path);
+        return false;
+    }
+
+    if (sd_logger_open(logger, file) != ESP_OK) {
+        fclose(file);
+        return false;
+    }
+
+    return true;
+}
+
+// Writes to the current segment, keeping count of its size for the index.
+static void recorder_log(const void* data, size_t len, uint32_t records) {
+    if (sd_logger_write(state.log, data, len, records)) {
+        state.segment_bytes += len;
+    }
+}
+
+void recorder_write_header(uint8_t* block, time_t start_time) {
+    // The config the session ran with, less the WiFi password:
+    config_t* snapshot = malloc(sizeof(config_t));
+    char* config = calloc(1, SESSION_RECORD_BLOCK_SIZE);
+
+    if (snapshot != NULL && config != NULL) {
+        *snapshot = Config;
+        snapshot->wifi_key[0] = '\0';
+        config_serialize(snapshot, config, SESSION_RECORD_BLOCK_SIZE);
+    }
+
+    session_record_write_header(block, start_time, Config.update_frequency_hz, config);
+
+    free(snapshot);
+    free(config);
+}
+
+static void recorder_flush_block(void) {
+    if (session_record_empty(&state.encoder)) {
+        return;
+    }
+
+    recorder_log(state.block, SESSION_RECORD_BLOCK_SIZE, state.encoder.count);
+    session_record_next_block(&state.encoder);
+}
+
+static void recorder_add_binary(const orgasm_control_sample_t* sample) {
+    uint32_t start = perf_stats_begin_us();
+
+    if (!session_record_add(&state.encoder, sample)) {
+        recorder_flush_block();
+        session_record_add(&state.encoder, sample);
+    }
+
+    perf_stats_record_us(PERF_STAGE_RECORD_ENCODE, start);
+}
+
+static void recorder_add_csv(const orgasm_control_sample_t* sample) {
+    uint32_t start = perf_stats_begin_us();
+    char row[128];
+
+    int len = snprintf(
+        row,
+        sizeof(row),
+        "%ld,%d,%d,%d,%d,%d,%ld,%d,%d,%d\n",
+        sample->millis,
+        sample->pressure,
+        sample->avg_pressure,
+        sample->arousal,
+        sample->motor_speed,
+        sample->sensitivity_threshold,
+        sample->clench_pressure_threshold,
+        sample->clench_duration,
+        sample->shadow_arousal,
+        sample->shadow_denial_count
+    );
+
+    recorder_log(row, len, 1);
+    perf_stats_record_us(PERF_STAGE_CSV_FORMAT, start);
+}
+
+static bool recorder_open_segment(void) {
+    char path[64];
+    state.segment_bytes = 0;
+
+    if (state.block != NULL) {
+        // The block is only encoded into once complete, so it can carry the header until then:
+        session_index_segment_path(path, sizeof(path), state.base, state.segment, ".eom");
+        if (!recorder_open(state.log, path)) return false;
+        recorder_write_header(state.block, state.start_time);
+        recorder_log(state.block, SESSION_RECORD_BLOCK_SIZE, 0);
+    } else {
+        static const char header[] =
+            "millis,pressure,avg_pressure,arousal,motor_speed,sensitivity_threshold,"
+            "clench_pressure_threshold,clench_duration,shadow_arousal,shadow_denial_count\n";
+
+        session_index_segment_path(path, sizeof(path), state.base, state.segment, ".csv");
+        if (!recorder_open(state.log, path)) return false;
+        recorder_log(header, sizeof(header) - 1, 0);
+    }
+
+    ESP_LOGI(TAG, "Recording to %s", path);
+
+    // Oversampled sessions also keep the full-rate pressure stream:
+    if (orgasm_control_get_decimation_ratio() > 1) {
+        static const char header[] = "millis,sample,pressure\n";
+
+        session_index_segment_path(path, sizeof(path), state.base, state.segment, "-raw.csv");
+        if (recorder_open(state.raw, path)) {
+            sd_logger_write(state.raw, header, sizeof(header) - 1, 0);
+        }
+    }
+
+    // Every segment starts with an index entry:
+    state.next_index_ms = 0;
+    return true;
+}
+
+static void recorder_add_stats(sd_logger_stats_t* total, const sd_logger_t* logger) {
+    sd_logger_stats_t stats;
+    sd_logger_get_stats(logger, &stats);
+
+    total->records += stats.records;
+    total->dropped += stats.dropped;
+    total->late += stats.late;
+    if (stats.max_write_ms > total->max_write_ms) {
+        total->max_write_ms = stats.max_write_ms;
+    }
+}
+
+static sd_logger_t* recorder_other(sd_logger_t* loggers, sd_logger_t* logger) {
+    return logger == &loggers[0] ? &loggers[1] : &loggers[0];
+}
+
+static void recorder_retain_segment(uint16_t segment) {
+    char path[64];
+
+    session_index_segment_path(
+        path, sizeof(path), state.base, segment, state.block != NULL ? ".eom" : ".csv"
+    );
+    recorder_retain(path);
+
+    session_index_segment_path(path, sizeof(path), state.base, segment, "-raw.csv");
+    recorder_retain(path);
+}
+
+// Counts the last segment once its loggers are closed, or with wait, blocks until they are.
+static void recorder_finish_closing(bool wait) {
+    if (!state.closing) {
+        return;
+    }
+
+    sd_logger_t* log = recorder_other(state.logs, state.log);
+    sd_logger_t* raw = recorder_other(state.raws, state.raw);
+
+    if (wait) {
+        sd_logger_close(log);
+        sd_logger_close(raw);
+    } else if (!sd_logger_close_poll(log) || !sd_logger_close_poll(raw)) {
+        return;
+    }
+
+    state.closing = false;
+    recorder_add_stats(&state.closed_stats, log);
+    recorder_retain_segment(state.closing_segment);
+    recorder_apply_retention();
+}
+
+static void recorder_close_segment(void) {
+    recorder_finish_closing(true);
+    sd_logger_close(state.log);
+    sd_logger_close(state.raw);
+    recorder_add_stats(&state.closed_stats, state.log);
+    recorder_retain_segment(state.segment);
+}
+
+static void recorder_write_index(const void* data, size_t len, const char* mode) {
+    char path[48];
+    snprintf(path, sizeof(path), "%s.idx", state.base);
+    FILE* file = SDHelper_open(path, mode);
+
+    if (file != NULL) {
+        fwrite(data, 1, len, file);
+        fclose(file);
+    }
+}
+
+// A few hundred bytes every few minutes, so these go straight to the card.
+static void recorder_flush_index(void) {
+    if (state.index_count > 0) {
+        recorder_write_index(state.index, state.index_count * sizeof(state.index[0]), "ab");
+        state.index_count = 0;
+    }
+}
+
+static void recorder_index(unsigned long millis) {
+    if (millis < state.next_index_ms) {
+        return;
+    }
+
+    state.index[state.index_count++] = (session_index_entry_t){
+        .millis = millis,
+        .segment = state.segment,
+        .offset = state.segment_bytes,
+    };
+    state.next_index_ms = millis - millis % SESSION_INDEX_INTERVAL_MS + SESSION_INDEX_INTERVAL_MS;
+
+    if (state.index_count == RECORDER_INDEX_BATCH) {
+        recorder_flush_index();
+    }
+}
+
+static bool recorder_segment_full(unsigned long millis) {
+    return (Config.recording_segment_minutes > 0 &&
+            millis - state.segment_ms >= Config.recording_segment_minutes * 60000UL) ||
+           (Config.recording_segment_kb > 0 &&
+            state.segment_bytes >= Config.recording_segment_kb * 1024UL);
+}
+
+// Frees what the recording held once its files are closed.
+static void recorder_release(void) {
+    recorder_flush_index();
+
+    if (state.block != NULL) {
+        session_record_encoder_free(&state.encoder);
+        free(state.block);
+        state.block = NULL;
+    }
+}
+
+// Starts the next segment on the other loggers, leaving the last one to close in the background.
+static void recorder_rotate(unsigned long millis) {
+    if (state.block != NULL) {
+        session_record_finish(&state.encoder);
+        recorder_flush_block();
+    }
+
+    // Only if the segment before is still being written out, after minutes of recording:
+    recorder_finish_closing(true);
+
+    sd_logger_close_begin(state.log);
+    sd_logger_close_begin(state.raw);
+    state.closing = true;
+    state.closing_segment = state.segment;
+    state.log = recorder_other(state.logs, state.log);
+    state.raw = recorder_other(state.raws, state.raw);
+
+    recorder_flush_index();
+
+    state.segment++;
+    state.segment_ms = millis;
+
+    if (!recorder_open_segment()) {
+        recorder_finish_closing(true);
+        recorder_release();
+        ui_set_icon(UI_ICON_RECORD, -1);
+        ui_toast("%s", _("Error opening logfile!"));
+    }
+}
+
+static bool recorder_is_recording_file(const char* name) {
+    return !strncmp(name, "log-", 4) || !strncmp(name, "blackbox-", 9);
+}
+
+static bool recorder_is_running_file(const char* name) {
+    return recorder_is_recording() && !strncmp(name, state.base + 1, strlen(state.base + 1));
+}
+
+// Oldest first: both kinds of file are named for their date after the first dash.
+static int recording_file_compare(const void* a, const void* b) {
+    const recording_file_t* file_a = a;
+    const recording_file_t* file_b = b;
+    return strcmp(strchr(file_a->name, '-'), strchr(file_b->name, '-'));
+}
+
+// Adds a file, or updates its size if it's already there, keeping the oldest first.
+static void recorder_retention_add(const char* name, off_t size) {
+    recording_file_t file = {.name = NULL, .size = size};
+    size_t i = retention.count;
+
+    for (size_t j = 0; j < retention.count; j++) {
+        if (!strcmp(retention.files[j].name, name)) {
+            retention.files[j].size = size;
+            return;
+        }
+    }
+
+    if (retention.count == retention.capacity) {
+        size_t capacity = retention.capacity == 0 ? 32 : retention.capacity * 2;
+        recording_file_t* grown = realloc(retention.files, capacity * sizeof(recording_file_t));
+        if (grown == NULL) return;
+        retention.files = grown;
+        retention.capacity = capacity;
+    }
+
+    file.name = strdup(name);
+    if (file.name == NULL) return;
+
+    while (i > 0 && recording_file_compare(&retention.files[i - 1], &file) > 0) {
+        retention.files[i] = retention.files[i - 1];
+        i--;
+    }
+
+    retention.files[i] = file;
+    retention.count++;
+}
+
+static void recorder_retention_list(void) {
+    DIR* d = opendir(fs_sd_root());
+    struct dirent* dir;
+    char path[PATH_MAX];
+
+    if (d == NULL) {
+        return;
+    }
+
+    while ((dir = readdir(d)) != NULL) {
+        struct stat st;
+
+        if (dir->d_type != DT_REG || !recorder_is_recording_file(dir->d_name)) {
+            continue;
+        }
+
+        snprintf(path, sizeof(path), "%s/%s", fs_sd_root(), dir->d_name);
+        if (stat(path, &st) != 0) continue;
+
+        recorder_retention_add(dir->d_name, st.st_size);
+    }
+
+    closedir(d);
+    retention.listed = true;
+}
+
+void recorder_retain(const char* path) {
+    char full[PATH_MAX];
+    struct stat st;
+
+    snprintf(full, sizeof(full), "%s%s", fs_sd_root(), path);
+
+    // Until the card is listed, it will be picked up then:
+    if (!retention.listed || stat(full, &st) != 0) {
+        return;
+    }
+
+    recorder_retention_add(path[0] == '/' ? path + 1 : path, st.st_size);
+}
+
+void recorder_apply_retention(void) {
+    if (Config.recording_retention_mb <= 0) {
+        return;
+    }
+
+    if (!retention.listed) {
+        recorder_retention_list();
+    }
+
+    uint64_t limit = (uint64_t)Config.recording_retention_mb * 1024 * 1024;
+    uint64_t total = 0;
+    char path[PATH_MAX];
+
+    // The files of the running recording are never deleted, nor counted:
+    for (size_t i = 0; i < retention.count; i++) {
+        if (!recorder_is_running_file(retention.files[i].name)) {
+            total += retention.files[i].size;
+        }
+    }
+
+    size_t kept = 0;
+
+    for (size_t i = 0; i < retention.count; i++) {
+        recording_file_t* file = &retention.files[i];
+
+        if (total > limit && !recorder_is_running_file(file->name)) {
+            snprintf(path, sizeof(path), "%s/%s", fs_sd_root(), file->name);
+
+            bool deleted = unlink(path) == 0;
+
+            if (deleted) {
+                ESP_LOGI(
+                    TAG, "Deleted %s to stay under %dMB.", file->name, Config.recording_retention_mb
+                );
+            }
+
+            // A file deleted some other way since it was listed is forgotten too:
+            if (deleted || errno == ENOENT) {
+                total -= file->size;
+                free(file->name);
+                continue;
+            }
+        }
+
+        retention.files[kept++] = *file;
+    }
+
+    retention.count = kept;
+}
+
+void recorder_start(void) {
+    if (recorder_is_recording()) {
+        recorder_stop();
+    }
+
+    ui_toast_blocking("%s", _("Preapring recording..."));
+
+    time_t now;
+    struct tm timeinfo;
+    char filename_date[32];
+    char path[64];
+    time(&now);
+
+    state.start_ms = esp_timer_get_time() / 1000UL;
+    state.start_time = now;
+
+    if (!localtime_r(&now, &timeinfo)) {
+        ESP_LOGE(TAG, "Failed to obtain time");
+        sniprintf(filename_date, 32, "%lu", state.start_ms);
+    } else {
+        strftime(filename_date, 32, "%Y%m%d-%H%M%S", &timeinfo);
+    }
+
+    snprintf(state.base, sizeof(state.base), "/log-%s", filename_date);
+
+    if (Config.recording_format == RecordBinary) {
+        state.block = malloc(SESSION_RECORD_BLOCK_SIZE);
+
+        if (state.block != NULL && session_record_encoder_init(&state.encoder, state.block) != 0) {
+            free(state.block);
+            state.block = NULL;
+        }
+
+        if (state.block == NULL) {
+            ESP_LOGW(TAG, "No memory for a binary recording, recording CSV.");
+        }
+    }
+
+    state.segment = 0;
+    state.segment_ms = 0;
+    state.index_count = 0;
+    memset(&state.closed_stats, 0, sizeof(state.closed_stats));
+
+    if (!recorder_open_segment()) {
+        ui_toast("%s", _("Error opening logfile!"));
+        recorder_release();
+        return;
+    }
+
+    session_index_header_t header = {
+        .magic = SESSION_INDEX_MAGIC,
+        .version = SESSION_INDEX_VERSION,
+        .entry_size = sizeof(session_index_entry_t),
+        .start_time = now,
+        .format = state.block != NULL ? RecordBinary : RecordCSV,
+    };
+    recorder_write_index(&header, sizeof(header), "wb");
+
+    ring_buffer_reader_init(orgasm_control_get_sample_ring(), &state.reader);
+    ring_buffer_reader_init(orgasm_control_get_raw_ring(), &state.raw_reader);
+
+    recorder_apply_retention();
+
+    session_index_segment_path(path, sizeof(path), state.base, 0, state.block ? ".eom" : ".csv");
+    ui_set_icon(UI_ICON_RECORD, RECORD_ICON_RECORDING);
+    ui_toast(_("Recording started:\n%s"), path);
+}
+
+void recorder_stop(void) {
+    if (!recorder_is_recording()) {
+        return;
+    }
+
+    ui_toast_blocking("%s", _("Stopping..."));
+
+    // Pick up what's left in the rings first:
+    recorder_tick();
+
+    if (state.block != NULL) {
+        session_record_finish(&state.encoder);
+        recorder_flush_block();
+    }
+
+    recorder_close_segment();
+    recorder_release();
+
+    char path[48];
+    snprintf(path, sizeof(path), "%s.idx", state.base);
+    recorder_retain(path);
+
+    ESP_LOGI(
+        TAG,
+        "Recording stopped: %u records in %u segments, %u dropped, %u late, longest write %ums",
+        state.closed_stats.records,
+        state.segment + 1,
+        state.closed_stats.dropped,
+        state.closed_stats.late,
+        state.closed_stats.max_write_ms
+    );
+
+    ui_set_icon(UI_ICON_RECORD, -1);
+    ui_toast("%s", _("Recording stopped."));
+}
+
+bool recorder_is_recording(void) {
+    return sd_logger_is_open(state.log);
+}
+
+void recorder_tick(void) {
+    if (!recorder_is_recording()) {
+        return;
+    }
+
+    recorder_finish_closing(false);
+
+    orgasm_control_sample_t sample;
+    uint32_t dropped = state.reader.dropped;
+
+    while (ring_buffer_read(orgasm_control_get_sample_ring(), &state.reader, &sample)) {
+        sample.millis -= state.start_ms;
+
+        if (recorder_segment_full(sample.millis)) {
+            recorder_rotate(sample.millis);
+            if (!recorder_is_recording()) return;
+        }
+
+        // Index entries point at where the sample goes: a CSV row at the end of the segment, a
+        // binary sample into the block being built, after any block it completes.
+        if (state.block != NULL) {
+            recorder_add_binary(&sample);
+            recorder_index(sample.millis);
+        } else {
+            recorder_index(sample.millis);
+            recorder_add_csv(&sample);
+        }
+    }
+
+    // Samples the ring overwrote before they were read:
+    sd_logger_drop(state.log, state.reader.dropped - dropped);
+
+    if (!sd_logger_is_open(state.raw)) {
+        return;
+    }
+
+    orgasm_control_raw_sample_t raw;
+    dropped = state.raw_reader.dropped;
+
+    while (ring_buffer_read(orgasm_control_get_raw_ring(), &state.raw_reader, &raw)) {
+        char row[48];
+        int len = snprintf(
+            row, sizeof(row), "%ld,%u,%u\n", raw.millis - state.start_ms, raw.seq, raw.pressure
+        );
+        sd_logger_write(state.raw, row, len, 1);
+    }
+
+    sd_logger_drop(state.raw, state.raw_reader.dropped - dropped);
+}
+
+void recorder_get_stats(sd_logger_stats_t* stats) {
+    *stats = state.closed_stats;
+
+    if (recorder_is_recording()) {
+        recorder_add_stats(stats, state.log);
+    }
+
+    if (state.closing) {
+        recorder_add_stats(stats, recorder_other(state.logs, state.log));
+    }
+}
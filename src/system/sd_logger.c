@@ -0,0 +1,225 @@
+#include "system/sd_logger.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char* TAG = "system/sd_logger";
+
+#define SD_LOGGER_TASK_STACK_SIZE (1024 * 4)
+
+// Below the main task, so the card only gets time the UI and API don't need.
+#define SD_LOGGER_TASK_PRIORITY tskIDLE_PRIORITY
+
+static void sd_logger_write_buffer(sd_logger_t* logger, sd_logger_buffer_t* buffer) {
+    int64_t start = esp_timer_get_time();
+
+    if (fwrite(buffer->data, 1, buffer->used, logger->file) != buffer->used) {
+        ESP_LOGW(TAG, "Write failed, %u records lost.", buffer->records);
+        logger->failed += buffer->records;
+    } else {
+        logger->stats.records += buffer->records;
+    }
+
+    int64_t end = esp_timer_get_time();
+    uint32_t write_ms = (end - start) / 1000;
+
+    if (write_ms > logger->stats.max_write_ms) {
+        logger->stats.max_write_ms = write_ms;
+    }
+
+    if (end - buffer->queued_us > SD_LOGGER_LATE_MS * 1000LL) {
+        logger->stats.late += buffer->records;
+    }
+}
+
+static void sd_logger_task(void* arg) {
+    sd_logger_t* logger = (sd_logger_t*)arg;
+
+    for (;;) {
+        // Read before draining: once closing is set, the last buffer has been queued.
+        bool closing = atomic_load_explicit(&logger->closing, memory_order_acquire);
+        uint32_t written = atomic_load_explicit(&logger->written, memory_order_relaxed);
+
+        while (written != atomic_load_explicit(&logger->queued, memory_order_acquire)) {
+            sd_logger_buffer_t* buffer = &logger->buffers[written % SD_LOGGER_BUFFERS];
+            sd_logger_write_buffer(logger, buffer);
+
+            buffer->used = 0;
+            buffer->records = 0;
+            atomic_store_explicit(&logger->written, ++written, memory_order_release);
+        }
+
+        if (closing) break;
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+
+    // Closing flushes the directory entry, which can take as long as a write:
+    fclose(logger->file);
+
+    atomic_store_explicit(&logger->closed, true, memory_order_release);
+    if (logger->closer != NULL) {
+        xTaskNotifyGive(logger->closer);
+    }
+    vTaskDelete(NULL);
+}
+
+// The producer's buffer, or NULL while every buffer is waiting on the card.
+static sd_logger_buffer_t* sd_logger_active(sd_logger_t* logger) {
+    uint32_t queued = atomic_load_explicit(&logger->queued, memory_order_relaxed);
+    uint32_t written = atomic_load_explicit(&logger->written, memory_order_acquire);
+
+    if (queued - written >= SD_LOGGER_BUFFERS) {
+        return NULL;
+    }
+
+    return &logger->buffers[queued % SD_LOGGER_BUFFERS];
+}
+
+static void sd_logger_queue(sd_logger_t* logger, sd_logger_buffer_t* buffer) {
+    buffer->queued_us = esp_timer_get_time();
+    atomic_fetch_add_explicit(&logger->queued, 1, memory_order_release);
+    xTaskNotifyGive(logger->writer);
+}
+
+esp_err_t sd_logger_open(sd_logger_t* logger, FILE* file) {
+    logger->buffers = calloc(SD_LOGGER_BUFFERS, sizeof(sd_logger_buffer_t));
+
+    if (logger->buffers == NULL) {
+        ESP_LOGE(TAG, "No memory for buffers.");
+        return ESP_ERR_NO_MEM;
+    }
+
+    atomic_init(&logger->queued, 0);
+    atomic_init(&logger->written, 0);
+    atomic_init(&logger->closing, false);
+    atomic_init(&logger->closed, false);
+    memset(&logger->stats, 0, sizeof(logger->stats));
+    logger->failed = 0;
+
+    // The buffers already batch writes, so they go straight to the card:
+    setvbuf(file, NULL, _IONBF, 0);
+    logger->file = file;
+
+    BaseType_t ok = xTaskCreate(
+        sd_logger_task,
+        "SD_LOGGER",
+        SD_LOGGER_TASK_STACK_SIZE,
+        logger,
+        SD_LOGGER_TASK_PRIORITY,
+        &logger->writer
+    );
+
+    if (ok != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create writer task.");
+        free(logger->buffers);
+        logger->buffers = NULL;
+        logger->file = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    return ESP_OK;
+}
+
+bool sd_logger_write(sd_logger_t* logger, const void* data, size_t len, uint32_t records) {
+    sd_logger_buffer_t* buffer = sd_logger_active(logger);
+
+    if (buffer != NULL && buffer->used + len > SD_LOGGER_BUFFER_SIZE) {
+        sd_logger_queue(logger, buffer);
+        buffer = sd_logger_active(logger);
+    }
+
+    if (buffer == NULL || len > SD_LOGGER_BUFFER_SIZE) {
+        logger->stats.dropped += records;
+        return false;
+    }
+
+    memcpy(buffer->data + buffer->used, data, len);
+    buffer->used += len;
+    buffer->records += records;
+
+    // Whole blocks go out as soon as they're complete:
+    if (buffer->used == SD_LOGGER_BUFFER_SIZE) {
+        sd_logger_queue(logger, buffer);
+    }
+
+    return true;
+}
+
+bool sd_logger_has_room(sd_logger_t* logger, size_t len) {
+    sd_logger_buffer_t* buffer = sd_logger_active(logger);
+
+    if (buffer != NULL && buffer->used + len <= SD_LOGGER_BUFFER_SIZE) {
+        return true;
+    }
+
+    // Otherwise the active buffer is queued, and the next one must be free:
+    uint32_t queued = atomic_load_explicit(&logger->queued, memory_order_relaxed);
+    uint32_t written = atomic_load_explicit(&logger->written, memory_order_acquire);
+    return buffer != NULL && queued + 1 - written < SD_LOGGER_BUFFERS &&
+           len <= SD_LOGGER_BUFFER_SIZE;
+}
+
+void sd_logger_flush(sd_logger_t* logger) {
+    sd_logger_buffer_t* buffer = sd_logger_active(logger);
+
+    if (buffer != NULL && buffer->used > 0) {
+        sd_logger_queue(logger, buffer);
+    }
+}
+
+void sd_logger_drop(sd_logger_t* logger, uint32_t records) {
+    logger->stats.dropped += records;
+}
+
+void sd_logger_get_stats(const sd_logger_t* logger, sd_logger_stats_t* stats) {
+    *stats = logger->stats;
+    stats->dropped += logger->failed;
+}
+
+// Hands the last buffer to the writer and tells it to close the file once it's written.
+static void sd_logger_request_close(sd_logger_t* logger, TaskHandle_t closer) {
+    sd_logger_flush(logger);
+
+    logger->closer = closer;
+    atomic_store_explicit(&logger->closing, true, memory_order_release);
+    xTaskNotifyGive(logger->writer);
+}
+
+void sd_logger_close_begin(sd_logger_t* logger) {
+    if (logger->file == NULL || atomic_load_explicit(&logger->closing, memory_order_relaxed)) {
+        return;
+    }
+
+    sd_logger_request_close(logger, NULL);
+}
+
+bool sd_logger_close_poll(sd_logger_t* logger) {
+    if (logger->file == NULL) {
+        return true;
+    }
+
+    if (!atomic_load_explicit(&logger->closed, memory_order_acquire)) {
+        return false;
+    }
+
+    logger->file = NULL;
+    free(logger->buffers);
+    logger->buffers = NULL;
+    return true;
+}
+
+void sd_logger_close(sd_logger_t* logger) {
+    if (logger->file == NULL) {
+        return;
+    }
+
+    // A close already begun doesn't notify anyone, so this polls for it instead:
+    if (!atomic_load_explicit(&logger->closing, memory_order_relaxed)) {
+        sd_logger_request_close(logger, xTaskGetCurrentTaskHandle());
+    }
+
+    while (!sd_logger_close_poll(logger)) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+    }
+}
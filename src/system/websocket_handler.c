@@ -32,7 +32,8 @@ esp_err_t websocket_send_to_client(websocket_client_t* client, const char* msg)
 esp_err_t websocket_broadcast(cJSON* root, int broadcast_flags) {
     char* str = cJSON_PrintUnformatted(root);
 
-    if (!cJSON_HasObjectItem(root, "readings")) {
+    // Skip the frequent, bulky streams:
+    if (!cJSON_HasObjectItem(root, "readings") && !cJSON_HasObjectItem(root, "spectrum")) {
         ESP_LOGD(TAG, "Broadcasting: %s", str);
     }
 
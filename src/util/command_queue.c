@@ -0,0 +1,73 @@
+#include "util/command_queue.h"
+#include <string.h>
+
+int command_queue_init(
+    command_queue_t* queue,
+    void* storage,
+    _Atomic uint32_t* seqs,
+    size_t item_size,
+    size_t capacity
+) {
+    if (queue == NULL || storage == NULL || seqs == NULL || capacity == 0 ||
+        (capacity & (capacity - 1)) != 0) {
+        return -1;
+    }
+
+    queue->data = (uint8_t*)storage;
+    queue->seqs = seqs;
+    queue->item_size = item_size;
+    queue->mask = capacity - 1;
+    queue->head = 0;
+    atomic_init(&queue->tail, 0);
+
+    // Slot i is free for the write at position i:
+    for (uint32_t i = 0; i < capacity; i++) {
+        atomic_init(&seqs[i], i);
+    }
+
+    return 0;
+}
+
+bool command_queue_push(command_queue_t* queue, const void* item) {
+    uint32_t pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+
+    for (;;) {
+        _Atomic uint32_t* seq = &queue->seqs[pos & queue->mask];
+        int32_t diff = (int32_t)(atomic_load_explicit(seq, memory_order_acquire) - pos);
+
+        if (diff < 0) {
+            // The slot still holds the record from a lap ago:
+            return false;
+        }
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(
+                    &queue->tail, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed
+                )) {
+                uint8_t* slot = queue->data + (pos & queue->mask) * queue->item_size;
+                memcpy(slot, item, queue->item_size);
+                atomic_store_explicit(seq, pos + 1, memory_order_release);
+                return true;
+            }
+        } else {
+            // Another writer took this position first:
+            pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+        }
+    }
+}
+
+bool command_queue_pop(command_queue_t* queue, void* item) {
+    uint32_t pos = queue->head;
+    _Atomic uint32_t* seq = &queue->seqs[pos & queue->mask];
+
+    if (atomic_load_explicit(seq, memory_order_acquire) != pos + 1) {
+        return false;
+    }
+
+    memcpy(item, queue->data + (pos & queue->mask) * queue->item_size, queue->item_size);
+
+    // Free the slot for the write one lap on:
+    atomic_store_explicit(seq, pos + queue->mask + 1, memory_order_release);
+    queue->head = pos + 1;
+    return true;
+}
@@ -0,0 +1,35 @@
+#include "util/decimator.h"
+#include <string.h>
+
+void decimator_init(decimator_t* dec, uint8_t ratio) {
+    if (ratio < 1) ratio = 1;
+    if (ratio > DECIMATOR_MAX_RATIO) ratio = DECIMATOR_MAX_RATIO;
+
+    memset(dec, 0, sizeof(decimator_t));
+    dec->ratio = ratio;
+    dec->gain = (uint32_t)ratio * ratio * ratio;
+}
+
+bool decimator_push(decimator_t* dec, uint16_t in, uint16_t* out) {
+    uint32_t acc = in;
+
+    for (int i = 0; i < DECIMATOR_ORDER; i++) {
+        dec->integrators[i] += acc;
+        acc = dec->integrators[i];
+    }
+
+    if (++dec->phase < dec->ratio) {
+        return false;
+    }
+
+    dec->phase = 0;
+
+    for (int i = 0; i < DECIMATOR_ORDER; i++) {
+        uint32_t prev = dec->combs[i];
+        dec->combs[i] = acc;
+        acc -= prev;
+    }
+
+    *out = (uint16_t)((acc + dec->gain / 2) / dec->gain);
+    return true;
+}
@@ -0,0 +1,125 @@
+#include "util/fft.h"
+#include <math.h>
+
+int fft_plan_init(fft_plan_t* plan, uint16_t size) {
+    if (size < 4 || size > FFT_MAX_SIZE || (size & (size - 1)) != 0) {
+        return -1;
+    }
+
+    plan->size = size;
+
+    for (uint16_t k = 0; k < size / 2; k++) {
+        double angle = -2.0 * M_PI * k / size;
+        plan->twiddle[2 * k] = cos(angle);
+        plan->twiddle[2 * k + 1] = sin(angle);
+    }
+
+    uint16_t m = size / 2;
+    int bits = 0;
+    while ((1 << bits) < m) bits++;
+
+    for (uint16_t i = 0; i < m; i++) {
+        uint16_t r = 0;
+        for (int b = 0; b < bits; b++) {
+            if (i & (1 << b)) r |= 1 << (bits - 1 - b);
+        }
+        plan->bitrev[i] = r;
+    }
+
+    return 0;
+}
+
+// Radix-2 decimation in time over m complex points. Stage twiddles are every (size / len)th entry
+// of the plan's table.
+static void fft_complex(const fft_plan_t* plan, float* z, uint16_t m) {
+    const float* twiddle = plan->twiddle;
+
+    for (uint16_t i = 0; i < m; i++) {
+        uint16_t j = plan->bitrev[i];
+        if (i < j) {
+            float re = z[2 * i], im = z[2 * i + 1];
+            z[2 * i] = z[2 * j];
+            z[2 * i + 1] = z[2 * j + 1];
+            z[2 * j] = re;
+            z[2 * j + 1] = im;
+        }
+    }
+
+    // The first stage's only twiddle is 1:
+    for (uint16_t a = 0; a < m; a += 2) {
+        float* x = &z[2 * a];
+        float re = x[2], im = x[3];
+        x[2] = x[0] - re;
+        x[3] = x[1] - im;
+        x[0] += re;
+        x[1] += im;
+    }
+
+    for (uint16_t len = 4; len <= m; len <<= 1) {
+        uint16_t half = len / 2;
+        uint16_t stride = 2 * (plan->size / len);
+
+        for (uint16_t k = 0; k < half; k++) {
+            float wr = twiddle[k * stride];
+            float wi = twiddle[k * stride + 1];
+
+            for (uint16_t a = k; a < m; a += len) {
+                float* x = &z[2 * a];
+                float* y = &z[2 * (a + half)];
+                float tr = y[0] * wr - y[1] * wi;
+                float ti = y[0] * wi + y[1] * wr;
+
+                y[0] = x[0] - tr;
+                y[1] = x[1] - ti;
+                x[0] += tr;
+                x[1] += ti;
+            }
+        }
+    }
+}
+
+void fft_real(const fft_plan_t* plan, float* data) {
+    uint16_t m = plan->size / 2;
+    const float* twiddle = plan->twiddle;
+
+    // Even samples as real parts, odd samples as imaginary parts:
+    fft_complex(plan, data, m);
+
+    // Split the half-size result into the spectrum of the real input. With Z the complex
+    // transform, E[k] = (Z[k] + Z*[m-k]) / 2 and O[k] = -i (Z[k] - Z*[m-k]) / 2 are the transforms
+    // of the even and odd samples, and X[k] = E[k] + W^k O[k], X[m-k] = E*[k] - (W^k O[k])*.
+    float z0 = data[0];
+    data[0] = z0 + data[1];
+    data[1] = z0 - data[1];
+
+    for (uint16_t k = 1; k <= m / 2; k++) {
+        float* a = &data[2 * k];
+        float* b = &data[2 * (m - k)];
+
+        float er = (a[0] + b[0]) / 2;
+        float ei = (a[1] - b[1]) / 2;
+        float or = (a[1] + b[1]) / 2;
+        float oi = (b[0] - a[0]) / 2;
+
+        float wr = twiddle[2 * k];
+        float wi = twiddle[2 * k + 1];
+        float tr = or * wr - oi * wi;
+        float ti = or * wi + oi * wr;
+
+        a[0] = er + tr;
+        a[1] = ei + ti;
+        b[0] = er - tr;
+        b[1] = ti - ei;
+    }
+}
+
+void fft_power(const fft_plan_t* plan, const float* data, float* power) {
+    uint16_t m = plan->size / 2;
+
+    power[0] = data[0] * data[0];
+    power[m] = data[1] * data[1];
+
+    for (uint16_t k = 1; k < m; k++) {
+        power[k] = data[2 * k] * data[2 * k] + data[2 * k + 1] * data[2 * k + 1];
+    }
+}
@@ -0,0 +1,182 @@
+#include "util/filter.h"
+#include <math.h>
+#include <string.h>
+
+#define Q28_SHIFT 28
+
+typedef int32_t (*filter_update_func_t)(filter_t* filter, uint16_t sample);
+
+static int32_t filter_q16_round(int64_t value) {
+    return (int32_t)((value + (Q16_ONE / 2)) >> Q16_SHIFT);
+}
+
+static uint16_t filter_length(uint16_t window) {
+    return window > FILTER_MAX_WINDOW ? FILTER_MAX_WINDOW : window;
+}
+
+// Moving average
+
+static int32_t filter_average_update(filter_t* filter, uint16_t sample) {
+    struct filter_average* s = &filter->state.average;
+
+    if (s->count == s->length) {
+        s->sum -= s->samples[s->index];
+    } else {
+        s->count++;
+    }
+
+    s->samples[s->index] = sample;
+    s->sum += sample;
+    if (++s->index == s->length) s->index = 0;
+
+    // Until the window fills, average what there is rather than padding with zeros:
+    return (s->sum + s->count / 2) / s->count;
+}
+
+// EMA
+
+static int32_t filter_ema_update(filter_t* filter, uint16_t sample) {
+    struct filter_ema* s = &filter->state.ema;
+    int64_t x = (int64_t)sample << Q16_SHIFT;
+
+    if (!s->primed) {
+        s->y = x;
+        s->primed = true;
+    } else {
+        s->y += ((x - s->y) * s->alpha) >> Q16_SHIFT;
+    }
+
+    return filter_q16_round(s->y);
+}
+
+// Median
+
+static int32_t filter_median_update(filter_t* filter, uint16_t sample) {
+    struct filter_median* s = &filter->state.median;
+    uint16_t n = s->count;
+
+    // Drop the oldest sample from the sorted copy once the window is full:
+    if (n == s->length) {
+        uint16_t oldest = s->samples[s->index];
+        uint16_t i = 0;
+        while (s->sorted[i] != oldest) i++;
+        memmove(&s->sorted[i], &s->sorted[i + 1], (n - i - 1) * sizeof(uint16_t));
+        n--;
+    }
+
+    uint16_t i = n;
+    while (i > 0 && s->sorted[i - 1] > sample) {
+        s->sorted[i] = s->sorted[i - 1];
+        i--;
+    }
+
+    s->sorted[i] = sample;
+    s->count = n + 1;
+    s->samples[s->index] = sample;
+    if (++s->index == s->length) s->index = 0;
+
+    return s->sorted[s->count / 2];
+}
+
+// Lowpass
+
+static int32_t filter_lowpass_update(filter_t* filter, uint16_t sample) {
+    struct filter_lowpass* s = &filter->state.lowpass;
+    int32_t x = sample;
+
+    if (!s->primed) {
+        s->x1 = s->x2 = x;
+        s->y1 = s->y2 = (int64_t)x << Q16_SHIFT;
+        s->primed = true;
+    }
+
+    // Feed-forward terms are Q28 * int, feedback terms Q28 * Q16; both come out in Q16.
+    int64_t ff = (int64_t)s->b0 * x + (int64_t)s->b1 * s->x1 + (int64_t)s->b2 * s->x2;
+    int64_t fb = (int64_t)s->a1 * s->y1 + (int64_t)s->a2 * s->y2;
+    int64_t y = (ff >> (Q28_SHIFT - Q16_SHIFT)) - (fb >> Q28_SHIFT);
+
+    s->x2 = s->x1;
+    s->x1 = x;
+    s->y2 = s->y1;
+    s->y1 = y;
+
+    return filter_q16_round(y);
+}
+
+static void filter_lowpass_design(filter_t* filter) {
+    struct filter_lowpass* s = &filter->state.lowpass;
+
+    // RBJ cookbook Butterworth lowpass, with the moving average's -3dB point for this window:
+    double fc = 0.443 / filter->window;
+    if (fc > 0.45) fc = 0.45;
+
+    double w0 = 2.0 * M_PI * fc;
+    double alpha = sin(w0) / (2.0 * M_SQRT1_2);
+    double a0 = 1.0 + alpha;
+    double q28 = (double)(1 << Q28_SHIFT) / a0;
+
+    s->b0 = lround((1.0 - cos(w0)) / 2.0 * q28);
+    s->b1 = lround((1.0 - cos(w0)) * q28);
+    s->b2 = s->b0;
+    s->a1 = lround(-2.0 * cos(w0) * q28);
+    s->a2 = lround((1.0 - alpha) * q28);
+}
+
+// DC block
+
+static int32_t filter_dc_block_update(filter_t* filter, uint16_t sample) {
+    struct filter_dc_block* s = &filter->state.dc_block;
+
+    if (!s->primed) {
+        s->x1 = sample;
+        s->primed = true;
+    }
+
+    s->y = ((int64_t)(sample - s->x1) << Q16_SHIFT) + ((s->y * s->pole) >> Q16_SHIFT);
+    s->x1 = sample;
+
+    return filter_q16_round(s->y);
+}
+
+static const struct {
+    const char* name;
+    filter_update_func_t update;
+} filters[] = {
+    [FILTER_MOVING_AVERAGE] = { "average", &filter_average_update },
+    [FILTER_EMA] = { "ema", &filter_ema_update },
+    [FILTER_MEDIAN] = { "median", &filter_median_update },
+    [FILTER_LOWPASS] = { "lowpass", &filter_lowpass_update },
+    [FILTER_DC_BLOCK] = { "dcBlock", &filter_dc_block_update },
+};
+
+void filter_init(filter_t* filter, filter_type_t type, uint16_t window) {
+    memset(filter, 0, sizeof(filter_t));
+    filter->type = (unsigned)type < _FILTER_TYPE_MAX ? type : FILTER_MOVING_AVERAGE;
+    filter->window = window > 0 ? window : 1;
+    filter_reset(filter);
+}
+
+void filter_reset(filter_t* filter) {
+    uint16_t window = filter->window;
+
+    memset(&filter->state, 0, sizeof(filter->state));
+    filter->value = 0;
+
+    switch (filter->type) {
+    case FILTER_MOVING_AVERAGE: filter->state.average.length = filter_length(window); break;
+    case FILTER_EMA: filter->state.ema.alpha = q16_ratio(2, window + 1); break;
+    case FILTER_MEDIAN: filter->state.median.length = filter_length(window); break;
+    case FILTER_LOWPASS: filter_lowpass_design(filter); break;
+    case FILTER_DC_BLOCK: filter->state.dc_block.pole = Q16_ONE - q16_ratio(1, window); break;
+    default: break;
+    }
+}
+
+int32_t filter_update(filter_t* filter, uint16_t sample) {
+    filter->value = filters[filter->type].update(filter, sample);
+    return filter->value;
+}
+
+const char* filter_type_str(filter_type_t type) {
+    return (unsigned)type < _FILTER_TYPE_MAX ? filters[type].name : "unknown";
+}
@@ -0,0 +1,48 @@
+#include "util/histogram.h"
+#include <string.h>
+
+void histogram_init(histogram_t* hist, uint32_t bucket_width) {
+    hist->bucket_width = bucket_width > 0 ? bucket_width : 1;
+    histogram_reset(hist);
+}
+
+void histogram_reset(histogram_t* hist) {
+    memset(hist->buckets, 0, sizeof(hist->buckets));
+    hist->count = 0;
+    hist->min = UINT32_MAX;
+    hist->max = 0;
+    hist->sum = 0;
+}
+
+void histogram_add(histogram_t* hist, uint32_t value) {
+    uint32_t bucket = value / hist->bucket_width;
+    if (bucket >= HISTOGRAM_BUCKETS) bucket = HISTOGRAM_BUCKETS - 1;
+
+    hist->buckets[bucket]++;
+    hist->count++;
+    hist->sum += value;
+    if (value < hist->min) hist->min = value;
+    if (value > hist->max) hist->max = value;
+}
+
+uint32_t histogram_avg(const histogram_t* hist) {
+    return hist->count > 0 ? (uint32_t)(hist->sum / hist->count) : 0;
+}
+
+uint32_t histogram_percentile(const histogram_t* hist, uint8_t percent) {
+    if (hist->count == 0) return 0;
+
+    uint64_t target = ((uint64_t)hist->count * percent + 99) / 100;
+    uint64_t seen = 0;
+
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += hist->buckets[i];
+
+        if (seen >= target && seen > 0) {
+            uint32_t edge = (i + 1) * hist->bucket_width;
+            return edge < hist->max ? edge : hist->max;
+        }
+    }
+
+    return hist->max;
+}
@@ -0,0 +1,103 @@
+#include "util/quantile.h"
+#include <string.h>
+
+void quantile_init(quantile_t* q, float p) {
+    memset(q, 0, sizeof(quantile_t));
+    q->p = p;
+}
+
+static float quantile_parabolic(const quantile_t* q, int i, int d) {
+    const float* h = q->height;
+    const int32_t* n = q->position;
+
+    return h[i] + (float)d / (n[i + 1] - n[i - 1]) *
+                      ((n[i] - n[i - 1] + d) * (h[i + 1] - h[i]) / (n[i + 1] - n[i]) +
+                       (n[i + 1] - n[i] - d) * (h[i] - h[i - 1]) / (n[i] - n[i - 1]));
+}
+
+static float quantile_linear(const quantile_t* q, int i, int d) {
+    const float* h = q->height;
+    const int32_t* n = q->position;
+
+    return h[i] + d * (h[i + d] - h[i]) / (n[i + d] - n[i]);
+}
+
+void quantile_add(quantile_t* q, float value) {
+    float* h = q->height;
+    int32_t* n = q->position;
+
+    // Keep the first samples sorted, they are the initial markers:
+    if (q->count < QUANTILE_MARKERS) {
+        int i = q->count++;
+        while (i > 0 && h[i - 1] > value) {
+            h[i] = h[i - 1];
+            i--;
+        }
+        h[i] = value;
+
+        if (q->count == QUANTILE_MARKERS) {
+            float p = q->p;
+            float desired[QUANTILE_MARKERS] = { 0, 2 * p, 4 * p, 2 + 2 * p, 4 };
+
+            for (int m = 0; m < QUANTILE_MARKERS; m++) {
+                n[m] = m;
+                q->desired[m] = desired[m];
+            }
+        }
+
+        return;
+    }
+
+    // Find the cell the sample falls in, stretching the ends to cover it:
+    int k;
+    if (value < h[0]) {
+        h[0] = value;
+        k = 0;
+    } else if (value >= h[4]) {
+        h[4] = value;
+        k = 3;
+    } else {
+        k = 0;
+        while (value >= h[k + 1]) k++;
+    }
+
+    for (int m = k + 1; m < QUANTILE_MARKERS; m++) n[m]++;
+
+    float p = q->p;
+    float increment[QUANTILE_MARKERS] = { 0, p / 2, p, (1 + p) / 2, 1 };
+    for (int m = 0; m < QUANTILE_MARKERS; m++) q->desired[m] += increment[m];
+
+    // Nudge the middle markers one rank toward where they should be:
+    for (int i = 1; i < QUANTILE_MARKERS - 1; i++) {
+        float d = q->desired[i] - n[i];
+
+        if ((d >= 1 && n[i + 1] - n[i] > 1) || (d <= -1 && n[i - 1] - n[i] < -1)) {
+            int step = d > 0 ? 1 : -1;
+            float height = quantile_parabolic(q, i, step);
+
+            if (h[i - 1] < height && height < h[i + 1]) {
+                h[i] = height;
+            } else {
+                h[i] = quantile_linear(q, i, step);
+            }
+
+            n[i] += step;
+        }
+    }
+
+    q->count++;
+}
+
+float quantile_get(const quantile_t* q) {
+    if (q->count == 0) {
+        return 0;
+    }
+
+    if (q->count < QUANTILE_MARKERS) {
+        // Exact, from the sorted samples so far:
+        int i = (int)(q->p * (q->count - 1) + 0.5f);
+        return q->height[i];
+    }
+
+    return q->height[2];
+}
@@ -0,0 +1,71 @@
+#include "util/ring_buffer.h"
+#include <string.h>
+
+int ring_buffer_init(ring_buffer_t* ring, void* storage, size_t item_size, size_t capacity) {
+    if (ring == NULL || storage == NULL || capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        return -1;
+    }
+
+    ring->data = (uint8_t*)storage;
+    ring->item_size = item_size;
+    ring->mask = capacity - 1;
+    atomic_init(&ring->head, 0);
+    return 0;
+}
+
+void ring_buffer_push(ring_buffer_t* ring, const void* item) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    memcpy(ring->data + (head & ring->mask) * ring->item_size, item, ring->item_size);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+void ring_buffer_reader_init(ring_buffer_t* ring, ring_buffer_reader_t* reader) {
+    reader->seq = atomic_load_explicit(&ring->head, memory_order_acquire);
+    reader->dropped = 0;
+}
+
+// Copies record `seq` and verifies the writer didn't lap it during the copy. The writer only
+// touches slot `seq` again once head has advanced to seq + capacity.
+static bool ring_buffer_copy(ring_buffer_t* ring, uint32_t seq, void* item) {
+    memcpy(item, ring->data + (seq & ring->mask) * ring->item_size, ring->item_size);
+    atomic_thread_fence(memory_order_acquire);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    return (uint32_t)(head - seq) <= ring->mask;
+}
+
+bool ring_buffer_read(ring_buffer_t* ring, ring_buffer_reader_t* reader, void* item) {
+    for (;;) {
+        uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        uint32_t behind = head - reader->seq;
+
+        if (behind == 0) {
+            return false;
+        }
+
+        // Leave one slot of slack for the record the writer may be filling right now.
+        if (behind > ring->mask) {
+            reader->dropped += behind - ring->mask;
+            reader->seq = head - ring->mask;
+            continue;
+        }
+
+        if (ring_buffer_copy(ring, reader->seq, item)) {
+            reader->seq++;
+            return true;
+        }
+    }
+}
+
+bool ring_buffer_latest(ring_buffer_t* ring, void* item) {
+    for (;;) {
+        uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+        if (head == 0) {
+            return false;
+        }
+
+        if (ring_buffer_copy(ring, head - 1, item)) {
+            return true;
+        }
+    }
+}
@@ -0,0 +1,43 @@
+#include "util/sliding_minmax.h"
+#include <string.h>
+
+#define SLIDING_MINMAX_MASK (SLIDING_MINMAX_CAPACITY - 1)
+
+void sliding_minmax_init(sliding_minmax_t* s, sliding_minmax_kind_t kind, uint16_t window) {
+    memset(s, 0, sizeof(sliding_minmax_t));
+    s->kind = kind;
+    s->window = window < 1 ? 1 : window;
+
+    if (s->window > SLIDING_MINMAX_CAPACITY) {
+        s->window = SLIDING_MINMAX_CAPACITY;
+    }
+}
+
+uint16_t sliding_minmax_push(sliding_minmax_t* s, uint16_t value) {
+    s->tick++;
+
+    // Expire from the front first, so a full window frees the head's slot before the new sample
+    // takes it. Tick differences are taken in 16 bits to survive a wrap.
+    while (s->head != s->tail &&
+           (uint16_t)(s->tick - s->ticks[s->head & SLIDING_MINMAX_MASK]) >= s->window) {
+        s->head++;
+    }
+
+    // Queued samples the new one beats can never be the answer again. Ties go too, so the newest
+    // of equal samples is kept and lasts longest.
+    if (s->kind == SLIDING_MIN) {
+        while (s->tail != s->head && s->values[(s->tail - 1) & SLIDING_MINMAX_MASK] >= value) {
+            s->tail--;
+        }
+    } else {
+        while (s->tail != s->head && s->values[(s->tail - 1) & SLIDING_MINMAX_MASK] <= value) {
+            s->tail--;
+        }
+    }
+
+    s->values[s->tail & SLIDING_MINMAX_MASK] = value;
+    s->ticks[s->tail & SLIDING_MINMAX_MASK] = s->tick;
+    s->tail++;
+
+    return s->values[s->head & SLIDING_MINMAX_MASK];
+}
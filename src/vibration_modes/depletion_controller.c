@@ -5,42 +5,45 @@
 
 static const char* TAG = "depletion_controller";
 
-static struct {
-    float motor_speed;
+static CONTROL_LOCAL struct {
+    q16_t motor_speed;
     uint16_t arousal;
-    float base_speed;
+    q16_t base_speed;
 } state;
 
-static float start(void) {
-    state.base_speed = Config.motor_start_speed;
+static q16_t start(void) {
+    state.base_speed = q16_from_int(Config.motor_start_speed);
     return state.base_speed;
 }
 
-static float increment(void) {
-    if (state.base_speed < Config.motor_max_speed) {
+static q16_t increment(void) {
+    q16_t start_speed = q16_from_int(Config.motor_start_speed);
+    q16_t max_speed = q16_from_int(Config.motor_max_speed);
+
+    if (state.base_speed < max_speed) {
         state.base_speed += calculate_increment(
             Config.motor_start_speed, Config.motor_max_speed, Config.motor_ramp_time_s
         );
     }
 
-    float alter_perc = ((float)state.arousal / Config.sensitivity_threshold);
-    float final_speed = state.base_speed * (1 - alter_perc);
+    q16_t alter_perc = q16_ratio(state.arousal, Config.sensitivity_threshold);
+    q16_t final_speed = q16_mul(state.base_speed, Q16_ONE - alter_perc);
 
-    if (final_speed < (float)Config.motor_start_speed) {
-        return Config.motor_start_speed;
-    } else if (final_speed > (float)Config.motor_max_speed) {
-        return Config.motor_max_speed;
+    if (final_speed < start_speed) {
+        return start_speed;
+    } else if (final_speed > max_speed) {
+        return max_speed;
     } else {
         return final_speed;
     }
 }
 
-static void tick(float motor_speed, uint16_t arousal) {
+static void tick(q16_t motor_speed, uint16_t arousal) {
     state.motor_speed = motor_speed;
     state.arousal = arousal;
 }
 
-static float stop(void) {
+static q16_t stop(void) {
     return 0;
 }
 
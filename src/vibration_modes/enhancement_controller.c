@@ -5,33 +5,33 @@
 
 static const char* TAG = "enhancement_controller";
 
-static struct {
-    float motor_speed;
+static CONTROL_LOCAL struct {
+    q16_t motor_speed;
     uint16_t arousal;
     oc_bool_t stopped;
 } state;
 
-static float start(void) { return Config.motor_start_speed; }
+static q16_t start(void) { return q16_from_int(Config.motor_start_speed); }
 
-static float increment(void) {
+static q16_t increment(void) {
     if (state.stopped) {
         return state.motor_speed +
                calculate_increment(Config.motor_max_speed, 0, Config.edge_delay);
     }
 
-    float speed_diff = Config.motor_max_speed - Config.motor_start_speed;
-    float alter_perc = ((float)state.arousal / Config.sensitivity_threshold);
-    return Config.motor_start_speed + (alter_perc * speed_diff);
+    int speed_diff = Config.motor_max_speed - Config.motor_start_speed;
+    q16_t alter_perc = q16_ratio(state.arousal, Config.sensitivity_threshold);
+    return q16_sat(q16_from_int(Config.motor_start_speed) + (int64_t)alter_perc * speed_diff);
 }
 
-static void tick(float motor_speed, uint16_t arousal) {
+static void tick(q16_t motor_speed, uint16_t arousal) {
     state.motor_speed = motor_speed;
     state.arousal = arousal;
 }
 
-static float stop(void) {
+static q16_t stop(void) {
     state.stopped = ocTRUE;
-    return Config.motor_max_speed;
+    return q16_from_int(Config.motor_max_speed);
 }
 
 const vibration_mode_controller_t EnhancementController = {
@@ -5,8 +5,8 @@
 
 static const char* TAG = "pattern_controller";
 
-static struct {
-    float motor_speed;
+static CONTROL_LOCAL struct {
+    q16_t motor_speed;
     uint16_t arousal;
     size_t pattern_step;
     uint32_t step_ticks;
@@ -16,22 +16,22 @@ static struct {
 // This is unfinished.
 // We'll use it some time I think.
 
-static float increment(void);
+static q16_t increment(void);
 
-static float start(void) {
+static q16_t start(void) {
     state.pattern_step = 0;
     state.step_ticks = 0;
     return increment();
 }
 
-static float increment(void) { return 0.0f; }
+static q16_t increment(void) { return 0; }
 
-static void tick(float motor_speed, uint16_t arousal) {
+static void tick(q16_t motor_speed, uint16_t arousal) {
     state.motor_speed = motor_speed;
     state.arousal = arousal;
 }
 
-static float stop(void) { return 0; }
+static q16_t stop(void) { return 0; }
 
 const vibration_mode_controller_t PatternController = {
     .start = start,
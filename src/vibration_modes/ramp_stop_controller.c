@@ -4,36 +4,36 @@
 
 static const char* TAG = "ramp_stop_controller";
 
-static struct {
-    float motor_speed;
+static CONTROL_LOCAL struct {
+    q16_t motor_speed;
     uint16_t arousal;
 } state;
 
-static float start(void) {
-    state.motor_speed = Config.motor_start_speed;
-    return Config.motor_start_speed;
+static q16_t start(void) {
+    state.motor_speed = q16_from_int(Config.motor_start_speed);
+    return state.motor_speed;
 }
 
-static float increment(void) {
-    float motor_increment = calculate_increment(
+static q16_t increment(void) {
+    q16_t motor_increment = calculate_increment(
         Config.motor_start_speed, Config.motor_max_speed, Config.motor_ramp_time_s
     );
 
-    if (state.motor_speed < (Config.motor_max_speed - motor_increment)) {
+    if (state.motor_speed < (q16_from_int(Config.motor_max_speed) - motor_increment)) {
         return state.motor_speed + motor_increment;
     } else {
-        return Config.motor_max_speed;
+        return q16_from_int(Config.motor_max_speed);
     }
 }
 
-static void tick(float motor_speed, uint16_t arousal) {
+static void tick(q16_t motor_speed, uint16_t arousal) {
     state.motor_speed = motor_speed;
     state.arousal = arousal;
 }
 
-static float stop(void) {
-    state.motor_speed = 0.0f;
-    return 0.0f;
+static q16_t stop(void) {
+    state.motor_speed = 0;
+    return 0;
 }
 
 const vibration_mode_controller_t RampStopController = {
@@ -0,0 +1,322 @@
+#include "config.h"
+#include "host.h"
+#include "orgasm_control.h"
+#include "pool.h"
+#include "replay.h"
+#include "session.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TUNE_MAX_OVERRIDES 32
+
+typedef struct tune_param {
+    const char* key;
+    int min;
+    int max;
+    int step;
+} tune_param_t;
+
+// Tuned keys and their default search ranges. -p replaces a range.
+static tune_param_t tune_params[] = {
+    { "sensitivity_threshold", 300, 1000, 50 },
+    { "clench_pressure_sensitivity", 100, 400, 50 },
+    { "clench_threshold_2_orgasm", 20, 60, 10 },
+    { "edge_delay", 1000, 15000, 2000 },
+    { "pressure_smoothing", 1, 10, 1 },
+};
+
+#define TUNE_PARAM_COUNT (sizeof(tune_params) / sizeof(tune_params[0]))
+
+typedef struct candidate {
+    int values[TUNE_PARAM_COUNT];
+    double score;
+    replay_result_t result;
+} candidate_t;
+
+static struct {
+    session_t* sessions;
+    size_t session_count;
+    const char* overrides[TUNE_MAX_OVERRIDES];
+    size_t override_count;
+    replay_options_t replay;
+    double target_interval_ms;
+    candidate_t* candidates;
+    size_t candidate_count;
+} tune;
+
+static size_t param_steps(const tune_param_t* p) {
+    return p->step > 0 ? (p->max - p->min) / p->step + 1 : 1;
+}
+
+static int parse_range(const char* arg) {
+    const char* eq = strchr(arg, '=');
+    if (eq == NULL) return -1;
+
+    for (size_t i = 0; i < TUNE_PARAM_COUNT; i++) {
+        tune_param_t* p = &tune_params[i];
+        if (strncmp(arg, p->key, eq - arg) || p->key[eq - arg] != '\0') continue;
+
+        int n = sscanf(eq + 1, "%d:%d:%d", &p->min, &p->max, &p->step);
+        if (n == 1) {
+            p->max = p->min;
+            p->step = 0;
+        } else if (n != 3 || p->step <= 0 || p->max < p->min) {
+            return -1;
+        }
+
+        return 0;
+    }
+
+    return -1;
+}
+
+/**
+ * Lower is better. A session set scores well when edges land near the target interval, arrive at a
+ * steady pace, and arousal doesn't overrun the threshold for long.
+ */
+static double score_result(const replay_result_t* r) {
+    if (r->edge_intervals == 0 || r->ticks == 0) {
+        return 100.0 + (double)r->ticks_over_threshold / (r->ticks + 1);
+    }
+
+    double mean = r->edge_interval_sum_ms / r->edge_intervals;
+    double variance = r->edge_interval_sq_sum_ms / r->edge_intervals - mean * mean;
+    double cv = variance > 0 ? sqrt(variance) / mean : 0;
+    double overrun = (double)r->ticks_over_threshold / r->ticks;
+
+    return fabs(log(mean / tune.target_interval_ms)) + 0.25 * cv + 2.0 * overrun;
+}
+
+static void run_candidate(size_t job, void* arg) {
+    candidate_t* c = &tune.candidates[job];
+    char assignment[96];
+
+    host_config_reset();
+
+    for (size_t i = 0; i < tune.override_count; i++) {
+        host_config_set(tune.overrides[i]);
+    }
+
+    for (size_t i = 0; i < TUNE_PARAM_COUNT; i++) {
+        snprintf(assignment, sizeof(assignment), "%s=%d", tune_params[i].key, c->values[i]);
+        host_config_set(assignment);
+    }
+
+    memset(&c->result, 0, sizeof(replay_result_t));
+
+    for (size_t i = 0; i < tune.session_count; i++) {
+        replay_result_t r;
+        replay_session(&tune.sessions[i], &tune.replay, &r, NULL);
+
+        c->result.ticks += r.ticks;
+        c->result.denials += r.denials;
+        c->result.ticks_over_threshold += r.ticks_over_threshold;
+        c->result.edge_intervals += r.edge_intervals;
+        c->result.edge_interval_sum_ms += r.edge_interval_sum_ms;
+        c->result.edge_interval_sq_sum_ms += r.edge_interval_sq_sum_ms;
+    }
+
+    c->score = score_result(&c->result);
+}
+
+static int compare_candidates(const void* a, const void* b) {
+    double d = ((const candidate_t*)a)->score - ((const candidate_t*)b)->score;
+    return (d > 0) - (d < 0);
+}
+
+static void build_grid(void) {
+    size_t total = 1;
+    for (size_t i = 0; i < TUNE_PARAM_COUNT; i++) total *= param_steps(&tune_params[i]);
+
+    tune.candidate_count = total;
+    tune.candidates = calloc(total, sizeof(candidate_t));
+
+    for (size_t n = 0; n < total; n++) {
+        size_t rest = n;
+        for (size_t i = 0; i < TUNE_PARAM_COUNT; i++) {
+            size_t steps = param_steps(&tune_params[i]);
+            tune.candidates[n].values[i] = tune_params[i].min + (rest % steps) * tune_params[i].step;
+            rest /= steps;
+        }
+    }
+}
+
+static void build_random(size_t count, unsigned int seed) {
+    tune.candidate_count = count;
+    tune.candidates = calloc(count, sizeof(candidate_t));
+
+    for (size_t n = 0; n < count; n++) {
+        for (size_t i = 0; i < TUNE_PARAM_COUNT; i++) {
+            size_t steps = param_steps(&tune_params[i]);
+            tune.candidates[n].values[i] =
+                tune_params[i].min + (rand_r(&seed) % steps) * tune_params[i].step;
+        }
+    }
+}
+
+static void write_patch(const char* path, const candidate_t* c) {
+    FILE* f = fopen(path, "w");
+    if (f == NULL) {
+        fprintf(stderr, "Could not write patch: %s\n", path);
+        return;
+    }
+
+    fprintf(f, "{\n");
+    for (size_t i = 0; i < TUNE_PARAM_COUNT; i++) {
+        fprintf(
+            f,
+            "    \"%s\": %d%s\n",
+            tune_params[i].key,
+            c->values[i],
+            i + 1 < TUNE_PARAM_COUNT ? "," : ""
+        );
+    }
+    fprintf(f, "}\n");
+    fclose(f);
+}
+
+static void usage(const char* argv0) {
+    fprintf(
+        stderr,
+        "Usage: %s [options] log.csv [log.csv ...]\n"
+        "\n"
+        "Searches detector parameters over a corpus of recorded sessions.\n"
+        "\n"
+        "  -p key=min:max:step  Search range for a tuned key, or key=value to pin it.\n"
+        "  -s key=value         Base config override applied before each candidate.\n"
+        "  -g                   Exhaustive grid search (default is random search).\n"
+        "  -n count             Random search candidates (default 500).\n"
+        "  -t seconds           Target time between edges (default 60).\n"
+        "  -k count             Number of ranked results to print (default 10).\n"
+        "  -j file              Write the best parameters as a config.json patch.\n"
+        "  -m mode              Output mode to replay in (default AUTOMAITC_CONTROL).\n"
+        "  -w threads           Worker threads (default: one per CPU).\n"
+        "  -r seed              Random seed for sampling and edge delays (default 1).\n",
+        argv0
+    );
+}
+
+int main(int argc, char** argv) {
+    const char* patch_path = NULL;
+    size_t random_count = 500;
+    size_t top = 10;
+    int grid = 0;
+    int threads = 0;
+    int opt;
+
+    replay_options_default(&tune.replay);
+    tune.target_interval_ms = 60000;
+
+    while ((opt = getopt(argc, argv, "p:s:gn:t:k:j:m:w:r:h")) != -1) {
+        switch (opt) {
+        case 'p':
+            if (parse_range(optarg) != 0) {
+                fprintf(stderr, "Bad parameter range: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 's':
+            if (tune.override_count == TUNE_MAX_OVERRIDES) return 1;
+            tune.overrides[tune.override_count++] = optarg;
+            break;
+        case 'g': grid = 1; break;
+        case 'n': random_count = strtoul(optarg, NULL, 10); break;
+        case 't': tune.target_interval_ms = atof(optarg) * 1000.0; break;
+        case 'k': top = strtoul(optarg, NULL, 10); break;
+        case 'j': patch_path = optarg; break;
+        case 'm':
+            tune.replay.mode = orgasm_control_str_to_output_mode(optarg);
+            if ((int)tune.replay.mode < 0) {
+                fprintf(stderr, "Unknown output mode: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'w': threads = atoi(optarg); break;
+        case 'r': tune.replay.seed = strtoul(optarg, NULL, 10); break;
+        default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (optind >= argc || tune.target_interval_ms <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    // Validate overrides once up front, on the main thread's Config:
+    host_config_reset();
+    for (size_t i = 0; i < tune.override_count; i++) {
+        if (!host_config_set(tune.overrides[i])) {
+            fprintf(stderr, "Unknown config assignment: %s\n", tune.overrides[i]);
+            return 1;
+        }
+    }
+
+    tune.session_count = argc - optind;
+    tune.sessions = calloc(tune.session_count, sizeof(session_t));
+
+    for (size_t i = 0; i < tune.session_count; i++) {
+        if (session_load(&tune.sessions[i], argv[optind + i]) != 0) {
+            fprintf(stderr, "Could not load session: %s\n", argv[optind + i]);
+            return 1;
+        }
+    }
+
+    if (grid) {
+        build_grid();
+    } else {
+        build_random(random_count, tune.replay.seed);
+    }
+
+    if (threads <= 0) threads = pool_default_threads();
+
+    fprintf(
+        stderr,
+        "Evaluating %zu candidates over %zu sessions on %d threads...\n",
+        tune.candidate_count,
+        tune.session_count,
+        threads
+    );
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pool_run(tune.candidate_count, threads, run_candidate, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    qsort(tune.candidates, tune.candidate_count, sizeof(candidate_t), compare_candidates);
+
+    printf("rank,score,denials,mean_edge_interval_s");
+    for (size_t i = 0; i < TUNE_PARAM_COUNT; i++) printf(",%s", tune_params[i].key);
+    printf("\n");
+
+    for (size_t n = 0; n < top && n < tune.candidate_count; n++) {
+        const candidate_t* c = &tune.candidates[n];
+        double mean = c->result.edge_intervals > 0
+                          ? c->result.edge_interval_sum_ms / c->result.edge_intervals / 1000.0
+                          : 0;
+
+        printf("%zu,%.4f,%d,%.1f", n + 1, c->score, c->result.denials, mean);
+        for (size_t i = 0; i < TUNE_PARAM_COUNT; i++) printf(",%d", c->values[i]);
+        printf("\n");
+    }
+
+    fprintf(
+        stderr,
+        "Done in %.2f s (%.0f ticks/ms).\n",
+        seconds,
+        seconds > 0 ? tune.candidates[0].result.ticks * tune.candidate_count / seconds / 1000.0 : 0
+    );
+
+    if (patch_path != NULL && tune.candidate_count > 0) {
+        write_patch(patch_path, &tune.candidates[0]);
+    }
+
+    for (size_t i = 0; i < tune.session_count; i++) session_free(&tune.sessions[i]);
+    free(tune.sessions);
+    free(tune.candidates);
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include "auto_threshold.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TICK_MS 20
+#define EDGE_DELAY_MS 10000
+#define DENIALS 60
+
+// How far the last intervals may average from the target, as a fraction of it.
+#define MAX_ERROR 0.15
+
+// A stand-in for the user: arousal climbs to the threshold at a rate that varies from edge to edge
+// by up to ±spread, then the motor rests for the edge delay.
+static unsigned long
+time_to_edge_ms(int threshold, double rate_per_s, double spread, unsigned* seed) {
+    double jitter = 1.0 + spread * (2.0 * rand_r(seed) / RAND_MAX - 1.0);
+    return EDGE_DELAY_MS + 1000.0 * threshold / (rate_per_s * jitter);
+}
+
+static int run(const char* name, int start, double rate_per_s, double spread, int target_s) {
+    auto_threshold_t control;
+    unsigned seed = 11;
+    unsigned long now = 0, last_denial = 0, next_edge;
+    int threshold = start, largest_step = 0, settled_at = -1, denials = 0, failures = 0;
+    double tail = 0;
+
+    auto_threshold_init(&control, start, target_s * 1000UL, now);
+    next_edge = now + time_to_edge_ms(threshold, rate_per_s, spread, &seed);
+
+    while (denials < DENIALS) {
+        now += TICK_MS;
+        bool denied = now >= next_edge;
+        int updated = auto_threshold_update(&control, denied, now);
+
+        // Steps stay within bounds, counting rounding:
+        if (abs(updated - threshold) > threshold * AUTO_THRESHOLD_MAX_STEP + 1) failures++;
+        if (abs(updated - threshold) > largest_step) largest_step = abs(updated - threshold);
+        threshold = updated;
+
+        if (denied) {
+            unsigned long interval = now - last_denial;
+            last_denial = now;
+            denials++;
+
+            // Average interval over the last quarter of the run:
+            if (denials > DENIALS * 3 / 4) tail += interval;
+            if (settled_at < 0 && auto_threshold_settled(&control)) settled_at = denials;
+
+            next_edge = now + time_to_edge_ms(threshold, rate_per_s, spread, &seed);
+        }
+    }
+
+    double avg_s = tail / (DENIALS / 4) / 1000.0;
+    double error = fabs(avg_s - target_s) / target_s;
+    if (error > MAX_ERROR) failures++;
+
+    printf(
+        "%s,%d,%d,%.1f,%.1f,%d,%d,%s\n",
+        name,
+        start,
+        threshold,
+        avg_s,
+        error * 100,
+        largest_step,
+        settled_at,
+        failures > 0 ? "FAIL" : "ok"
+    );
+
+    return failures;
+}
+
+int main(int argc, char** argv) {
+    int failures = 0;
+
+    printf("case,start,final,interval_s,error_pct,largest_step,settled_at_denial,result\n");
+
+    // 600 arousal at 40/s plus the edge delay is 25s between denials:
+    failures += run("on target", 600, 40, 0.2, 25);
+    failures += run("too low", 400, 40, 0.2, 30);
+    failures += run("too high", 900, 40, 0.2, 20);
+    failures += run("noisy", 600, 40, 0.5, 30);
+
+    return failures > 0 ? 1 : 0;
+}
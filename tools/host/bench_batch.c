@@ -0,0 +1,114 @@
+#include "detector.h"
+#include "host.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_LANES 256
+#define BENCH_TICKS 20000
+
+// bench_tick's trace, with each lane on its own noise, contraction period and height so lanes
+// drift apart.
+static uint16_t bench_pressure(size_t lane, uint32_t tick, uint32_t* seed) {
+    return host_bench_pressure(tick, 120 + lane % 60, 20 + lane % 25, seed);
+}
+
+// Spreads the lanes over a grid of the tunable params.
+static void bench_params(size_t lane, detector_params_t* params) {
+    detector_params_from_config(params);
+    params->mode = DetectPeaks;
+    params->use_average_values = false;
+    params->sensitivity_threshold = 300 + (lane % 16) * 60;
+    params->clench_pressure_sensitivity = 100 + (lane / 16 % 4) * 100;
+    params->clench_threshold_2_orgasm = 20 + (lane / 64) * 10;
+    params->clench_detector_in_edging = lane % 2;
+}
+
+int main(int argc, char** argv) {
+    static uint16_t pressure[BENCH_TICKS][BENCH_LANES];
+    static detector_t detectors[BENCH_LANES];
+    detector_batch_t batch;
+    size_t mismatches = 0;
+    size_t orgasms = 0;
+
+    host_config_reset();
+
+    for (size_t lane = 0; lane < BENCH_LANES; lane++) {
+        uint32_t seed = lane + 1;
+        for (uint32_t tick = 0; tick < BENCH_TICKS; tick++) {
+            pressure[tick][lane] = bench_pressure(lane, tick, &seed);
+        }
+    }
+
+    if (detector_batch_init(&batch, BENCH_LANES) != 0) {
+        fprintf(stderr, "Could not allocate batch.\n");
+        return 1;
+    }
+
+    for (size_t lane = 0; lane < BENCH_LANES; lane++) {
+        detector_params_t params;
+        bench_params(lane, &params);
+        detector_init(&detectors[lane], &params);
+        detector_batch_set_params(&batch, lane, &params);
+    }
+
+    // Orgasms are only permitted in the second half, so both halves of the clench logic run.
+    double start = host_now_ns();
+    for (uint32_t tick = 0; tick < BENCH_TICKS; tick++) {
+        for (size_t lane = 0; lane < BENCH_LANES; lane++) {
+            detector_update(&detectors[lane], pressure[tick][lane], tick >= BENCH_TICKS / 2);
+        }
+    }
+    double instance_ns = host_now_ns() - start;
+
+    start = host_now_ns();
+    for (uint32_t tick = 0; tick < BENCH_TICKS; tick++) {
+        detector_batch_update(&batch, pressure[tick], tick >= BENCH_TICKS / 2);
+    }
+    double batch_ns = host_now_ns() - start;
+
+    // Replay both again tick by tick to compare the full state history.
+    detector_batch_reset(&batch);
+    for (size_t lane = 0; lane < BENCH_LANES; lane++) {
+        detector_params_t params = detectors[lane].params;
+        detector_init(&detectors[lane], &params);
+    }
+
+    for (uint32_t tick = 0; tick < BENCH_TICKS; tick++) {
+        detector_batch_update(&batch, pressure[tick], tick >= BENCH_TICKS / 2);
+
+        for (size_t lane = 0; lane < BENCH_LANES; lane++) {
+            detector_t* detector = &detectors[lane];
+            detector_update(detector, pressure[tick][lane], tick >= BENCH_TICKS / 2);
+
+            if (detector->arousal != batch.arousal[lane] ||
+                detector->clench_pressure_threshold != batch.clench_pressure_threshold[lane] ||
+                detector->clench_duration != batch.clench_duration[lane] ||
+                detector->detected_orgasm != batch.detected_orgasm[lane]) {
+                mismatches++;
+            }
+        }
+    }
+
+    for (size_t lane = 0; lane < BENCH_LANES; lane++) {
+        orgasms += batch.detected_orgasm[lane];
+    }
+
+    detector_batch_free(&batch);
+
+    size_t updates = (size_t)BENCH_LANES * BENCH_TICKS;
+    printf(
+        "lanes,ticks,instance_ns_per_update,batch_ns_per_update,mismatches,"
+        "lanes_detected_orgasm\n"
+    );
+    printf(
+        "%d,%d,%.2f,%.2f,%zu,%zu\n",
+        BENCH_LANES,
+        BENCH_TICKS,
+        instance_ns / updates,
+        batch_ns / updates,
+        mismatches,
+        orgasms
+    );
+
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,76 @@
+#include "host.h"
+#include "util/decimator.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_SAMPLES (1 << 20)
+#define BENCH_ROUNDS 32
+
+// RMS of the decimated output for a full-scale-ish tone at `hz`, relative to the input amplitude.
+static double tone_gain(uint8_t ratio, double rate_hz, double hz) {
+    decimator_t dec;
+    double sum = 0;
+    size_t n = 0;
+
+    decimator_init(&dec, ratio);
+
+    for (size_t i = 0; i < (size_t)rate_hz * 4; i++) {
+        uint16_t out;
+        uint16_t in = 2048 + 1000 * sin(2 * M_PI * hz * i / rate_hz);
+
+        // Skip the filter's settling time:
+        if (decimator_push(&dec, in, &out) && i > rate_hz) {
+            sum += ((double)out - 2048) * ((double)out - 2048);
+            n++;
+        }
+    }
+
+    return n > 0 ? sqrt(sum / n) / (1000 / sqrt(2)) : 0;
+}
+
+int main(int argc, char** argv) {
+    static const uint8_t ratios[] = { 2, 10, 20, 32 };
+    uint16_t* input = malloc(sizeof(uint16_t) * BENCH_SAMPLES);
+    unsigned int seed = 1;
+
+    for (size_t i = 0; i < BENCH_SAMPLES; i++) {
+        input[i] = rand_r(&seed) % 4096;
+    }
+
+    printf("ratio,ns_per_sample,dc_out,gain_at_out_nyquist,gain_at_5hz\n");
+
+    for (size_t r = 0; r < sizeof(ratios); r++) {
+        decimator_t dec;
+        volatile uint32_t sink = 0;
+        uint16_t out = 0;
+
+        decimator_init(&dec, ratios[r]);
+
+        double start = host_now_ns();
+        for (int round = 0; round < BENCH_ROUNDS; round++) {
+            for (size_t i = 0; i < BENCH_SAMPLES; i++) {
+                if (decimator_push(&dec, input[i], &out)) sink += out;
+            }
+        }
+        double ns = (host_now_ns() - start) / ((double)BENCH_SAMPLES * BENCH_ROUNDS);
+
+        // A constant input must come back out unchanged once the filter has settled:
+        decimator_init(&dec, ratios[r]);
+        for (int i = 0; i < ratios[r] * 8; i++) decimator_push(&dec, 3000, &out);
+
+        // Assuming 50Hz out, the input runs at 50 * ratio:
+        double rate = 50.0 * ratios[r];
+        printf(
+            "%u,%.2f,%u,%.3f,%.3f\n",
+            ratios[r],
+            ns,
+            out,
+            tone_gain(ratios[r], rate, 25.0),
+            tone_gain(ratios[r], rate, 5.0)
+        );
+    }
+
+    free(input);
+    return 0;
+}
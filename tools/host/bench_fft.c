@@ -0,0 +1,117 @@
+#include "host.h"
+#include "spectrum.h"
+#include "util/fft.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_ROUNDS 20000
+
+// Largest error allowed against a double precision DFT, relative to the largest bin.
+#define MAX_ERROR 1e-5
+
+// Largest difference between fft_real() and a direct DFT, relative to the largest magnitude.
+static double dft_error(const fft_plan_t* plan, const float* input) {
+    uint16_t n = plan->size;
+    float data[FFT_MAX_SIZE];
+    double worst = 0, largest = 0;
+
+    for (uint16_t i = 0; i < n; i++) data[i] = input[i];
+    fft_real(plan, data);
+
+    for (uint16_t k = 0; k <= n / 2; k++) {
+        double re = 0, im = 0;
+        for (uint16_t i = 0; i < n; i++) {
+            re += input[i] * cos(-2 * M_PI * k * i / n);
+            im += input[i] * sin(-2 * M_PI * k * i / n);
+        }
+
+        double fr = k == 0 ? data[0] : k == n / 2 ? data[1] : data[2 * k];
+        double fi = k == 0 || k == n / 2 ? 0 : data[2 * k + 1];
+        double error = hypot(fr - re, fi - im);
+
+        if (error > worst) worst = error;
+        if (hypot(re, im) > largest) largest = hypot(re, im);
+    }
+
+    return largest > 0 ? worst / largest : worst;
+}
+
+// Feeds a contraction rhythm over drift and noise through the analyzer, as the control loop would
+// at 50Hz, and checks the rate and band level it reports.
+static int check_spectrum(float rate_hz, float amplitude) {
+    static spectrum_t spectrum;
+    spectrum_frame_t frame = { 0 };
+    unsigned int seed = 5;
+    int frames = 0, failures = 0;
+
+    spectrum_init(&spectrum);
+
+    for (int i = 0; i < 50 * 60; i++) {
+        double t = i / 50.0;
+        double p = 2000 + 300 * sin(2 * M_PI * 0.02 * t) + amplitude * sin(2 * M_PI * rate_hz * t) +
+                   (rand_r(&seed) % 41 - 20);
+
+        if (!spectrum_update(&spectrum, p, 50.0f, i * 20, &frame)) continue;
+        frames++;
+
+        float rms = frame.band_rms[SPECTRUM_BAND_CONTRACTION];
+        if (fabsf(frame.contraction_rate_hz - rate_hz) > 0.05f ||
+            fabsf(rms - amplitude / sqrtf(2)) > amplitude * 0.1f) {
+            failures++;
+        }
+    }
+
+    printf(
+        "%.2fHz x %.0f: %d frames, rate %.3fHz, contraction %.1f, drift %.1f, noise %.1f, %d bad\n",
+        rate_hz,
+        amplitude,
+        frames,
+        frame.contraction_rate_hz,
+        frame.band_rms[SPECTRUM_BAND_CONTRACTION],
+        frame.band_rms[SPECTRUM_BAND_DRIFT],
+        frame.band_rms[SPECTRUM_BAND_NOISE],
+        failures
+    );
+
+    return failures;
+}
+
+int main(int argc, char** argv) {
+    static const uint16_t sizes[] = { 4, 16, 64, 128, 256 };
+    float input[FFT_MAX_SIZE];
+    unsigned int seed = 1;
+    int failures = 0;
+
+    for (size_t i = 0; i < FFT_MAX_SIZE; i++) {
+        input[i] = rand_r(&seed) % 4096;
+    }
+
+    printf("size,ns_per_fft,ns_per_sample,max_error\n");
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        fft_plan_t plan;
+        float data[FFT_MAX_SIZE];
+        volatile float sink = 0;
+
+        fft_plan_init(&plan, sizes[s]);
+
+        double start = host_now_ns();
+        for (int round = 0; round < BENCH_ROUNDS; round++) {
+            for (uint16_t i = 0; i < plan.size; i++) data[i] = input[i];
+            fft_real(&plan, data);
+            sink += data[2];
+        }
+        double ns = (host_now_ns() - start) / BENCH_ROUNDS;
+
+        double error = dft_error(&plan, input);
+        if (error > MAX_ERROR) failures++;
+
+        printf("%u,%.1f,%.2f,%.2e\n", plan.size, ns, ns / plan.size, error);
+    }
+
+    failures += check_spectrum(0.8f, 200);
+    failures += check_spectrum(1.5f, 50);
+
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,161 @@
+#include "host.h"
+#include "util/filter.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_SAMPLES (1 << 20)
+#define BENCH_ROUNDS 8
+#define CHECK_SAMPLES 20000
+
+static int compare_u16(const void* a, const void* b) {
+    return (int)*(const uint16_t*)a - (int)*(const uint16_t*)b;
+}
+
+// Brute force average or median of the last `window` samples ending at input[i], over whatever
+// samples exist before the window fills.
+static int32_t reference(filter_type_t type, const uint16_t* input, size_t i, uint16_t window) {
+    size_t n = i + 1 < window ? i + 1 : window;
+    const uint16_t* start = &input[i + 1 - n];
+
+    if (type == FILTER_MEDIAN) {
+        uint16_t sorted[FILTER_MAX_WINDOW];
+        memcpy(sorted, start, n * sizeof(uint16_t));
+        qsort(sorted, n, sizeof(uint16_t), compare_u16);
+        return sorted[n / 2];
+    }
+
+    uint64_t sum = 0;
+    for (size_t j = 0; j < n; j++) sum += start[j];
+    return (sum + n / 2) / n;
+}
+
+// Output for a constant input, once the filter has settled.
+static int32_t dc_out(filter_type_t type, uint16_t window, uint16_t value) {
+    filter_t filter;
+    filter_init(&filter, type, window);
+    for (int i = 0; i < window * 16 + 64; i++) filter_update(&filter, value);
+    return filter_get(&filter);
+}
+
+// Samples until the output covers half of a 1000 -> 3000 step.
+static int step_lag(filter_type_t type, uint16_t window) {
+    filter_t filter;
+    filter_init(&filter, type, window);
+    for (int i = 0; i < window * 16 + 64; i++) filter_update(&filter, 1000);
+
+    for (int i = 0; i < window * 16 + 64; i++) {
+        if (filter_update(&filter, 3000) >= 2000) return i;
+    }
+
+    return -1;
+}
+
+// Largest deviation a single full-scale sample causes on a settled 2048 baseline.
+static int32_t spike_out(filter_type_t type, uint16_t window) {
+    filter_t filter;
+    int32_t baseline = dc_out(type, window, 2048);
+    int32_t worst = 0;
+
+    filter_init(&filter, type, window);
+    for (int i = 0; i < window * 16 + 64; i++) filter_update(&filter, 2048);
+
+    filter_update(&filter, 4095);
+    for (int i = 0; i < window * 16; i++) {
+        int32_t deviation = abs(filter_get(&filter) - baseline);
+        if (deviation > worst) worst = deviation;
+        filter_update(&filter, 2048);
+    }
+
+    return worst;
+}
+
+// RMS of the output around its mean over uniform noise, relative to the input's.
+static double noise_gain(filter_type_t type, uint16_t window, const uint16_t* input) {
+    filter_t filter;
+    double sum = 0, sum_sq = 0, in_sum = 0, in_sum_sq = 0;
+    size_t n = 0;
+
+    filter_init(&filter, type, window);
+
+    for (size_t i = 0; i < CHECK_SAMPLES; i++) {
+        double out = filter_update(&filter, input[i]);
+
+        // Skip the filter's settling time:
+        if (i < 1000) continue;
+
+        sum += out;
+        sum_sq += out * out;
+        in_sum += input[i];
+        in_sum_sq += (double)input[i] * input[i];
+        n++;
+    }
+
+    double out_var = sum_sq / n - (sum / n) * (sum / n);
+    double in_var = in_sum_sq / n - (in_sum / n) * (in_sum / n);
+    return sqrt(out_var / in_var);
+}
+
+int main(int argc, char** argv) {
+    static const uint16_t windows[] = { 5, 16, 64 };
+    uint16_t* input = malloc(sizeof(uint16_t) * BENCH_SAMPLES);
+    unsigned int seed = 1;
+    int failures = 0;
+
+    for (size_t i = 0; i < BENCH_SAMPLES; i++) {
+        input[i] = rand_r(&seed) % 4096;
+    }
+
+    printf("filter,window,ns_per_sample,dc_out,step_lag,spike_out,noise_gain,mismatches\n");
+
+    for (filter_type_t type = 0; type < _FILTER_TYPE_MAX; type++) {
+        for (size_t w = 0; w < sizeof(windows) / sizeof(windows[0]); w++) {
+            uint16_t window = windows[w];
+            filter_t filter;
+            volatile int32_t sink = 0;
+
+            filter_init(&filter, type, window);
+
+            double start = host_now_ns();
+            for (int round = 0; round < BENCH_ROUNDS; round++) {
+                for (size_t i = 0; i < BENCH_SAMPLES; i++) {
+                    sink += filter_update(&filter, input[i]);
+                }
+            }
+            double ns = (host_now_ns() - start) / ((double)BENCH_SAMPLES * BENCH_ROUNDS);
+
+            // The average and median must match a brute force reference exactly:
+            int mismatches = 0;
+            if (type == FILTER_MOVING_AVERAGE || type == FILTER_MEDIAN) {
+                filter_init(&filter, type, window);
+                for (size_t i = 0; i < CHECK_SAMPLES; i++) {
+                    if (filter_update(&filter, input[i]) != reference(type, input, i, window)) {
+                        mismatches++;
+                    }
+                }
+            }
+
+            // A constant input must come back out unchanged, or removed by the DC blocker:
+            int32_t dc = dc_out(type, window, 3000);
+            if (dc != (type == FILTER_DC_BLOCK ? 0 : 3000)) mismatches++;
+
+            failures += mismatches;
+
+            printf(
+                "%s,%u,%.2f,%d,%d,%d,%.3f,%d\n",
+                filter_type_str(type),
+                window,
+                ns,
+                dc,
+                step_lag(type, window),
+                spike_out(type, window),
+                noise_gain(type, window, input),
+                mismatches
+            );
+        }
+    }
+
+    free(input);
+    return failures > 0 ? 1 : 0;
+}
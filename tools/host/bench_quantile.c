@@ -0,0 +1,133 @@
+#include "host.h"
+#include "pressure_calibration.h"
+#include "util/quantile.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_SAMPLES 200000
+#define FULL_SCALE 4095
+
+// Largest allowed error of an estimate, as a fraction of full scale.
+#define MAX_ERROR 0.01
+
+static int compare_float(const void* a, const void* b) {
+    float x = *(const float*)a, y = *(const float*)b;
+    return (x > y) - (x < y);
+}
+
+static double uniform(unsigned int* seed) {
+    return (double)rand_r(seed) / RAND_MAX;
+}
+
+// Distributions over 0 - FULL_SCALE:
+
+static float dist_uniform(unsigned int* seed, size_t i) {
+    return uniform(seed) * FULL_SCALE;
+}
+
+static float dist_normal(unsigned int* seed, size_t i) {
+    double sum = 0;
+    for (int j = 0; j < 4; j++) sum += uniform(seed);
+    return sum / 4 * FULL_SCALE;
+}
+
+// Like pressure: a resting level with occasional tall contractions, and slow drift.
+static float dist_pressure(unsigned int* seed, size_t i) {
+    double rest = 1800 + 200 * sin(i / 20000.0) + 30 * uniform(seed);
+    double contraction = uniform(seed) < 0.1 ? uniform(seed) * 1500 : 0;
+    return rest + contraction;
+}
+
+static const struct {
+    const char* name;
+    float (*sample)(unsigned int* seed, size_t i);
+} dists[] = {
+    { "uniform", dist_uniform },
+    { "normal", dist_normal },
+    { "pressure", dist_pressure },
+};
+
+// Sensor sensitivity scales the pressure signal; see how calibration settles from a bad start.
+static int calibrate(uint8_t sensitivity) {
+    pressure_calibration_t cal;
+    unsigned int seed = 7;
+    size_t period = 50 * (PRESSURE_CALIBRATION_PERIOD_MS / 1000);
+    size_t i = 0;
+
+    printf("calibration from %u:", sensitivity);
+
+    for (int round = 0; round < 20; round++) {
+        pressure_calibration_init(&cal);
+
+        for (size_t n = 0; n < period; n++, i++) {
+            float p = dist_pressure(&seed, i) * sensitivity / 128;
+            pressure_calibration_add(&cal, p > FULL_SCALE ? FULL_SCALE : p);
+        }
+
+        sensitivity = pressure_calibration_suggest(&cal, sensitivity, FULL_SCALE);
+        printf(" %u", sensitivity);
+    }
+
+    float high = quantile_get(&cal.high);
+    float median = quantile_get(&cal.median);
+    printf(", p50 %.0f%%, p95 %.0f%%\n", median * 100 / FULL_SCALE, high * 100 / FULL_SCALE);
+
+    // Settled with headroom, and not stuck far below the target:
+    if (high > FULL_SCALE * (PRESSURE_CALIBRATION_HIGH + PRESSURE_CALIBRATION_DEADBAND)) return 1;
+    if (median < FULL_SCALE * PRESSURE_CALIBRATION_MEDIAN * 0.5f) return 1;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    static const float ps[] = { 0.05f, 0.50f, 0.95f };
+    float* samples = malloc(sizeof(float) * BENCH_SAMPLES);
+    int failures = 0;
+
+    printf("distribution,p,ns_per_sample,exact,estimate,error\n");
+
+    for (size_t d = 0; d < sizeof(dists) / sizeof(dists[0]); d++) {
+        unsigned int seed = 1;
+
+        for (size_t i = 0; i < BENCH_SAMPLES; i++) {
+            samples[i] = dists[d].sample(&seed, i);
+        }
+
+        for (size_t k = 0; k < sizeof(ps) / sizeof(ps[0]); k++) {
+            quantile_t q;
+            quantile_init(&q, ps[k]);
+
+            double start = host_now_ns();
+            for (size_t i = 0; i < BENCH_SAMPLES; i++) {
+                quantile_add(&q, samples[i]);
+            }
+            double ns = (host_now_ns() - start) / BENCH_SAMPLES;
+
+            float* sorted = malloc(sizeof(float) * BENCH_SAMPLES);
+            for (size_t i = 0; i < BENCH_SAMPLES; i++) sorted[i] = samples[i];
+            qsort(sorted, BENCH_SAMPLES, sizeof(float), compare_float);
+            float exact = sorted[(size_t)(ps[k] * (BENCH_SAMPLES - 1))];
+            free(sorted);
+
+            double error = fabs(quantile_get(&q) - exact) / FULL_SCALE;
+            if (error > MAX_ERROR) failures++;
+
+            printf(
+                "%s,%.2f,%.2f,%.0f,%.0f,%.4f\n",
+                dists[d].name,
+                ps[k],
+                ns,
+                exact,
+                quantile_get(&q),
+                error
+            );
+        }
+    }
+
+    failures += calibrate(40);
+    failures += calibrate(255);
+    failures += calibrate(128);
+
+    free(samples);
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,330 @@
+#include "config.h"
+#include "eom-hal.h"
+#include "host.h"
+#include "orgasm_control.h"
+#include "session.h"
+#include "session_record.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TICK_MS 20
+#define SESSION_SAMPLES (30 * 60 * 1000 / TICK_MS)
+#define BENCH_ROUNDS 10
+
+// Half an hour of automatic control, as the logger would see it.
+static void make_session(orgasm_control_sample_t* samples, size_t n) {
+    uint32_t seed = 1;
+
+    host_config_reset();
+    Config.max_additional_delay = 0;
+    Config.clench_detector_in_edging = true;
+
+    orgasm_control_set_clock(host_get_time_ms);
+    host_set_time_ms(60000);
+    eom_hal_set_motor_speed(0);
+    orgasm_control_init();
+    orgasm_control_set_output_mode(OC_AUTOMAITC_CONTROL);
+
+    for (size_t i = 0; i < n; i++) {
+        host_set_time_ms(60000 + i * TICK_MS);
+        orgasm_control_update_pressure(host_bench_pressure(i, 150, 30, &seed));
+        orgasm_control_get_latest_sample(&samples[i]);
+        samples[i].millis -= 60000;
+    }
+}
+
+// Every field jumping around its range, with the odd threshold change or pause too large for a
+// record, so some blocks end early.
+static void make_noise(orgasm_control_sample_t* samples, size_t n) {
+    unsigned int seed = 5;
+    unsigned long millis = 0;
+    int threshold = 600;
+
+    for (size_t i = 0; i < n; i++) {
+        millis += rand_r(&seed) % 500 == 0 ? 70000 : TICK_MS;
+        if (rand_r(&seed) % 100 == 0) threshold = rand_r(&seed) % 100000 - 50000;
+
+        samples[i] = (orgasm_control_sample_t){
+            .millis = millis,
+            .pressure = rand_r(&seed) % 4096,
+            .avg_pressure = rand_r(&seed) % 4096,
+            .arousal = rand_r(&seed) % 1024,
+            .motor_speed = rand_r(&seed),
+            .denial_count = i / 100,
+            .sensitivity_threshold = threshold,
+            .clench_pressure_threshold = rand_r(&seed) % 4096,
+            .clench_duration = rand_r(&seed) % 200,
+            .shadow_arousal = rand_r(&seed) % 1024,
+            .shadow_denial_count = i / 50,
+        };
+    }
+}
+
+static bool sample_equal(const orgasm_control_sample_t* a, const orgasm_control_sample_t* b) {
+    return a->millis == b->millis && a->pressure == b->pressure &&
+           a->avg_pressure == b->avg_pressure && a->arousal == b->arousal &&
+           a->motor_speed == b->motor_speed && a->denial_count == b->denial_count &&
+           a->sensitivity_threshold == b->sensitivity_threshold &&
+           a->clench_pressure_threshold == b->clench_pressure_threshold &&
+           a->clench_duration == b->clench_duration && a->shadow_arousal == b->shadow_arousal &&
+           a->shadow_denial_count == b->shadow_denial_count;
+}
+
+// A recording off the device, which carries everything but the denial counts and shadow arousal.
+static orgasm_control_sample_t* load_recording(const char* path, size_t* n) {
+    session_t session;
+
+    if (session_load(&session, path) != 0) {
+        fprintf(stderr, "%s: can't load recording\n", path);
+        return NULL;
+    }
+
+    orgasm_control_sample_t* samples = calloc(session.count, sizeof(orgasm_control_sample_t));
+
+    for (size_t i = 0; i < session.count; i++) {
+        const session_sample_t* row = &session.samples[i];
+        samples[i] = (orgasm_control_sample_t){
+            .millis = row->millis,
+            .pressure = row->pressure,
+            .avg_pressure = row->avg_pressure,
+            .arousal = row->arousal,
+            .motor_speed = row->motor_speed,
+            .sensitivity_threshold = row->sensitivity_threshold,
+            .clench_pressure_threshold = row->clench_pressure_threshold,
+            .clench_duration = row->clench_duration,
+        };
+    }
+
+    *n = session.count;
+    session_free(&session);
+    return samples;
+}
+
+static size_t encode(const orgasm_control_sample_t* samples, size_t n, uint8_t* out) {
+    static uint8_t block[SESSION_RECORD_BLOCK_SIZE];
+    session_record_encoder_t encoder;
+    size_t blocks = 0;
+
+    if (session_record_encoder_init(&encoder, block) != 0) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        if (!session_record_add(&encoder, &samples[i])) {
+            memcpy(out + blocks++ * SESSION_RECORD_BLOCK_SIZE, block, SESSION_RECORD_BLOCK_SIZE);
+            session_record_next_block(&encoder);
+            session_record_add(&encoder, &samples[i]);
+        }
+    }
+
+    if (!session_record_empty(&encoder)) {
+        session_record_finish(&encoder);
+        memcpy(out + blocks++ * SESSION_RECORD_BLOCK_SIZE, block, SESSION_RECORD_BLOCK_SIZE);
+    }
+
+    session_record_encoder_free(&encoder);
+    return blocks;
+}
+
+static int format_csv(char* buf, size_t len, const orgasm_control_sample_t* sample) {
+    return snprintf(
+        buf,
+        len,
+        "%ld,%d,%d,%d,%d,%d,%ld,%d,%d,%d\n",
+        sample->millis,
+        sample->pressure,
+        sample->avg_pressure,
+        sample->arousal,
+        sample->motor_speed,
+        sample->sensitivity_threshold,
+        sample->clench_pressure_threshold,
+        sample->clench_duration,
+        sample->shadow_arousal,
+        sample->shadow_denial_count
+    );
+}
+
+// The last block starting at or before millis, by binary search over the blocks' first samples.
+static size_t find_block(const uint8_t* blocks, size_t count, uint32_t millis) {
+    size_t lo = 0, hi = count;
+
+    while (hi - lo > 1) {
+        size_t mid = (lo + hi) / 2;
+        uint32_t first;
+
+        if (session_record_block_millis(blocks + mid * SESSION_RECORD_BLOCK_SIZE, &first) == 0 &&
+            first <= millis) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+static int run(
+    const char* name, const orgasm_control_sample_t* samples, size_t n, const char* out_path
+) {
+    static orgasm_control_sample_t decoded[SESSION_RECORD_MAX_SAMPLES];
+    uint8_t* blocks = malloc(SESSION_RECORD_BLOCK_SIZE * n);
+    size_t* block_start = malloc(sizeof(size_t) * n);
+    size_t block_count = 0, at = 0, csv_bytes = 0;
+    int failures = 0;
+    char row[128];
+
+    double t0 = host_now_ns();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        block_count = encode(samples, n, blocks);
+    }
+    double encode_ns = (host_now_ns() - t0) / ((double)n * BENCH_ROUNDS);
+
+    t0 = host_now_ns();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        csv_bytes = 0;
+        for (size_t i = 0; i < n; i++) {
+            csv_bytes += format_csv(row, sizeof(row), &samples[i]);
+        }
+    }
+    double csv_ns = (host_now_ns() - t0) / ((double)n * BENCH_ROUNDS);
+
+    t0 = host_now_ns();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        for (size_t b = 0; b < block_count; b++) {
+            session_record_decode(blocks + b * SESSION_RECORD_BLOCK_SIZE, decoded, NULL);
+        }
+    }
+    double decode_ns = (host_now_ns() - t0) / ((double)n * BENCH_ROUNDS);
+
+    // Every block decodes on its own, in order, back to exactly what went in:
+    for (size_t b = 0; b < block_count; b++) {
+        uint32_t seq;
+        int count = session_record_decode(blocks + b * SESSION_RECORD_BLOCK_SIZE, decoded, &seq);
+
+        if (count < 0 || seq != b || at + count > n) {
+            failures++;
+            break;
+        }
+
+        block_start[b] = at;
+        for (int i = 0; i < count; i++, at++) {
+            if (!sample_equal(&decoded[i], &samples[at])) failures++;
+        }
+    }
+    if (at != n) failures++;
+
+    // Any moment is found without decoding the blocks before it:
+    for (size_t i = 0; failures == 0 && i < n; i += n / 97 + 1) {
+        size_t b = find_block(blocks, block_count, samples[i].millis);
+        size_t end = b + 1 < block_count ? block_start[b + 1] : n;
+
+        if (samples[block_start[b]].millis > samples[i].millis ||
+            (end < n && samples[end].millis <= samples[i].millis)) {
+            failures++;
+        }
+    }
+
+    if (out_path != NULL) {
+        static uint8_t header[SESSION_RECORD_BLOCK_SIZE];
+        FILE* out = fopen(out_path, "wb");
+
+        if (out == NULL) {
+            perror(out_path);
+            failures++;
+        } else {
+            session_record_write_header(header, time(NULL), 1000 / TICK_MS, "{}");
+            fwrite(header, SESSION_RECORD_BLOCK_SIZE, 1, out);
+            fwrite(blocks, SESSION_RECORD_BLOCK_SIZE, block_count, out);
+            fclose(out);
+        }
+    }
+
+    // A damaged block is rejected rather than decoded into garbage:
+    blocks[0] ^= 0xFF;
+    if (session_record_decode(blocks, decoded, NULL) >= 0) failures++;
+
+    size_t binary_bytes = (block_count + 1) * SESSION_RECORD_BLOCK_SIZE;
+    printf(
+        "%s,%zu,%zu,%zu,%zu,%.3f,%.2f,%.1f,%.1f,%.1f,%s\n",
+        name,
+        n,
+        block_count,
+        csv_bytes,
+        binary_bytes,
+        (double)binary_bytes / csv_bytes,
+        (double)binary_bytes / n,
+        encode_ns,
+        decode_ns,
+        csv_ns,
+        failures > 0 ? "FAIL" : "ok"
+    );
+
+    free(blocks);
+    free(block_start);
+    return failures;
+}
+
+int main(int argc, char** argv) {
+    orgasm_control_sample_t* samples = calloc(SESSION_SAMPLES, sizeof(orgasm_control_sample_t));
+    const char* out_path = NULL;
+    int failures = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "o:h")) != -1) {
+        switch (opt) {
+        case 'o': out_path = optarg; break;
+        default:
+            fprintf(stderr, "Usage: %s [-o session.eom] [log.csv ...]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    printf(
+        "case,samples,blocks,csv_bytes,binary_bytes,ratio,bytes_per_sample,encode_ns,decode_ns,"
+        "csv_ns,result\n"
+    );
+
+    make_session(samples, SESSION_SAMPLES);
+    // The session can be written out as a recording, to try record2csv on:
+    failures += run("session", samples, SESSION_SAMPLES, out_path);
+
+    make_noise(samples, SESSION_SAMPLES);
+    failures += run("noise", samples, SESSION_SAMPLES, NULL);
+
+    // Real recordings, as far as the CSV carries them:
+    for (int i = optind; i < argc; i++) {
+        size_t n;
+        orgasm_control_sample_t* recording = load_recording(argv[i], &n);
+
+        if (recording == NULL) {
+            failures++;
+            continue;
+        }
+
+        failures += run(argv[i], recording, n, NULL);
+        free(recording);
+    }
+
+    // The file header round trips, and cuts off a config too long for it:
+    static uint8_t block[SESSION_RECORD_BLOCK_SIZE];
+    static char config[SESSION_RECORD_BLOCK_SIZE * 2];
+    session_record_file_header_t header;
+    const char* read_config;
+
+    memset(config, 'x', sizeof(config) - 1);
+    session_record_write_header(block, 1700000000, 50, config);
+
+    if (session_record_read_header(block, &header, &read_config) != 0 ||
+        header.start_time != 1700000000 || header.update_frequency_hz != 50 ||
+        strlen(read_config) != header.config_length ||
+        header.config_length + sizeof(header) >= SESSION_RECORD_BLOCK_SIZE) {
+        printf("header,FAIL\n");
+        failures++;
+    }
+
+    free(samples);
+    return failures > 0 ? 1 : 0;
+}
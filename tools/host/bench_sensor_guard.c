@@ -0,0 +1,155 @@
+#include "host.h"
+#include "sensor_guard.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define RATE_HZ 50
+#define FULL_SCALE 4095
+#define TRACE_SAMPLES (RATE_HZ * 600)
+#define BENCH_ROUNDS 20
+
+// Output further than this from the clean trace counts as a glitch getting through. The median
+// standing in for a glitch on a steep contraction lags it by a couple hundred.
+#define MAX_LEAK (FULL_SCALE * SENSOR_GUARD_MIN_DEVIATION)
+
+// Like pressure: a drifting resting level, sensor noise, and a contraction every few seconds that
+// rises over a few hundred ms.
+static void make_trace(uint16_t* trace, size_t n) {
+    unsigned int seed = 3;
+
+    for (size_t i = 0; i < n; i++) {
+        double t = (double)i / RATE_HZ;
+        double phase = fmod(t, 4.0);
+        double contraction = phase < 1.0 ? 900 * sin(M_PI * phase) : 0;
+        trace[i] = 1800 + 300 * sin(t / 60) + contraction + rand_r(&seed) % 31;
+    }
+}
+
+typedef struct result {
+    sensor_fault_t fault;
+    int raised_at;
+    int cleared_at;
+    int leaks;
+    uint32_t impulses;
+} result_t;
+
+// Runs the guard over a trace, noting the first fault raised, when it cleared, and how many
+// outputs strayed from the clean trace outside of the fault.
+static result_t run(const uint16_t* input, const uint16_t* clean, size_t n) {
+    sensor_guard_t guard;
+    result_t result = { SENSOR_FAULT_NONE, -1, -1, 0, 0 };
+
+    sensor_guard_init(&guard, FULL_SCALE, RATE_HZ);
+
+    for (size_t i = 0; i < n; i++) {
+        uint16_t out = sensor_guard_update(&guard, input[i]);
+
+        if (guard.fault != SENSOR_FAULT_NONE) {
+            if (result.raised_at < 0) {
+                result.fault = guard.fault;
+                result.raised_at = i;
+            }
+            continue;
+        }
+
+        if (result.raised_at >= 0 && result.cleared_at < 0) result.cleared_at = i;
+        if (abs(out - clean[i]) > MAX_LEAK) result.leaks++;
+    }
+
+    result.impulses = guard.impulse_count;
+    return result;
+}
+
+static int check(
+    const char* name, result_t result, sensor_fault_t fault, int start, int end, int expect_impulses
+) {
+    int failures = 0;
+
+    printf(
+        "%s,%s,%d,%d,%u,%d",
+        name,
+        sensor_fault_str(result.fault),
+        result.raised_at >= 0 ? (result.raised_at - start) * 1000 / RATE_HZ : -1,
+        result.cleared_at >= 0 ? (result.cleared_at - end) * 1000 / RATE_HZ : -1,
+        result.impulses,
+        result.leaks
+    );
+
+    if (result.fault != fault || result.leaks > 0) failures++;
+    if (expect_impulses >= 0 && result.impulses != expect_impulses) failures++;
+
+    if (fault != SENSOR_FAULT_NONE) {
+        // Raised soon after the fault starts, within the rail time or the 32 readings impulses are
+        // counted over, and cleared about SENSOR_GUARD_CLEAR_MS after it ends:
+        int raise_ms = (result.raised_at - start) * 1000 / RATE_HZ;
+        int clear_ms = (result.cleared_at - end) * 1000 / RATE_HZ;
+        int max_raise_ms =
+            fault == SENSOR_FAULT_NOISY ? 32 * 1000 / RATE_HZ : SENSOR_GUARD_RAIL_MS + 100;
+        if (raise_ms < 0 || raise_ms > max_raise_ms) failures++;
+        if (clear_ms < SENSOR_GUARD_CLEAR_MS - 1000 / RATE_HZ) failures++;
+        if (clear_ms > SENSOR_GUARD_CLEAR_MS + 500) failures++;
+    }
+
+    printf(",%s\n", failures > 0 ? "FAIL" : "ok");
+    return failures;
+}
+
+int main(int argc, char** argv) {
+    uint16_t* clean = malloc(sizeof(uint16_t) * TRACE_SAMPLES);
+    uint16_t* input = malloc(sizeof(uint16_t) * TRACE_SAMPLES);
+    int start = RATE_HZ * 100, end = RATE_HZ * 103;
+    int failures = 0;
+
+    make_trace(clean, TRACE_SAMPLES);
+
+    printf("case,fault,raised_after_ms,cleared_after_ms,impulses,leaks,result\n");
+
+    // Clean pressure goes through untouched:
+    failures += check("clean", run(clean, clean, TRACE_SAMPLES), SENSOR_FAULT_NONE, 0, 0, 0);
+
+    // A single glitch to either rail every 5 seconds is replaced, without raising a fault:
+    int glitches = 0;
+    for (size_t i = 0; i < TRACE_SAMPLES; i++) {
+        bool glitch = i % (RATE_HZ * 5) == RATE_HZ * 2;
+        input[i] = glitch ? (glitches++ % 2 ? 0 : FULL_SCALE) : clean[i];
+    }
+    result_t spikes = run(input, clean, TRACE_SAMPLES);
+    failures += check("spikes", spikes, SENSOR_FAULT_NONE, 0, 0, glitches);
+
+    // Unplugged, then saturated, for 3 seconds:
+    for (size_t i = 0; i < TRACE_SAMPLES; i++) {
+        input[i] = i >= start && i < end ? 0 : clean[i];
+    }
+    result_t disconnected = run(input, clean, TRACE_SAMPLES);
+    failures += check("disconnected", disconnected, SENSOR_FAULT_DISCONNECTED, start, end, -1);
+
+    for (size_t i = 0; i < TRACE_SAMPLES; i++) {
+        input[i] = i >= start && i < end ? FULL_SCALE : clean[i];
+    }
+    result_t saturated = run(input, clean, TRACE_SAMPLES);
+    failures += check("saturated", saturated, SENSOR_FAULT_SATURATED, start, end, -1);
+
+    // A loose plug, glitching every few readings for 3 seconds:
+    for (size_t i = 0; i < TRACE_SAMPLES; i++) {
+        input[i] = i >= start && i < end && i % 5 == 0 ? FULL_SCALE : clean[i];
+    }
+    result_t noisy = run(input, clean, TRACE_SAMPLES);
+    failures += check("noisy", noisy, SENSOR_FAULT_NOISY, start, end, -1);
+
+    sensor_guard_t guard;
+    volatile uint32_t sink = 0;
+    sensor_guard_init(&guard, FULL_SCALE, RATE_HZ);
+
+    double t0 = host_now_ns();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        for (size_t i = 0; i < TRACE_SAMPLES; i++) {
+            sink += sensor_guard_update(&guard, clean[i]);
+        }
+    }
+    printf("%.1f ns per reading\n", (host_now_ns() - t0) / ((double)TRACE_SAMPLES * BENCH_ROUNDS));
+
+    free(clean);
+    free(input);
+    return failures > 0 ? 1 : 0;
+}
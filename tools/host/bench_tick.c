@@ -0,0 +1,70 @@
+#include "arousal_detector.h"
+#include "config.h"
+#include "eom-hal.h"
+#include "host.h"
+#include "orgasm_control.h"
+#include "util/perf_counter.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_TICKS (1 << 20)
+
+// A contraction every three seconds, so the arousal, clench and motor ramp paths all get exercised.
+static uint16_t bench_pressure(uint32_t tick, uint32_t* seed) {
+    return host_bench_pressure(tick, 150, 30, seed);
+}
+
+// FNV-1a over everything that should be bit-exact between platforms.
+static uint32_t fnv1a(uint32_t hash, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        hash ^= (value >> (i * 8)) & 0xFF;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void bench_mode(const char* name, vibration_mode_t mode) {
+    uint32_t seed = 1;
+    uint32_t hash = 2166136261u;
+    uint64_t cycles = 0;
+
+    host_config_reset();
+    Config.vibration_mode = mode;
+    Config.max_additional_delay = 0;
+    Config.clench_detector_in_edging = true;
+
+    orgasm_control_set_clock(host_get_time_ms);
+    host_set_time_ms(60000);
+    eom_hal_set_motor_speed(0);
+    orgasm_control_init();
+    orgasm_control_set_output_mode(OC_AUTOMAITC_CONTROL);
+
+    for (uint32_t tick = 0; tick < BENCH_TICKS; tick++) {
+        host_set_time_ms(60000 + tick * 20);
+        uint16_t pressure = bench_pressure(tick, &seed);
+
+        uint32_t start = perf_counter_get();
+        orgasm_control_update_pressure(pressure);
+        cycles += perf_counter_get() - start;
+
+        hash = fnv1a(hash, orgasm_control_getArousal());
+        hash = fnv1a(hash, orgasm_control_getMotorSpeed());
+        hash = fnv1a(hash, orgasm_control_getDenialCount());
+    }
+
+    printf(
+        "%s,%u,%u,%08x\n",
+        name,
+        perf_counter_to_ns(cycles / BENCH_TICKS),
+        orgasm_control_getDenialCount(),
+        hash
+    );
+}
+
+int main(int argc, char** argv) {
+    printf("mode,ns_per_tick,denials,checksum\n");
+    bench_mode("RampStop", RampStop);
+    bench_mode("Depletion", Depletion);
+    bench_mode("Enhancement", Enhancement);
+    return 0;
+}
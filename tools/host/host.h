@@ -0,0 +1,55 @@
+#ifndef __host__host_h
+#define __host__host_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Sets the virtual clock returned by esp_timer_get_time().
+ */
+void host_set_time_ms(unsigned long ms);
+
+/**
+ * Virtual clock in milliseconds, suitable for orgasm_control_set_clock().
+ */
+unsigned long host_get_time_ms(void);
+
+/**
+ * Loads the value the next eom_hal_get_pressure_reading() call will return.
+ */
+void host_set_pressure(uint16_t pressure);
+
+/**
+ * Resets Config to the firmware defaults from src/config.c.
+ */
+void host_config_reset(void);
+
+/**
+ * Applies a single "key=value" override to Config, using config.json key names.
+ *
+ * @return false if the key is unknown or the argument is malformed.
+ */
+bool host_config_set(const char* assignment);
+
+/**
+ * Monotonic wall clock in nanoseconds, for timing benchmarks.
+ */
+double host_now_ns(void);
+
+/**
+ * Deterministic integer pressure trace for benchmarks: a resting level with noise, and a
+ * contraction every `period` ticks that rises by `height` a tick for 20 ticks, then falls back.
+ *
+ * @param seed Noise state, advanced on every call.
+ */
+uint16_t host_bench_pressure(uint32_t tick, uint32_t period, uint32_t height, uint32_t* seed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
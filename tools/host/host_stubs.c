@@ -0,0 +1,151 @@
+#include "host.h"
+#include "accessory_driver.h"
+#include "bluetooth_driver.h"
+#include "config.h"
+#include "config_defs.h"
+#include "eom-hal.h"
+#include "esp_timer.h"
+#include "system/control_snapshot.h"
+#include "ui/toast.h"
+#include "ui/ui.h"
+#include "util/i18n.h"
+#include <string.h>
+#include <time.h>
+
+static _Thread_local struct {
+    int64_t time_us;
+    uint32_t random_state;
+    uint16_t pressure;
+    uint8_t motor_speed;
+} host_state;
+
+void host_set_time_ms(unsigned long ms) {
+    host_state.time_us = (int64_t)ms * 1000LL;
+}
+
+unsigned long host_get_time_ms(void) {
+    return host_state.time_us / 1000LL;
+}
+
+void host_set_pressure(uint16_t pressure) {
+    host_state.pressure = pressure;
+}
+
+void host_config_reset(void) {
+    config_load_default(&Config);
+}
+
+bool host_config_set(const char* assignment) {
+    char key[64];
+    const char* eq = strchr(assignment, '=');
+
+    if (eq == NULL || eq == assignment || (size_t)(eq - assignment) >= sizeof(key)) {
+        return false;
+    }
+
+    memcpy(key, assignment, eq - assignment);
+    key[eq - assignment] = '\0';
+    return _config_defs(CFG_SET, NULL, &Config, key, eq + 1, NULL, 0, NULL);
+}
+
+long host_random(void) {
+    // xorshift32, kept per thread.
+    uint32_t x = host_state.random_state ? host_state.random_state : 1;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    host_state.random_state = x;
+    return (long)(x & 0x7FFFFFFF);
+}
+
+void host_srandom(unsigned int seed) {
+    host_state.random_state = seed;
+}
+
+double host_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+uint16_t host_bench_pressure(uint32_t tick, uint32_t period, uint32_t height, uint32_t* seed) {
+    *seed = *seed * 1103515245u + 12345u;
+    uint32_t noise = (*seed >> 16) % 17;
+    uint32_t phase = tick % period;
+    uint32_t contraction = phase < 40 ? (phase < 20 ? phase * height : (40 - phase) * height) : 0;
+    return 1500 + contraction + noise;
+}
+
+// Config
+
+void config_load_default(config_t* cfg) {
+    _config_defs(CFG_SET, NULL, cfg, NULL, NULL, NULL, 0, NULL);
+}
+
+void config_enqueue_save(long save_at_ms) {
+}
+
+bool atob(const char* a) {
+    return !(
+        strcasecmp(a, "false") == 0 || strcasecmp(a, "no") == 0 || strcasecmp(a, "off") == 0 ||
+        strcasecmp(a, "0") == 0
+    );
+}
+
+// HAL
+
+int64_t esp_timer_get_time(void) {
+    return host_state.time_us;
+}
+
+uint16_t eom_hal_get_pressure_reading(void) {
+    return host_state.pressure;
+}
+
+void eom_hal_set_motor_speed(uint8_t speed) {
+    host_state.motor_speed = speed;
+}
+
+uint8_t eom_hal_get_motor_speed(void) {
+    return host_state.motor_speed;
+}
+
+void eom_hal_set_encoder_rgb(uint8_t r, uint8_t g, uint8_t b) {
+}
+
+void eom_hal_set_sensor_sensitivity(uint8_t sensitivity) {
+}
+
+// Snapshots never resume on the host, so every replay starts clean.
+bool control_snapshot_load(orgasm_control_snapshot_t* snapshot) {
+    return false;
+}
+
+// Accessories
+
+void accessory_driver_broadcast_speed(uint8_t speed) {
+}
+
+void accessory_driver_broadcast_arousal(uint16_t arousal) {
+}
+
+void bluetooth_driver_broadcast_speed(uint8_t speed) {
+}
+
+void bluetooth_driver_broadcast_arousal(uint16_t arousal) {
+}
+
+// UI
+
+void ui_set_icon(ui_icon_t icon, int8_t state) {
+}
+
+void ui_toast(const char* fmt, ...) {
+}
+
+void ui_toast_blocking(const char* fmt, ...) {
+}
+
+const char* _(const char* str) {
+    return str;
+}
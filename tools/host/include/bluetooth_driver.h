@@ -0,0 +1,17 @@
+#ifndef __host__bluetooth_driver_h
+#define __host__bluetooth_driver_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+void bluetooth_driver_broadcast_speed(uint8_t speed);
+void bluetooth_driver_broadcast_arousal(uint16_t arousal);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef __host__config_defs_h
+#define __host__config_defs_h
+
+/**
+ * Host replacement for config_defs.h. The real CONFIG_DEFS table in src/config.c is compiled
+ * against these macros, so the host tools share the firmware defaults and key names without
+ * pulling in cJSON. Calling _config_defs() with CFG_SET and no key loads every default; with a key
+ * it behaves like set_config_value().
+ */
+
+#include "config.h"
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum _config_def_operation {
+    CFG_GET,
+    CFG_SET,
+    CFG_MERGE,
+};
+
+#define CONFIG_DEFS                                                                                \
+    bool _config_defs(                                                                             \
+        enum _config_def_operation operation,                                                      \
+        void* root,                                                                                \
+        config_t* cfg,                                                                             \
+        const char* key,                                                                           \
+        const char* in_val,                                                                        \
+        char* out_val,                                                                             \
+        size_t len,                                                                                \
+        bool* restart_required                                                                     \
+    )
+
+#define _CFG_HOST(name, set_default, set_value, get_value)                                         \
+    {                                                                                              \
+        if (key == NULL) {                                                                         \
+            if (operation == CFG_SET) set_default;                                                 \
+        } else if (!strcasecmp(key, #name)) {                                                      \
+            if (operation == CFG_GET) {                                                            \
+                if (out_val != NULL) get_value;                                                    \
+            } else if (in_val != NULL) {                                                           \
+                set_value;                                                                         \
+            }                                                                                      \
+            return true;                                                                           \
+        }                                                                                          \
+    }
+
+#define CFG_STRING(name, default)                                                                  \
+    _CFG_HOST(                                                                                     \
+        name,                                                                                      \
+        snprintf(cfg->name, sizeof(cfg->name), "%s", default),                                     \
+        snprintf(cfg->name, sizeof(cfg->name), "%s", in_val),                                      \
+        snprintf(out_val, len, "%s", cfg->name)                                                    \
+    )
+
+#define CFG_STRING_PTR(name, default)                                                              \
+    _CFG_HOST(                                                                                     \
+        name,                                                                                      \
+        cfg->name = (char*)default,                                                                \
+        cfg->name = strdup(in_val),                                                                \
+        snprintf(out_val, len, "%s", cfg->name)                                                    \
+    )
+
+#define CFG_NUMBER(name, default)                                                                  \
+    _CFG_HOST(                                                                                     \
+        name,                                                                                      \
+        cfg->name = default,                                                                       \
+        cfg->name = atoi(in_val),                                                                  \
+        snprintf(out_val, len, "%d", (int)cfg->name)                                               \
+    )
+
+#define CFG_ENUM(name, type, default)                                                              \
+    _CFG_HOST(                                                                                     \
+        name,                                                                                      \
+        cfg->name = default,                                                                       \
+        cfg->name = (type)atoi(in_val),                                                            \
+        snprintf(out_val, len, "%d", (int)cfg->name)                                               \
+    )
+
+#define CFG_BOOL(name, default)                                                                    \
+    _CFG_HOST(                                                                                     \
+        name,                                                                                      \
+        cfg->name = default,                                                                       \
+        cfg->name = atob(in_val),                                                                  \
+        snprintf(out_val, len, "%s", cfg->name ? "true" : "false")                                 \
+    )
+
+bool atob(const char* a);
+CONFIG_DEFS;
+
+void config_load_default(config_t* cfg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
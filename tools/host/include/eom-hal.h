@@ -0,0 +1,27 @@
+#ifndef __host__eom_hal_h
+#define __host__eom_hal_h
+
+/**
+ * Host stand-in for the eom-hal component. Only the calls made by the control path are provided;
+ * pressure readings come from whatever the harness last loaded with host_set_pressure().
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define EOM_HAL_PRESSURE_MAX 4095
+
+uint16_t eom_hal_get_pressure_reading(void);
+void eom_hal_set_motor_speed(uint8_t speed);
+uint8_t eom_hal_get_motor_speed(void);
+void eom_hal_set_encoder_rgb(uint8_t r, uint8_t g, uint8_t b);
+void eom_hal_set_sensor_sensitivity(uint8_t sensitivity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef __host__esp_cpu_h
+#define __host__esp_cpu_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * Stands in for the CPU cycle counter with the monotonic clock in nanoseconds. Paired with the
+ * 1000MHz CPU frequency in sdkconfig.h, so perf counter cycles read as nanoseconds on host.
+ */
+static inline uint32_t esp_cpu_get_ccount(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef __host__esp_log_h
+#define __host__esp_log_h
+
+// Logging is compiled out on host so replay throughput isn't bound by stdio.
+
+#define ESP_LOGE(tag, fmt, ...) ((void)(tag))
+#define ESP_LOGW(tag, fmt, ...) ((void)(tag))
+#define ESP_LOGI(tag, fmt, ...) ((void)(tag))
+#define ESP_LOGD(tag, fmt, ...) ((void)(tag))
+#define ESP_LOGV(tag, fmt, ...) ((void)(tag))
+
+#endif
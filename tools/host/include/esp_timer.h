@@ -0,0 +1,20 @@
+#ifndef __host__esp_timer_h
+#define __host__esp_timer_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/**
+ * Returns the virtual clock in microseconds, for firmware code that reads esp_timer directly. The
+ * control loop itself is handed host_get_time_ms() through orgasm_control_set_clock().
+ */
+int64_t esp_timer_get_time(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
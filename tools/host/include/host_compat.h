@@ -0,0 +1,31 @@
+#ifndef __host__host_compat_h
+#define __host__host_compat_h
+
+/**
+ * Force-included into every host translation unit. Maps the newlib-only helpers the firmware uses
+ * onto their glibc equivalents, and makes the control state thread-local.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+
+#define sniprintf snprintf
+#define asiprintf asprintf
+
+// One detector per thread. random() gets a per-thread sequence as well, so a parallel run picks the
+// same additional edge delays as a serial one.
+#define CONTROL_LOCAL _Thread_local
+
+// The clock standing in for the cycle counter is too slow to time every control stage.
+#define PERF_STATS_ENABLED 0
+
+long host_random(void);
+void host_srandom(unsigned int seed);
+
+#define random host_random
+#define srandom host_srandom
+
+#endif
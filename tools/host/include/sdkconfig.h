@@ -0,0 +1,9 @@
+#ifndef __host__sdkconfig_h
+#define __host__sdkconfig_h
+
+// Only the options the host build of the control loop reads.
+
+// Perf counter cycles are nanoseconds on host. See esp_cpu.h.
+#define CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ 1000
+
+#endif
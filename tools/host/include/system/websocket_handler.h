@@ -0,0 +1,6 @@
+#ifndef __host__websocket_handler_h
+#define __host__websocket_handler_h
+
+// Nothing in the control path talks to the websocket server directly.
+
+#endif
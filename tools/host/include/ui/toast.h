@@ -0,0 +1,17 @@
+#ifndef __host__ui__toast_h
+#define __host__ui__toast_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ui/ui.h"
+
+void ui_toast(const char* fmt, ...);
+void ui_toast_blocking(const char* fmt, ...);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef __host__ui__ui_h
+#define __host__ui__ui_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+typedef enum ui_icon {
+    UI_ICON_NONE,
+    UI_ICON_RECORD,
+} ui_icon_t;
+
+#define RECORD_ICON_RECORDING 0
+
+void ui_set_icon(ui_icon_t icon, int8_t state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
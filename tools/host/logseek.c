@@ -0,0 +1,139 @@
+#include "session_index.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static void usage(const char* argv0) {
+    fprintf(
+        stderr,
+        "Usage: %s [options] log.idx [millis]\n"
+        "\n"
+        "Lists a recording's seek index, or with millis, prints the segment and byte offset\n"
+        "holding that moment.\n"
+        "\n"
+        "  -p            Print a CSV recording from that moment on instead.\n",
+        argv0
+    );
+}
+
+// Prints the CSV header, then the rows from offset on, through to the last segment.
+static int print_from(const char* base, const char* suffix, uint16_t segment, long offset) {
+    char path[512];
+    char buf[4096];
+    size_t n;
+
+    for (int first = 1;; segment++, offset = 0, first = 0) {
+        session_index_segment_path(path, sizeof(path), base, segment, suffix);
+        FILE* in = fopen(path, "rb");
+
+        if (in == NULL) {
+            if (first) perror(path);
+            return first;
+        }
+
+        // Every segment starts with the same header:
+        if (fgets(buf, sizeof(buf), in) != NULL && first) {
+            fputs(buf, stdout);
+        }
+
+        if (offset > 0) {
+            fseek(in, offset, SEEK_SET);
+        }
+
+        while ((n = fread(buf, 1, sizeof(buf), in)) > 0) {
+            fwrite(buf, 1, n, stdout);
+        }
+        fclose(in);
+    }
+}
+
+int main(int argc, char** argv) {
+    int print = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "ph")) != -1) {
+        switch (opt) {
+        case 'p': print = 1; break;
+        default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (optind >= argc || argc - optind > 2) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const char* idx_path = argv[optind];
+    FILE* in = fopen(idx_path, "rb");
+    if (in == NULL) {
+        perror(idx_path);
+        return 1;
+    }
+
+    session_index_header_t header;
+    if (fread(&header, sizeof(header), 1, in) != 1 || header.magic != SESSION_INDEX_MAGIC ||
+        header.version != SESSION_INDEX_VERSION ||
+        header.entry_size != sizeof(session_index_entry_t)) {
+        fprintf(stderr, "%s: not a version %d index\n", idx_path, SESSION_INDEX_VERSION);
+        fclose(in);
+        return 1;
+    }
+
+    session_index_entry_t* entries = NULL;
+    size_t count = 0, capacity = 0;
+
+    for (;;) {
+        if (count == capacity) {
+            capacity = capacity == 0 ? 1024 : capacity * 2;
+            entries = realloc(entries, capacity * sizeof(session_index_entry_t));
+        }
+
+        if (fread(&entries[count], sizeof(session_index_entry_t), 1, in) != 1) break;
+        count++;
+    }
+    fclose(in);
+
+    // Segments are named for the index, less its .idx:
+    char base[512];
+    snprintf(base, sizeof(base), "%s", idx_path);
+    char* ext = strrchr(base, '.');
+    if (ext != NULL && strcmp(ext, ".idx") == 0) *ext = '\0';
+    const char* suffix = header.format == 1 ? ".eom" : ".csv";
+    char path[512];
+
+    if (argc - optind == 1) {
+        printf("millis,segment,file,offset\n");
+
+        for (size_t i = 0; i < count; i++) {
+            session_index_segment_path(path, sizeof(path), base, entries[i].segment, suffix);
+            printf("%u,%u,%s,%u\n", entries[i].millis, entries[i].segment, path, entries[i].offset);
+        }
+
+        free(entries);
+        return 0;
+    }
+
+    if (count == 0) {
+        fprintf(stderr, "%s: empty index\n", idx_path);
+        free(entries);
+        return 1;
+    }
+
+    uint32_t millis = strtoul(argv[optind + 1], NULL, 10);
+    session_index_entry_t entry = entries[session_index_find(entries, count, millis)];
+    free(entries);
+
+    if (!print) {
+        session_index_segment_path(path, sizeof(path), base, entry.segment, suffix);
+        printf("%s %u\n", path, entry.offset);
+        return 0;
+    }
+
+    if (header.format == 1) {
+        fprintf(stderr, "Binary recordings convert from a moment with record2csv -f.\n");
+        return 1;
+    }
+
+    return print_from(base, suffix, entry.segment, entry.offset);
+}
@@ -0,0 +1,137 @@
+#include "pool.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+typedef struct pool_worker {
+    pthread_mutex_t lock;
+    size_t next;
+    size_t end;
+} pool_worker_t;
+
+typedef struct pool {
+    pool_worker_t* workers;
+    int count;
+    pool_job_func_t func;
+    void* arg;
+} pool_t;
+
+typedef struct pool_thread {
+    pool_t* pool;
+    int index;
+} pool_thread_t;
+
+static int take(pool_worker_t* worker, size_t* job) {
+    int ok = 0;
+
+    pthread_mutex_lock(&worker->lock);
+    if (worker->next < worker->end) {
+        *job = worker->next++;
+        ok = 1;
+    }
+    pthread_mutex_unlock(&worker->lock);
+
+    return ok;
+}
+
+static int steal(pool_t* pool, int self) {
+    pool_worker_t* me = &pool->workers[self];
+
+    for (;;) {
+        int victim = -1;
+        size_t best = 0;
+
+        // Pick a victim; its slice is re-checked when stealing since it may have moved on.
+        for (int i = 0; i < pool->count; i++) {
+            if (i == self) continue;
+
+            pool_worker_t* w = &pool->workers[i];
+            pthread_mutex_lock(&w->lock);
+            size_t left = w->end > w->next ? w->end - w->next : 0;
+            pthread_mutex_unlock(&w->lock);
+
+            if (left > best) {
+                best = left;
+                victim = i;
+            }
+        }
+
+        if (victim < 0) return 0;
+
+        pool_worker_t* w = &pool->workers[victim];
+        size_t start = 0, end = 0;
+
+        pthread_mutex_lock(&w->lock);
+        if (w->end > w->next) {
+            size_t left = w->end - w->next;
+            end = w->end;
+            start = w->end - (left + 1) / 2;
+            w->end = start;
+        }
+        pthread_mutex_unlock(&w->lock);
+
+        if (end > start) {
+            pthread_mutex_lock(&me->lock);
+            me->next = start;
+            me->end = end;
+            pthread_mutex_unlock(&me->lock);
+            return 1;
+        }
+    }
+}
+
+static void* worker_main(void* arg) {
+    pool_thread_t* thread = (pool_thread_t*)arg;
+    pool_t* pool = thread->pool;
+    pool_worker_t* me = &pool->workers[thread->index];
+    size_t job;
+
+    do {
+        while (take(me, &job)) {
+            pool->func(job, pool->arg);
+        }
+    } while (steal(pool, thread->index));
+
+    return NULL;
+}
+
+int pool_default_threads(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+void pool_run(size_t jobs, int threads, pool_job_func_t func, void* arg) {
+    if (threads <= 0) threads = pool_default_threads();
+    if ((size_t)threads > jobs) threads = jobs > 0 ? (int)jobs : 1;
+
+    pool_t pool = {
+        .workers = calloc(threads, sizeof(pool_worker_t)),
+        .count = threads,
+        .func = func,
+        .arg = arg,
+    };
+
+    pthread_t* handles = calloc(threads, sizeof(pthread_t));
+    pool_thread_t* args = calloc(threads, sizeof(pool_thread_t));
+
+    for (int i = 0; i < threads; i++) {
+        pthread_mutex_init(&pool.workers[i].lock, NULL);
+        pool.workers[i].next = jobs * i / threads;
+        pool.workers[i].end = jobs * (i + 1) / threads;
+    }
+
+    for (int i = 0; i < threads; i++) {
+        args[i].pool = &pool;
+        args[i].index = i;
+        pthread_create(&handles[i], NULL, worker_main, &args[i]);
+    }
+
+    for (int i = 0; i < threads; i++) {
+        pthread_join(handles[i], NULL);
+        pthread_mutex_destroy(&pool.workers[i].lock);
+    }
+
+    free(args);
+    free(handles);
+    free(pool.workers);
+}
@@ -0,0 +1,33 @@
+#ifndef __host__pool_h
+#define __host__pool_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+typedef void (*pool_job_func_t)(size_t job, void* arg);
+
+/**
+ * Runs func(job, arg) for every job in [0, jobs) on a work-stealing pool.
+ *
+ * Each worker starts with a contiguous slice of the job range and takes jobs from the front of it.
+ * A worker that runs dry steals the back half of the largest remaining slice, so uneven job costs
+ * (sessions of different length, parameters that change how often the motor restarts) still keep
+ * every core busy until the end.
+ *
+ * @param threads Worker count, or 0 for one per online CPU.
+ */
+void pool_run(size_t jobs, int threads, pool_job_func_t func, void* arg);
+
+/**
+ * Number of online CPUs.
+ */
+int pool_default_threads(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
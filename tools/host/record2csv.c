@@ -0,0 +1,159 @@
+#include "orgasm_control.h"
+#include "session_record.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Seeks to the last block starting at or before millis. Damaged blocks sort as before everything.
+static void seek_block(FILE* in, uint32_t millis) {
+    static uint8_t block[SESSION_RECORD_BLOCK_SIZE];
+    long lo = 1, hi;
+
+    fseek(in, 0, SEEK_END);
+    hi = ftell(in) / SESSION_RECORD_BLOCK_SIZE;
+
+    while (hi - lo > 1) {
+        long mid = (lo + hi) / 2;
+        uint32_t first = 0;
+
+        fseek(in, mid * SESSION_RECORD_BLOCK_SIZE, SEEK_SET);
+        if (fread(block, sizeof(block), 1, in) == 1) {
+            session_record_block_millis(block, &first);
+        }
+
+        if (first <= millis) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    fseek(in, lo * SESSION_RECORD_BLOCK_SIZE, SEEK_SET);
+}
+
+static void usage(const char* argv0) {
+    fprintf(
+        stderr,
+        "Usage: %s [options] log.eom [log.csv]\n"
+        "\n"
+        "Converts a binary recording to the CSV the device records, to stdout or log.csv.\n"
+        "\n"
+        "  -c            Print the recording's config JSON instead.\n"
+        "  -f MILLIS     Start from this millis, found by binary search over the blocks.\n",
+        argv0
+    );
+}
+
+int main(int argc, char** argv) {
+    int print_config = 0;
+    long from_millis = -1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "cf:h")) != -1) {
+        switch (opt) {
+        case 'c': print_config = 1; break;
+        case 'f': from_millis = atol(optarg); break;
+        default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (optind >= argc || argc - optind > 2) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    FILE* in = fopen(argv[optind], "rb");
+    if (in == NULL) {
+        perror(argv[optind]);
+        return 1;
+    }
+
+    static uint8_t block[SESSION_RECORD_BLOCK_SIZE];
+    session_record_file_header_t header;
+    const char* config;
+
+    if (fread(block, sizeof(block), 1, in) != 1 ||
+        session_record_read_header(block, &header, &config) != 0) {
+        fprintf(stderr, "%s: not a recording\n", argv[optind]);
+        fclose(in);
+        return 1;
+    }
+
+    if (print_config) {
+        printf("%s\n", config);
+        fclose(in);
+        return 0;
+    }
+
+    FILE* out = argc - optind == 2 ? fopen(argv[optind + 1], "w") : stdout;
+    if (out == NULL) {
+        perror(argv[optind + 1]);
+        fclose(in);
+        return 1;
+    }
+
+    fprintf(
+        out,
+        "millis,pressure,avg_pressure,arousal,motor_speed,sensitivity_threshold,"
+        "clench_pressure_threshold,clench_duration,shadow_arousal,shadow_denial_count\n"
+    );
+
+    static orgasm_control_sample_t samples[SESSION_RECORD_MAX_SAMPLES];
+    uint32_t expect_seq = 0, seq;
+    bool first = true;
+    int damaged = 0;
+
+    if (from_millis >= 0) {
+        seek_block(in, from_millis);
+    }
+
+    while (fread(block, sizeof(block), 1, in) == 1) {
+        int count = session_record_decode(block, samples, &seq);
+
+        // Skip over damaged blocks, which only lose their own samples:
+        if (count < 0) {
+            damaged++;
+            expect_seq++;
+            continue;
+        }
+
+        // Black box dumps start wherever the ring was:
+        if (first) {
+            expect_seq = seq;
+            first = false;
+        }
+
+        if (seq != expect_seq) {
+            fprintf(stderr, "Block %u found where %u was expected\n", seq, expect_seq);
+        }
+        expect_seq = seq + 1;
+
+        for (int i = 0; i < count; i++) {
+            orgasm_control_sample_t* sample = &samples[i];
+            if ((long)sample->millis < from_millis) continue;
+
+            fprintf(
+                out,
+                "%ld,%d,%d,%d,%d,%d,%ld,%d,%d,%d\n",
+                sample->millis,
+                sample->pressure,
+                sample->avg_pressure,
+                sample->arousal,
+                sample->motor_speed,
+                sample->sensitivity_threshold,
+                sample->clench_pressure_threshold,
+                sample->clench_duration,
+                sample->shadow_arousal,
+                sample->shadow_denial_count
+            );
+        }
+    }
+
+    if (damaged > 0) {
+        fprintf(stderr, "%d damaged blocks skipped\n", damaged);
+    }
+
+    fclose(in);
+    if (out != stdout) fclose(out);
+    return damaged > 0 ? 1 : 0;
+}
@@ -0,0 +1,113 @@
+#include "replay.h"
+#include "eom-hal.h"
+#include "host.h"
+#include "shadow_detector.h"
+#include <stdlib.h>
+#include <string.h>
+
+void replay_options_default(replay_options_t* opts) {
+    opts->mode = OC_AUTOMAITC_CONTROL;
+    opts->uptime_ms = 60000;
+    opts->seed = 1;
+}
+
+void replay_session(
+    const session_t* session, const replay_options_t* opts, replay_result_t* result, FILE* out
+) {
+    uint8_t last_denials = 0;
+    uint8_t last_shadow_denials = 0;
+    uint8_t last_recorded_motor = 0;
+    long last_edge_ms = -1;
+    long predicted_ms = -1;
+
+    memset(result, 0, sizeof(replay_result_t));
+    srandom(opts->seed);
+
+    orgasm_control_set_clock(host_get_time_ms);
+    host_set_time_ms(opts->uptime_ms);
+    host_set_pressure(0);
+    eom_hal_set_motor_speed(0);
+    orgasm_control_init();
+    orgasm_control_set_output_mode(opts->mode);
+
+    if (out != NULL) {
+        fprintf(
+            out,
+            "millis,pressure,arousal,motor_speed,denial_count,recorded_arousal,"
+            "recorded_motor_speed,shadow_arousal,shadow_denial_count\n"
+        );
+    }
+
+    for (size_t i = 0; i < session->count; i++) {
+        const session_sample_t* sample = &session->samples[i];
+
+        // The control task runs one update per period, and each recorded row is one of them:
+        host_set_time_ms(opts->uptime_ms + sample->millis);
+        host_set_pressure(session->has_raw_pressure ? sample->pressure : sample->avg_pressure);
+        orgasm_control_update();
+
+        uint16_t arousal = orgasm_control_getArousal();
+        uint8_t motor_speed = eom_hal_get_motor_speed();
+
+        // denial_count is a uint8_t on device, so count wrapped deltas rather than the raw value:
+        uint8_t denials = orgasm_control_getDenialCount();
+        if (denials != last_denials) {
+            result->denials += (uint8_t)(denials - last_denials);
+            last_denials = denials;
+
+            if (last_edge_ms >= 0) {
+                double interval = sample->millis - last_edge_ms;
+                result->edge_intervals++;
+                result->edge_interval_sum_ms += interval;
+                result->edge_interval_sq_sum_ms += interval * interval;
+            }
+
+            last_edge_ms = sample->millis;
+
+            if (arousal <= Config.sensitivity_threshold) {
+                predicted_ms = sample->millis;
+            }
+        } else if (predicted_ms >= 0 && arousal > Config.sensitivity_threshold) {
+            double lead = sample->millis - predicted_ms;
+            result->early_denials++;
+            result->lead_sum_ms += lead;
+            if (lead > result->lead_max_ms) result->lead_max_ms = lead;
+            predicted_ms = -1;
+        } else if (predicted_ms >= 0 && motor_speed > 0) {
+            result->false_denials++;
+            predicted_ms = -1;
+        }
+
+        uint8_t shadow_denials = shadow_detector_get_denial_count();
+        result->shadow_denials += (uint8_t)(shadow_denials - last_shadow_denials);
+        last_shadow_denials = shadow_denials;
+
+        if (arousal > Config.sensitivity_threshold) result->ticks_over_threshold++;
+
+        if (sample->motor_speed == 0 && last_recorded_motor > 0) {
+            result->recorded_denials++;
+        }
+
+        last_recorded_motor = sample->motor_speed;
+
+        if (arousal != sample->arousal) result->arousal_mismatches++;
+        if (motor_speed != sample->motor_speed) result->motor_mismatches++;
+        result->ticks++;
+
+        if (out != NULL) {
+            fprintf(
+                out,
+                "%lu,%u,%u,%u,%d,%u,%u,%u,%d\n",
+                (unsigned long)sample->millis,
+                orgasm_control_getLastPressure(),
+                arousal,
+                motor_speed,
+                result->denials,
+                sample->arousal,
+                sample->motor_speed,
+                shadow_detector_get_arousal(),
+                result->shadow_denials
+            );
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef __host__replay_h
+#define __host__replay_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "orgasm_control.h"
+#include "session.h"
+#include <stdio.h>
+
+typedef struct replay_options {
+    // Output mode to hold for the whole session. Recordings don't carry the mode.
+    orgasm_output_mode_t mode;
+
+    // Virtual device uptime at the start of the recording. Must be larger than one update period
+    // so that the first recorded tick is not gated out.
+    unsigned long uptime_ms;
+
+    // Seed for random(), which picks the additional edge delay.
+    unsigned int seed;
+} replay_options_t;
+
+typedef struct replay_result {
+    size_t ticks;
+    size_t arousal_mismatches;
+    size_t motor_mismatches;
+    int denials;
+    int recorded_denials;
+
+    // Would-be denials of the shadow detector, when use_shadow_detector is set.
+    int shadow_denials;
+
+    // Denials made while arousal was still under sensitivity_threshold, i.e. by edge prediction.
+    // Arousal follows the recorded pressure whatever the motor does, so the tick it crosses the
+    // threshold is when the motor would have stopped without prediction. Predicted denials where
+    // it crossed before the motor restarted count as early, with the time gained as their lead.
+    // The rest were false alarms.
+    int early_denials;
+    int false_denials;
+    double lead_sum_ms;
+    double lead_max_ms;
+
+    // Ticks spent with arousal above sensitivity_threshold.
+    size_t ticks_over_threshold;
+
+    // Time between consecutive denials, for scoring edge pacing.
+    int edge_intervals;
+    double edge_interval_sum_ms;
+    double edge_interval_sq_sum_ms;
+} replay_result_t;
+
+void replay_options_default(replay_options_t* opts);
+
+/**
+ * Runs a recording through orgasm_control_update(), one update per row, under the virtual clock,
+ * using whatever is currently in Config. Per-tick rows are written to `out` if it is not NULL.
+ */
+void replay_session(
+    const session_t* session, const replay_options_t* opts, replay_result_t* result, FILE* out
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,183 @@
+#include "arousal_detector.h"
+#include "config.h"
+#include "host.h"
+#include "orgasm_control.h"
+#include "replay.h"
+#include "session.h"
+#include "shadow_detector.h"
+#include "util/perf_counter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+static void usage(const char* argv0) {
+    fprintf(
+        stderr,
+        "Usage: %s [options] log.csv [log.csv ...]\n"
+        "\n"
+        "Replays recorded sessions through the orgasm_control tick under a virtual clock.\n"
+        "\n"
+        "  -s key=value  Override a config value (config.json key names), repeatable.\n"
+        "  -m mode       Output mode to replay in (default AUTOMAITC_CONTROL).\n"
+        "  -u ms         Device uptime at recording start (default 60000).\n"
+        "  -r seed       Seed for the random additional edge delay (default 1).\n"
+        "  -o file       Write per-tick rows of the last session to this CSV.\n"
+        "  -q            Only print the totals line.\n",
+        argv0
+    );
+}
+
+static double elapsed_ms(const struct timespec* start, const struct timespec* end) {
+    return (end->tv_sec - start->tv_sec) * 1000.0 + (end->tv_nsec - start->tv_nsec) / 1000000.0;
+}
+
+int main(int argc, char** argv) {
+    replay_options_t opts;
+    const char* out_path = NULL;
+    int quiet = 0;
+    int opt;
+
+    host_config_reset();
+    replay_options_default(&opts);
+
+    while ((opt = getopt(argc, argv, "s:m:u:r:o:qh")) != -1) {
+        switch (opt) {
+        case 's':
+            if (!host_config_set(optarg)) {
+                fprintf(stderr, "Unknown config assignment: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'm':
+            opts.mode = orgasm_control_str_to_output_mode(optarg);
+            if ((int)opts.mode < 0) {
+                fprintf(stderr, "Unknown output mode: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'u': opts.uptime_ms = strtoul(optarg, NULL, 10); break;
+        case 'r': opts.seed = strtoul(optarg, NULL, 10); break;
+        case 'o': out_path = optarg; break;
+        case 'q': quiet = 1; break;
+        default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (optind >= argc) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    replay_result_t total = { 0 };
+    double total_ms = 0;
+
+    for (int i = optind; i < argc; i++) {
+        session_t session;
+        replay_result_t result;
+        struct timespec start, end;
+        FILE* out = NULL;
+
+        if (session_load(&session, argv[i]) != 0) {
+            fprintf(stderr, "Could not load session: %s\n", argv[i]);
+            return 1;
+        }
+
+        if (out_path != NULL && i == argc - 1) {
+            out = fopen(out_path, "w");
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        replay_session(&session, &opts, &result, out);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        if (out != NULL) fclose(out);
+
+        double ms = elapsed_ms(&start, &end);
+        total_ms += ms;
+        total.ticks += result.ticks;
+        total.arousal_mismatches += result.arousal_mismatches;
+        total.motor_mismatches += result.motor_mismatches;
+        total.denials += result.denials;
+        total.recorded_denials += result.recorded_denials;
+        total.shadow_denials += result.shadow_denials;
+        total.early_denials += result.early_denials;
+        total.false_denials += result.false_denials;
+        total.lead_sum_ms += result.lead_sum_ms;
+        if (result.lead_max_ms > total.lead_max_ms) total.lead_max_ms = result.lead_max_ms;
+
+        if (!quiet) {
+            printf(
+                "%s: %zu ticks%s, denials %d (recorded %d), "
+                "arousal mismatches %zu, motor mismatches %zu\n",
+                session.path,
+                result.ticks,
+                session.has_raw_pressure ? "" : " [no raw pressure column]",
+                result.denials,
+                result.recorded_denials,
+                result.arousal_mismatches,
+                result.motor_mismatches
+            );
+
+            // As the device would append it to its session log:
+            printf("session: ");
+            session_stats_write_json(orgasm_control_get_session_stats(), 0, stdout);
+        }
+
+        session_free(&session);
+    }
+
+    printf(
+        "total: %zu ticks, denials %d (recorded %d), arousal mismatches %zu, motor mismatches %zu, "
+        "%.1f ms, %.0f ticks/ms\n",
+        total.ticks,
+        total.denials,
+        total.recorded_denials,
+        total.arousal_mismatches,
+        total.motor_mismatches,
+        total_ms,
+        total_ms > 0 ? total.ticks / total_ms : 0
+    );
+
+    if (!quiet) {
+        for (int mode = DetectPeaks; mode <= DetectBaseline; mode++) {
+            const arousal_detector_stats_t* stats = arousal_detector_get_stats(mode);
+            if (stats->calls == 0) continue;
+
+            printf(
+                "detector %s: %u ticks, avg %u ns, max %u ns\n",
+                arousal_detector_get(mode)->name,
+                stats->calls,
+                perf_counter_to_ns(stats->total_cycles / stats->calls),
+                perf_counter_to_ns(stats->max_cycles)
+            );
+        }
+
+        if (Config.edge_prediction_ms > 0) {
+            printf(
+                "edge prediction: %d of %d denials early, avg lead %.0f ms, max %.0f ms, "
+                "%d false alarms\n",
+                total.early_denials,
+                total.denials,
+                total.early_denials > 0 ? total.lead_sum_ms / total.early_denials : 0,
+                total.lead_max_ms,
+                total.false_denials
+            );
+        }
+
+        if (Config.use_shadow_detector) {
+            const arousal_detector_stats_t* stats = shadow_detector_get_stats();
+
+            printf(
+                "shadow: denials %d (live %d), %u ticks, avg %u ns, max %u ns\n",
+                total.shadow_denials,
+                total.denials,
+                stats->calls,
+                stats->calls > 0 ? perf_counter_to_ns(stats->total_cycles / stats->calls) : 0,
+                perf_counter_to_ns(stats->max_cycles)
+            );
+        }
+    }
+
+    return 0;
+}
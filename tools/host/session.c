@@ -0,0 +1,85 @@
+#include "session.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SESSION_LINE_MAX 256
+
+static int parse_line(const char* line, session_sample_t* sample, bool* has_raw_pressure) {
+    long v[8];
+    int n = sscanf(
+        line, "%ld,%ld,%ld,%ld,%ld,%ld,%ld,%ld", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7]
+    );
+
+    if (n == 8) {
+        *has_raw_pressure = true;
+        sample->millis = v[0];
+        sample->pressure = v[1];
+        sample->avg_pressure = v[2];
+        sample->arousal = v[3];
+        sample->motor_speed = v[4];
+        sample->sensitivity_threshold = v[5];
+        sample->clench_pressure_threshold = v[6];
+        sample->clench_duration = v[7];
+        return 0;
+    } else if (n == 7) {
+        // Legacy rows: millis,avg_pressure,arousal,motor_speed,...
+        *has_raw_pressure = false;
+        sample->millis = v[0];
+        sample->pressure = v[1];
+        sample->avg_pressure = v[1];
+        sample->arousal = v[2];
+        sample->motor_speed = v[3];
+        sample->sensitivity_threshold = v[4];
+        sample->clench_pressure_threshold = v[5];
+        sample->clench_duration = v[6];
+        return 0;
+    }
+
+    return -1;
+}
+
+int session_load(session_t* session, const char* path) {
+    FILE* f = fopen(path, "r");
+    char line[SESSION_LINE_MAX];
+    size_t capacity = 4096;
+
+    memset(session, 0, sizeof(session_t));
+    if (f == NULL) return -1;
+
+    session->path = strdup(path);
+    session->samples = malloc(sizeof(session_sample_t) * capacity);
+    session->has_raw_pressure = true;
+
+    while (fgets(line, sizeof(line), f) != NULL) {
+        session_sample_t sample;
+        bool has_raw_pressure;
+
+        // Header. Older firmware did not terminate it, so the first row is lost on those files.
+        if (!strncmp(line, "millis", 6)) continue;
+        if (parse_line(line, &sample, &has_raw_pressure) != 0) continue;
+
+        if (session->count == capacity) {
+            capacity *= 2;
+            session->samples = realloc(session->samples, sizeof(session_sample_t) * capacity);
+        }
+
+        session->samples[session->count++] = sample;
+        session->has_raw_pressure &= has_raw_pressure;
+    }
+
+    fclose(f);
+
+    if (session->count == 0) {
+        session_free(session);
+        return -1;
+    }
+
+    return 0;
+}
+
+void session_free(session_t* session) {
+    free(session->path);
+    free(session->samples);
+    memset(session, 0, sizeof(session_t));
+}
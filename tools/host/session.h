@@ -0,0 +1,48 @@
+#ifndef __host__session_h
+#define __host__session_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * One row of a log-*.csv recording, as written by the recorder.
+ */
+typedef struct session_sample {
+    uint32_t millis;
+    uint16_t pressure;
+    uint16_t avg_pressure;
+    uint16_t arousal;
+    uint8_t motor_speed;
+    int sensitivity_threshold;
+    long clench_pressure_threshold;
+    int clench_duration;
+} session_sample_t;
+
+typedef struct session {
+    char* path;
+    session_sample_t* samples;
+    size_t count;
+
+    // Recordings made before the raw pressure column was logged only carry avg_pressure, which the
+    // replay falls back to as an approximation.
+    bool has_raw_pressure;
+} session_t;
+
+/**
+ * Loads a recording into memory.
+ *
+ * @return 0 on success, -1 if the file could not be read or contained no samples.
+ */
+int session_load(session_t* session, const char* path);
+void session_free(session_t* session);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif